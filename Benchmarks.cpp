@@ -0,0 +1,1282 @@
+// Copyright 2025 Chernykh Valentin
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "TVector.h"
+#include "TAllocators.h"
+#include "TRingBuffer.h"
+#include "TSlotMap.h"
+
+namespace BenchSystem {
+using Clock = std::chrono::high_resolution_clock;
+
+int argc = 0;
+char** argv = nullptr;
+size_t scale = 1;
+
+// Benchmarks are selected by name on the command line, all run otherwise.
+// "--quick" divides the problem sizes by 100 for smoke runs.
+bool selected(const char* name_of_bench) {
+    bool has_filter = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--quick") == 0)
+            continue;
+
+        has_filter = true;
+
+        if (std::strcmp(argv[i], name_of_bench) == 0)
+            return true;
+    }
+
+    return !has_filter;
+}
+
+void start_bench(void(*bench)(), const char* name_of_bench) {
+    if (!selected(name_of_bench))
+        return;
+
+    std::cout << "[ BENCH    ] " << name_of_bench << std::endl;
+    bench();
+    std::cout << "[     DONE ] " << name_of_bench << std::endl;
+}
+
+size_t scaled(size_t count) {
+    return count / scale > 0 ? count / scale : 1;
+}
+
+double elapsed_ns(Clock::time_point start) {
+    return static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - start).count());
+}
+
+void report(const char* label, size_t count, double ns) {
+    std::cout << "  " << label << " n=" << count << ": "
+        << ns / 1e6 << " ms, " << ns / count << " ns/op" << std::endl;
+}
+};  // namespace BenchSystem
+
+#pragma region GrowthBenchmarks
+
+template<class Growth>
+void push_back_series(const char* label, size_t max_count) {
+    for (size_t count = 1000; count <= max_count; count *= 10) {
+        size_t n = BenchSystem::scaled(count);
+        auto start = BenchSystem::Clock::now();
+        TVector<int, Growth> vec;
+
+        for (size_t i = 0; i < n; i++) {
+            vec.push_back(static_cast<int>(i));
+        }
+
+        BenchSystem::report(label, n, BenchSystem::elapsed_ns(start));
+    }
+}
+
+// Amortized push_back cost from 1K to 100M elements. The linear step is
+// quadratic, so it stops at 100K.
+void bench_push_back_growth() {
+    push_back_series<TLinearGrowth<>>("linear 15", 100000);
+    push_back_series<TGrowth1_5x>("geometric 1.5x", 100000000);
+    push_back_series<TGrowth2x>("geometric 2x", 100000000);
+    push_back_series<TPageGrowth<>>("page 2x", 100000000);
+}
+
+#pragma endregion
+
+#pragma region IndexBenchmarks
+
+// Random operator[] reads on a dense vector and on one with tombstones.
+void bench_indexed_access() {
+    size_t n = BenchSystem::scaled(1000000);
+    size_t reads = BenchSystem::scaled(1000000);
+    TVector<int, TGrowth2x> vec;
+
+    for (size_t i = 0; i < n; i++) {
+        vec.push_back(static_cast<int>(i));
+    }
+
+    for (size_t with_tombstones = 0; with_tombstones < 2; with_tombstones++) {
+        if (with_tombstones) {
+            for (size_t i = 0; i < n / 20; i++) {
+                vec.pop_front();
+            }
+        }
+
+        uint64_t seed = 88172645463325252ull;
+        int64_t sum = 0;
+        auto start = BenchSystem::Clock::now();
+
+        for (size_t i = 0; i < reads; i++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            sum += vec[seed % vec.size()];
+        }
+
+        BenchSystem::report(with_tombstones ? "5% tombstones" : "dense",
+            reads, BenchSystem::elapsed_ns(start));
+        std::cout << "  checksum " << sum << std::endl;
+    }
+}
+
+#pragma endregion
+
+#pragma region RelocationBenchmarks
+
+struct Pod64 {
+    int64_t fields[8];
+};
+
+// std::string that counts the payload bytes it deep-copies, so moves that
+// fall back to copies show up in the report.
+struct CountedString {
+    static size_t copied_bytes;
+    std::string value;
+
+    CountedString() = default;
+    explicit CountedString(size_t i)
+        : value(48, static_cast<char>('a' + i % 26)) {}
+    CountedString(const CountedString& other) : value(other.value) {
+        copied_bytes += value.size();
+    }
+    CountedString(CountedString&&) noexcept = default;
+    CountedString& operator=(const CountedString& other) {
+        value = other.value;
+        copied_bytes += value.size();
+        return *this;
+    }
+    CountedString& operator=(CountedString&&) noexcept = default;
+};
+
+size_t CountedString::copied_bytes = 0;
+
+int make_element(int*, size_t i) {
+    return static_cast<int>(i);
+}
+
+Pod64 make_element(Pod64*, size_t i) {
+    Pod64 record = {};
+    record.fields[0] = static_cast<int64_t>(i);
+    return record;
+}
+
+CountedString make_element(CountedString*, size_t i) {
+    return CountedString(i);
+}
+
+// Growth by push_back, then front inserts that shift the whole vector.
+template<typename T>
+void relocation_series(const char* label) {
+    size_t n = BenchSystem::scaled(1000000);
+    size_t front = BenchSystem::scaled(200);
+    TVector<T, TGrowth2x> vec;
+    CountedString::copied_bytes = 0;
+    auto start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < n; i++) {
+        vec.push_back(make_element(static_cast<T*>(nullptr), i));
+    }
+
+    std::cout << "  " << label << " sizeof=" << sizeof(T) << std::endl;
+    BenchSystem::report("push_back", n, BenchSystem::elapsed_ns(start));
+    start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < front; i++) {
+        vec.push_front(make_element(static_cast<T*>(nullptr), i));
+    }
+
+    BenchSystem::report("push_front", front, BenchSystem::elapsed_ns(start));
+    std::cout << "  deep-copied bytes " << CountedString::copied_bytes
+        << std::endl;
+}
+
+void bench_relocation() {
+    relocation_series<int>("int");
+    relocation_series<CountedString>("string");
+    relocation_series<Pod64>("pod64");
+}
+
+#pragma endregion
+
+#pragma region AllocatorBenchmarks
+
+template<class Allocator>
+int64_t fill_and_sum(const Allocator& allocator, size_t count) {
+    TVector<int, TGrowth2x, Allocator> vec(allocator);
+    int64_t sum = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        vec.push_back(static_cast<int>(i));
+    }
+
+    for (auto it = vec.begin(); it != vec.end(); ++it) {
+        sum += *it;
+    }
+
+    return sum;
+}
+
+// Many short-lived vectors per "request": the arena is released after
+// every request, the pool recycles buffers across requests.
+void bench_short_lived_vectors() {
+    size_t requests = BenchSystem::scaled(20000);
+    const size_t vectors = 32;
+    const size_t elements = 100;
+    int64_t checksum = 0;
+
+    auto start = BenchSystem::Clock::now();
+
+    for (size_t r = 0; r < requests; r++) {
+        for (size_t v = 0; v < vectors; v++) {
+            checksum += fill_and_sum(std::allocator<int>(), elements);
+        }
+    }
+
+    BenchSystem::report("std::allocator", requests * vectors,
+        BenchSystem::elapsed_ns(start));
+
+    TArena arena;
+    start = BenchSystem::Clock::now();
+
+    for (size_t r = 0; r < requests; r++) {
+        for (size_t v = 0; v < vectors; v++) {
+            checksum += fill_and_sum(TArenaAllocator<int>(arena), elements);
+        }
+
+        arena.release();
+    }
+
+    BenchSystem::report("arena", requests * vectors,
+        BenchSystem::elapsed_ns(start));
+
+    TBufferPool pool;
+    start = BenchSystem::Clock::now();
+
+    for (size_t r = 0; r < requests; r++) {
+        for (size_t v = 0; v < vectors; v++) {
+            checksum += fill_and_sum(TPoolAllocator<int>(pool), elements);
+        }
+    }
+
+    BenchSystem::report("pool", requests * vectors,
+        BenchSystem::elapsed_ns(start));
+    std::cout << "  checksum " << checksum << std::endl;
+}
+
+// One very large vector: growth plus a full scan, with and without
+// MADV_HUGEPAGE mappings.
+void bench_large_vector() {
+    size_t n = BenchSystem::scaled(50000000);
+
+    auto start = BenchSystem::Clock::now();
+    int64_t sum = fill_and_sum(std::allocator<int>(), n);
+    BenchSystem::report("std::allocator", n, BenchSystem::elapsed_ns(start));
+
+    start = BenchSystem::Clock::now();
+    sum -= fill_and_sum(THugePageAllocator<int>(), n);
+    BenchSystem::report("huge pages", n, BenchSystem::elapsed_ns(start));
+    std::cout << "  checksum " << sum << std::endl;
+}
+
+#pragma endregion
+
+#pragma region TraversalBenchmarks
+
+template<class Vector>
+int64_t traverse(const Vector& vec) {
+    int64_t sum = 0;
+
+    for (const auto& value : vec) {
+        sum += value;
+    }
+
+    return sum;
+}
+
+// Range-for over 1M elements, dense and with 5% tombstones. The per
+// element cost must stay flat when the size grows tenfold, a quadratic
+// end() comparison shows up as a tenfold jump in ns/op.
+void bench_traversal() {
+    for (size_t count = 100000; count <= 1000000; count *= 10) {
+        size_t n = BenchSystem::scaled(count);
+        TVector<int, TGrowth2x> vec;
+
+        for (size_t i = 0; i < n; i++) {
+            vec.push_back(static_cast<int>(i));
+        }
+
+        auto start = BenchSystem::Clock::now();
+        int64_t sum = traverse(vec);
+        BenchSystem::report("dense", n, BenchSystem::elapsed_ns(start));
+
+        for (size_t i = 0; i < n; i += 20) {
+            vec.erase(vec.begin() + static_cast<int>(i - i / 20));
+        }
+
+        start = BenchSystem::Clock::now();
+        sum -= traverse(vec);
+        BenchSystem::report("5% tombstones", vec.size(),
+            BenchSystem::elapsed_ns(start));
+        std::cout << "  checksum " << sum << std::endl;
+    }
+}
+
+// Sum over a dense vector through the iterators and through dense_view(),
+// whose raw pointers let the loop vectorize.
+void bench_dense_view() {
+    size_t n = BenchSystem::scaled(10000000);
+    TVector<int, TGrowth2x> vec;
+
+    for (size_t i = 0; i < n; i++) {
+        vec.push_back(static_cast<int>(i % 1000));
+    }
+
+    auto start = BenchSystem::Clock::now();
+    int64_t sum = traverse(vec);
+    BenchSystem::report("iterators", n, BenchSystem::elapsed_ns(start));
+
+    start = BenchSystem::Clock::now();
+    sum -= traverse(vec.dense_view());
+    BenchSystem::report("dense_view", n, BenchSystem::elapsed_ns(start));
+    std::cout << "  checksum " << sum << std::endl;
+}
+
+#pragma endregion
+
+#pragma region SortBenchmarks
+
+bool uint64_less(uint64_t a, uint64_t b) {
+    return a < b;
+}
+
+void fill_sort_input(TVector<uint64_t, TGrowth2x>& vec, size_t n,
+    bool random) {
+    uint64_t seed = 88172645463325252ull;
+
+    for (size_t i = 0; i < n; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        vec.push_back(random ? seed : n - 1 - i);
+    }
+}
+
+// The former 100M element sort test: reversed and random uint64_t keys
+// sorted by radix sort (default tv_sort), pdqsort (tv_sort with a
+// comparator) and the legacy quick_sort.
+void bench_sort() {
+    size_t n = BenchSystem::scaled(100000000);
+
+    for (int random = 0; random < 2; random++) {
+        std::cout << "  " << (random ? "random" : "reversed") << std::endl;
+
+        for (int engine = 0; engine < 3; engine++) {
+            TVector<uint64_t, TGrowth2x> vec;
+            fill_sort_input(vec, n, random != 0);
+            auto start = BenchSystem::Clock::now();
+
+            if (engine == 0)
+                tv_sort(vec);
+            else if (engine == 1)
+                tv_sort(vec, uint64_less);
+            else
+                quick_sort(vec, 0, n - 1, uint64_less);
+
+            double ns = BenchSystem::elapsed_ns(start);
+            const char* labels[] = { "radix", "pdqsort", "quick_sort" };
+            BenchSystem::report(labels[engine], n, ns);
+
+            if (!std::is_sorted(vec.begin(), vec.end()))
+                std::cout << "  NOT SORTED" << std::endl;
+        }
+    }
+}
+
+// Parallel pdqsort of random keys from one thread up to the hardware
+// thread count, checked against the serial tv_sort.
+void bench_parallel_sort() {
+    size_t n = BenchSystem::scaled(100000000);
+    size_t max_threads = std::thread::hardware_concurrency();
+    max_threads = max_threads > 0 ? max_threads : 1;
+    TVector<uint64_t, TGrowth2x> expected;
+    fill_sort_input(expected, n, true);
+
+    auto start = BenchSystem::Clock::now();
+    tv_sort(expected, uint64_less);
+    BenchSystem::report("serial", n, BenchSystem::elapsed_ns(start));
+
+    for (size_t threads = 1; ; threads = std::min(threads * 2, max_threads)) {
+        TVector<uint64_t, TGrowth2x> vec;
+        fill_sort_input(vec, n, true);
+        start = BenchSystem::Clock::now();
+        tv_parallel_sort(vec, uint64_less, threads);
+        double ns = BenchSystem::elapsed_ns(start);
+
+        std::cout << "  threads " << threads << std::endl;
+        BenchSystem::report("parallel", n, ns);
+
+        if (!(vec == expected))
+            std::cout << "  DIFFERS FROM SERIAL" << std::endl;
+
+        if (threads == max_threads)
+            break;
+    }
+}
+
+// The sort family against a full sort of 10M random keys with 5% of
+// them popped from the front first, so every call starts on tombstones.
+void bench_partial_sorts() {
+    size_t n = BenchSystem::scaled(10000000);
+    size_t k = 100;
+    TVector<uint64_t, TGrowth2x> input;
+    fill_sort_input(input, n, true);
+
+    for (size_t i = 0; i < n / 20; i++) {
+        input.pop_front();
+    }
+
+    const char* labels[] = { "full sort", "stable sort", "partial sort k=100",
+        "nth_element", "top_k k=100" };
+
+    for (int variant = 0; variant < 5; variant++) {
+        TVector<uint64_t, TGrowth2x> vec(input);
+        uint64_t checksum = 0;
+        auto start = BenchSystem::Clock::now();
+
+        if (variant == 0) {
+            tv_sort(vec, uint64_less);
+            checksum = vec[k - 1];
+        } else if (variant == 1) {
+            tv_stable_sort(vec, uint64_less);
+            checksum = vec[k - 1];
+        } else if (variant == 2) {
+            tv_partial_sort(vec, k, uint64_less);
+            checksum = vec[k - 1];
+        } else if (variant == 3) {
+            tv_nth_element(vec, k - 1, uint64_less);
+            checksum = vec[k - 1];
+        } else {
+            checksum = tv_top_k(vec, k, uint64_less)[k - 1];
+        }
+
+        BenchSystem::report(labels[variant], vec.size(),
+            BenchSystem::elapsed_ns(start));
+        std::cout << "  checksum " << checksum << std::endl;
+    }
+}
+
+#pragma endregion
+
+#pragma region SearchBenchmarks
+
+template<typename T>
+void kernel_series(const char* type_name) {
+    size_t n = BenchSystem::scaled(10000000) / 64 * 64 + 64;
+    std::unique_ptr<T[]> data(new T[n]);
+
+    for (size_t i = 0; i < n; i++) {
+        data[i] = static_cast<T>(i % 1000);
+    }
+
+    const char* op_names[] = { "equal", "less", "range" };
+    TSearchPredicate<T> checks[] = { tv_equal_to(static_cast<T>(500)),
+        tv_less_than(static_cast<T>(10)),
+        tv_in_range(static_cast<T>(100), static_cast<T>(200)) };
+    const char* level_names[] = { "scalar", "sse4.2", "avx2" };
+
+    for (int op = 0; op < 3; op++) {
+        for (int level = 0; level <= static_cast<int>(tv_simd_level());
+            level++) {
+            uint64_t matches = 0;
+            auto start = BenchSystem::Clock::now();
+
+            for (size_t base = 0; base < n; base += 64) {
+                matches += tv_popcount(tv_match_word(
+                    static_cast<TSimdLevel>(level), data.get() + base, 64,
+                    checks[op]));
+            }
+
+            double ns = BenchSystem::elapsed_ns(start);
+            std::cout << "  " << type_name << " " << op_names[op] << " "
+                << level_names[level] << ": " << n / ns * 1e3
+                << " M elements/s, matches " << matches << std::endl;
+        }
+    }
+}
+
+// Elements per second of every kernel, on plain arrays so the numbers show
+// the compare loops alone.
+void bench_simd_kernels() {
+    kernel_series<int32_t>("int32");
+    kernel_series<int64_t>("int64");
+    kernel_series<float>("float");
+    kernel_series<double>("double");
+}
+
+bool int_is_minus_one(int value) {
+    return value == -1;
+}
+
+// Full scans (no element matches) through search_end: a function pointer
+// per busy element against the equality kernel, dense and with 5%
+// tombstones.
+void bench_search() {
+    size_t n = BenchSystem::scaled(10000000);
+    TVector<int, TGrowth2x> vec;
+
+    for (size_t i = 0; i < n; i++) {
+        vec.push_back(static_cast<int>(i));
+    }
+
+    for (int with_tombstones = 0; with_tombstones < 2; with_tombstones++) {
+        if (with_tombstones) {
+            for (size_t i = 0; i < n; i += 20) {
+                vec.erase(vec.begin() + static_cast<int>(i - i / 20));
+            }
+        }
+
+        std::cout << "  " << (with_tombstones ? "5% tombstones" : "dense")
+            << std::endl;
+        auto start = BenchSystem::Clock::now();
+        size_t found = search_end(vec, int_is_minus_one);
+        BenchSystem::report("function pointer", vec.size(),
+            BenchSystem::elapsed_ns(start));
+
+        start = BenchSystem::Clock::now();
+        found += search_end(vec, tv_equal_to(-1));
+        BenchSystem::report("equality kernel", vec.size(),
+            BenchSystem::elapsed_ns(start));
+        std::cout << "  checksum " << found << std::endl;
+    }
+}
+
+// Three matches in a large vector: search_all returns only the matches,
+// the old int* result was sized like the vector.
+void bench_search_all() {
+    size_t n = BenchSystem::scaled(10000000);
+    TVector<int, TGrowth2x> vec;
+
+    for (size_t i = 0; i < n; i++) {
+        vec.push_back(static_cast<int>(i));
+    }
+
+    int middle = static_cast<int>(n / 2);
+    auto check = tv_in_range(middle, middle + 2);
+
+    auto start = BenchSystem::Clock::now();
+    TVector<size_t, TGrowth2x> all = search_all(vec, check);
+    BenchSystem::report("search_all", n, BenchSystem::elapsed_ns(start));
+    std::cout << "  result " << all.capacity() * sizeof(size_t)
+        << " bytes, a size()-length int array is " << n * sizeof(int)
+        << " bytes" << std::endl;
+
+    size_t visited = 0;
+    start = BenchSystem::Clock::now();
+    search_each(vec, check, [&](size_t) { visited++; });
+    BenchSystem::report("search_each", n, BenchSystem::elapsed_ns(start));
+
+    start = BenchSystem::Clock::now();
+    size_t counted = search_count(vec, check);
+    BenchSystem::report("search_count", n, BenchSystem::elapsed_ns(start));
+    std::cout << "  matches " << all.size() << " " << visited << " "
+        << counted << std::endl;
+}
+
+#pragma endregion
+
+#pragma region ReductionBenchmarks
+
+// Reductions over a vector with 5% tombstones for 1, 2, 4 and all
+// hardware threads, against a single-threaded operator[] loop.
+void bench_reductions() {
+    size_t n = BenchSystem::scaled(50000000);
+    TVector<double, TGrowth2x> vec;
+
+    for (size_t i = 0; i < n; i++) {
+        vec.push_back(static_cast<double>(i % 1000) * 0.5);
+    }
+
+    for (size_t i = 0; i < n / 20; i++) {
+        vec.erase(vec.begin() + static_cast<int>(i * 19));
+    }
+
+    size_t size = vec.size();
+    double checksum = 0.0;
+    auto start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < size; i++) {
+        checksum += vec[i];
+    }
+
+    BenchSystem::report("operator[] loop sum", size,
+        BenchSystem::elapsed_ns(start));
+
+    size_t hardware = std::thread::hardware_concurrency();
+    size_t thread_counts[] = { 1, 2, 4, hardware };
+
+    for (size_t threads : thread_counts) {
+        TThreadPool pool(threads - 1);
+        std::cout << "  threads " << threads << std::endl;
+
+        start = BenchSystem::Clock::now();
+        checksum += tv_sum(vec, pool);
+        BenchSystem::report("sum", size, BenchSystem::elapsed_ns(start));
+
+        start = BenchSystem::Clock::now();
+        checksum += tv_sum(vec, TSumMode::Compensated, pool);
+        BenchSystem::report("compensated sum", size,
+            BenchSystem::elapsed_ns(start));
+
+        start = BenchSystem::Clock::now();
+        checksum += static_cast<double>(
+            tv_count_if(vec, tv_greater_than(250.0), pool));
+        BenchSystem::report("count_if", size, BenchSystem::elapsed_ns(start));
+
+        start = BenchSystem::Clock::now();
+        checksum += tv_max(vec, pool);
+        BenchSystem::report("max", size, BenchSystem::elapsed_ns(start));
+
+        start = BenchSystem::Clock::now();
+        checksum += tv_transform_reduce(vec, 0.0, std::plus<double>(),
+            [](double value) { return value * value; }, pool);
+        BenchSystem::report("transform_reduce", size,
+            BenchSystem::elapsed_ns(start));
+    }
+
+    std::cout << "  checksum " << checksum << std::endl;
+}
+
+#pragma endregion
+
+#pragma region FrontInsertBenchmarks
+
+// 1M push_front into an empty vector, with the default linear growth and
+// with TGrowth2x. insert(begin()) still shifts every element, as
+// push_front did before the front gap, so it runs on fewer elements.
+void bench_push_front() {
+    size_t n = BenchSystem::scaled(1000000);
+    size_t shifted = BenchSystem::scaled(50000);
+    int64_t checksum = 0;
+
+    TVector<int> linear;
+    auto start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < n; i++) {
+        linear.push_front(static_cast<int>(i));
+    }
+
+    BenchSystem::report("push_front, linear growth", n,
+        BenchSystem::elapsed_ns(start));
+    checksum += linear.front();
+
+    TVector<int, TGrowth2x> doubling;
+    start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < n; i++) {
+        doubling.push_front(static_cast<int>(i));
+    }
+
+    BenchSystem::report("push_front, TGrowth2x", n,
+        BenchSystem::elapsed_ns(start));
+    checksum += doubling.front();
+
+    TVector<int, TGrowth2x> shifting;
+    start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < shifted; i++) {
+        shifting.insert(shifting.begin(), static_cast<int>(i));
+    }
+
+    BenchSystem::report("insert(begin()), shifting", shifted,
+        BenchSystem::elapsed_ns(start));
+    checksum += shifting.front();
+
+    // Work queue: push_front and pop_back at a steady size.
+    start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < n; i++) {
+        doubling.push_front(static_cast<int>(i));
+        doubling.pop_back();
+    }
+
+    BenchSystem::report("push_front + pop_back", n,
+        BenchSystem::elapsed_ns(start));
+    std::cout << "  checksum " << checksum + doubling.back() << std::endl;
+}
+
+#pragma endregion
+
+#pragma region RingBufferBenchmarks
+
+// A queue of 4096 events at steady size: TVector push_back + pop_front
+// (tombstones and periodic compaction), TRingBuffer in Grow mode, and
+// TRingBuffer keeping the last 4096 events by overwriting.
+void bench_ring_buffer() {
+    size_t n = BenchSystem::scaled(10000000);
+    const size_t window = 4096;
+    int64_t checksum = 0;
+
+    TVector<int64_t, TGrowth2x> vec;
+    TRingBuffer<int64_t> queue;
+    TRingBuffer<int64_t> last(window);
+
+    for (size_t i = 0; i < window; i++) {
+        vec.push_back(static_cast<int64_t>(i));
+        queue.push_back(static_cast<int64_t>(i));
+    }
+
+    auto start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < n; i++) {
+        vec.push_back(static_cast<int64_t>(i));
+        checksum += vec.front();
+        vec.pop_front();
+    }
+
+    BenchSystem::report("TVector push_back + pop_front", n,
+        BenchSystem::elapsed_ns(start));
+    start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < n; i++) {
+        queue.push_back(static_cast<int64_t>(i));
+        checksum += queue.front();
+        queue.pop_front();
+    }
+
+    BenchSystem::report("TRingBuffer push_back + pop_front", n,
+        BenchSystem::elapsed_ns(start));
+    start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < n; i++) {
+        last.push_back(static_cast<int64_t>(i));
+    }
+
+    BenchSystem::report("TRingBuffer overwrite oldest", n,
+        BenchSystem::elapsed_ns(start));
+    std::cout << "  checksum " << checksum + last.front() << std::endl;
+}
+
+#pragma endregion
+
+#pragma region CompactionLatencyBenchmarks
+
+void latency_report(const char* label, std::vector<double>* samples) {
+    std::sort(samples->begin(), samples->end());
+    size_t n = samples->size();
+    double total = 0;
+
+    for (double ns : *samples) {
+        total += ns;
+    }
+
+    std::cout << "  " << label << " n=" << n << ": "
+        << total / n << " ns/op mean, p50 " << (*samples)[n / 2]
+        << ", p99 " << (*samples)[n * 99 / 100]
+        << ", p99.9 " << (*samples)[n * 999 / 1000]
+        << ", max " << samples->back() << " ns" << std::endl;
+}
+
+// Per-call latency of erase + push_back at steady size on a 1.5M vector:
+// the stop-the-world rebuild versus incremental compaction moving a few
+// elements per call.
+void compaction_series(const char* label, size_t step) {
+    size_t n = BenchSystem::scaled(1500000);
+    size_t ops = BenchSystem::scaled(1000000);
+    TVector<int, TGrowth2x> vec;
+    std::vector<double> samples;
+    samples.reserve(ops);
+    unsigned seed = 7;
+    vec.set_incremental_compaction(step);
+
+    for (size_t i = 0; i < n; i++) {
+        vec.push_back(static_cast<int>(i));
+    }
+
+    for (size_t i = 0; i < ops; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int k = static_cast<int>(seed % vec.size());
+        auto start = BenchSystem::Clock::now();
+        vec.erase(vec.begin() + k);
+        vec.push_back(static_cast<int>(i));
+        samples.push_back(BenchSystem::elapsed_ns(start));
+    }
+
+    latency_report(label, &samples);
+}
+
+void bench_compaction_latency() {
+    compaction_series("stop-the-world", 0);
+    compaction_series("incremental 4/op", 4);
+    compaction_series("incremental 16/op", 16);
+}
+
+// The same churn with threshold compactions copied on a pool thread and
+// published by a later erase or push_back.
+void bench_background_compaction() {
+    size_t n = BenchSystem::scaled(1500000);
+    size_t ops = BenchSystem::scaled(1000000);
+    TThreadPool pool(1);
+    TVector<int, TGrowth2x> vec;
+    std::vector<double> samples;
+    size_t published = 0;
+    samples.reserve(ops);
+    unsigned seed = 7;
+    vec.set_background_compaction(&pool);
+    vec.set_compaction_hook([&published](const TCompactionEvent&) {
+        published++;
+    });
+
+    for (size_t i = 0; i < n; i++) {
+        vec.push_back(static_cast<int>(i));
+    }
+
+    for (size_t i = 0; i < ops; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int k = static_cast<int>(seed % vec.size());
+        auto start = BenchSystem::Clock::now();
+        vec.erase(vec.begin() + k);
+        vec.push_back(static_cast<int>(i));
+        samples.push_back(BenchSystem::elapsed_ns(start));
+    }
+
+    latency_report("background", &samples);
+    std::cout << "  " << published << " compactions published" << std::endl;
+}
+
+#pragma endregion
+
+#pragma region InPlaceCompactionBenchmarks
+
+// Counts the bytes live on the heap through TVector's allocator.
+struct PeakBytes {
+    static size_t live;
+    static size_t peak;
+};
+
+size_t PeakBytes::live = 0;
+size_t PeakBytes::peak = 0;
+
+template<typename T>
+struct TPeakAllocator {
+    using value_type = T;
+
+    TPeakAllocator() = default;
+    template<typename U>
+    TPeakAllocator(const TPeakAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count) {
+        PeakBytes::live += count * sizeof(T);
+
+        if (PeakBytes::live > PeakBytes::peak)
+            PeakBytes::peak = PeakBytes::live;
+
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* buffer, size_t count) noexcept {
+        PeakBytes::live -= count * sizeof(T);
+        ::operator delete(buffer);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const TPeakAllocator<T>&, const TPeakAllocator<U>&) {
+    return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const TPeakAllocator<T>&, const TPeakAllocator<U>&) {
+    return false;
+}
+
+// The compaction rule before in-place compaction: every threshold
+// compaction moved the elements into a new buffer sized for them.
+struct TShrinkToFit : TGrowth2x {
+    static size_t shrink_capacity(size_t, size_t size, size_t elem_size) {
+        return TGrowth2x::capacity_for(0, size, elem_size);
+    }
+};
+
+template<class Growth>
+void erase_series(const char* label) {
+    size_t n = BenchSystem::scaled(4000000);
+    TVector<int, Growth, TPeakAllocator<int>> vec;
+    unsigned seed = 11;
+
+    for (size_t i = 0; i < n; i++) {
+        vec.push_back(static_cast<int>(i));
+    }
+
+    size_t filled = PeakBytes::live;
+    PeakBytes::peak = filled;
+    auto start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < n / 2; i++) {
+        seed = seed * 1103515245u + 12345u;
+        vec.erase(vec.begin() + static_cast<int>(seed % vec.size()));
+    }
+
+    BenchSystem::report(label, n / 2, BenchSystem::elapsed_ns(start));
+    std::cout << "  heap " << filled / 1024 << " KiB after fill, peak "
+        << PeakBytes::peak / 1024 << " KiB while erasing" << std::endl;
+}
+
+// Erasing half of a 4M int vector at random positions. Threshold
+// compactions either slide the elements down in place or copy them into
+// a new buffer, which holds both buffers at once.
+void bench_in_place_compaction() {
+    erase_series<TGrowth2x>("in place");
+    erase_series<TShrinkToFit>("reallocating");
+}
+
+#pragma endregion
+
+#pragma region FreeSlotBenchmarks
+
+// Random erase followed by an insert on a 1M int vector, either
+// appending with push_back or refilling the tombstone with insert_any.
+void bench_free_slot_reuse() {
+    size_t n = BenchSystem::scaled(1000000);
+    size_t ops = 2 * n;
+    size_t compactions[2] = {0, 0};
+    TVector<int, TGrowth2x> pushed;
+    TVector<int, TGrowth2x> reused;
+    pushed.set_compaction_hook([&compactions](const TCompactionEvent&) {
+        compactions[0]++;
+    });
+    reused.set_compaction_hook([&compactions](const TCompactionEvent&) {
+        compactions[1]++;
+    });
+
+    for (size_t i = 0; i < n; i++) {
+        pushed.push_back(static_cast<int>(i));
+        reused.push_back(static_cast<int>(i));
+    }
+
+    unsigned seed = 5;
+    auto start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < ops; i++) {
+        seed = seed * 1103515245u + 12345u;
+        pushed.erase(pushed.begin() + static_cast<int>(seed % n));
+        pushed.push_back(static_cast<int>(i));
+    }
+
+    BenchSystem::report("push_back", ops, BenchSystem::elapsed_ns(start));
+    std::cout << "  " << compactions[0] << " compactions, capacity "
+        << pushed.capacity() << std::endl;
+
+    seed = 5;
+    start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < ops; i++) {
+        seed = seed * 1103515245u + 12345u;
+        reused.erase_slot(seed % n);
+        reused.insert_any(static_cast<int>(i));
+    }
+
+    BenchSystem::report("insert_any", ops, BenchSystem::elapsed_ns(start));
+    std::cout << "  " << compactions[1] << " compactions, capacity "
+        << reused.capacity() << std::endl;
+}
+
+#pragma endregion
+
+#pragma region SlotMapBenchmarks
+
+// A 32-byte entity addressed by a 64-bit id.
+struct Entity {
+    int64_t x, y, z, w;
+};
+
+struct SlotMapSide {
+    TSlotMap<Entity> map;
+
+    uint64_t insert(const Entity& entity) { return map.insert(entity); }
+    Entity* find(uint64_t id) { return map.find(id); }
+    void erase(uint64_t id) { map.erase(id); }
+
+    int64_t sum() {
+        int64_t total = 0;
+
+        for (const Entity& entity : map) {
+            total += entity.x;
+        }
+
+        return total;
+    }
+};
+
+struct HashMapSide {
+    std::unordered_map<uint64_t, Entity> map;
+    uint64_t next = 1;
+
+    uint64_t insert(const Entity& entity) {
+        map.emplace(next, entity);
+        return next++;
+    }
+
+    Entity* find(uint64_t id) {
+        auto it = map.find(id);
+        return it == map.end() ? nullptr : &it->second;
+    }
+
+    void erase(uint64_t id) { map.erase(id); }
+
+    int64_t sum() {
+        int64_t total = 0;
+
+        for (const auto& item : map) {
+            total += item.second.x;
+        }
+
+        return total;
+    }
+};
+
+template<class Side>
+void handle_series(const char* label) {
+    size_t n = BenchSystem::scaled(1000000);
+    std::string name(label);
+    std::vector<uint64_t> ids(n);
+    int64_t checksum = 0;
+    unsigned seed = 21;
+    Side side;
+
+    auto start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < n; i++) {
+        int64_t v = static_cast<int64_t>(i);
+        ids[i] = side.insert(Entity{v, v, v, v});
+    }
+
+    BenchSystem::report((name + " insert").c_str(), n,
+        BenchSystem::elapsed_ns(start));
+    start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        checksum += side.find(ids[seed % n])->y;
+    }
+
+    BenchSystem::report((name + " lookup").c_str(), n,
+        BenchSystem::elapsed_ns(start));
+    start = BenchSystem::Clock::now();
+
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        size_t pick = seed % n;
+        side.erase(ids[pick]);
+        ids[pick] = side.insert(Entity{1, 2, 3, 4});
+    }
+
+    BenchSystem::report((name + " erase + insert").c_str(), n,
+        BenchSystem::elapsed_ns(start));
+    start = BenchSystem::Clock::now();
+    checksum += side.sum();
+
+    BenchSystem::report((name + " iterate").c_str(), n,
+        BenchSystem::elapsed_ns(start));
+    std::cout << "  checksum " << checksum << std::endl;
+}
+
+// 1M entities behind stable ids: TSlotMap handles against an
+// unordered_map keyed by a counter.
+void bench_slot_map() {
+    handle_series<SlotMapSide>("TSlotMap");
+    handle_series<HashMapSide>("unordered_map");
+}
+
+#pragma endregion
+
+#pragma region BulkAppendBenchmarks
+
+// Appending 10M ints: one push_back per element against a single
+// append of the whole range. The default 15-slot step reallocates every
+// 15 push_backs, so it is only timed on 100K elements.
+void bench_bulk_append() {
+    size_t n = BenchSystem::scaled(10000000);
+    size_t linear_n = BenchSystem::scaled(100000);
+    std::vector<int> source(n);
+    int64_t checksum = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        source[i] = static_cast<int>(i);
+    }
+
+    {
+        auto start = BenchSystem::Clock::now();
+        TVector<int> vec;
+
+        for (size_t i = 0; i < linear_n; i++) {
+            vec.push_back(source[i]);
+        }
+
+        BenchSystem::report("push_back, 15-slot step", linear_n,
+            BenchSystem::elapsed_ns(start));
+        checksum += vec[linear_n - 1];
+    }
+
+    {
+        auto start = BenchSystem::Clock::now();
+        TVector<int, TGrowth2x> vec;
+
+        for (size_t i = 0; i < n; i++) {
+            vec.push_back(source[i]);
+        }
+
+        BenchSystem::report("push_back, 2x growth", n,
+            BenchSystem::elapsed_ns(start));
+        checksum += vec[n - 1];
+    }
+
+    {
+        auto start = BenchSystem::Clock::now();
+        TVector<int> vec;
+        vec.append(source.begin(), source.end());
+
+        BenchSystem::report("append iterator range", n,
+            BenchSystem::elapsed_ns(start));
+        checksum += vec[n - 1];
+    }
+
+    {
+        auto start = BenchSystem::Clock::now();
+        TVector<int> vec;
+        vec.append(source.data(), source.data() + n);
+
+        BenchSystem::report("append pointer range", n,
+            BenchSystem::elapsed_ns(start));
+        checksum += vec[n - 1];
+    }
+
+    std::cout << "  checksum " << checksum << std::endl;
+}
+
+#pragma endregion
+
+#pragma region BulkEraseBenchmarks
+
+// Vector of n ints counting the compactions its policy runs.
+struct ErasedVector {
+    TVector<int, TGrowth2x> vec;
+    size_t compactions = 0;
+
+    explicit ErasedVector(size_t n) {
+        vec.set_compaction_hook([this](const TCompactionEvent&) {
+            compactions++;
+        });
+
+        for (size_t i = 0; i < n; i++) {
+            vec.push_back(static_cast<int>(i));
+        }
+    }
+};
+
+void erase_report(const char* label, size_t removed,
+    BenchSystem::Clock::time_point start, size_t compactions) {
+    BenchSystem::report(label, removed, BenchSystem::elapsed_ns(start));
+    std::cout << "  " << compactions << " compactions" << std::endl;
+}
+
+// Removing every other element of a 4M int vector, and then the middle
+// half of one: an erase per element against one bulk call.
+void bench_bulk_erase() {
+    size_t n = BenchSystem::scaled(4000000);
+
+    {
+        ErasedVector side(n);
+        auto start = BenchSystem::Clock::now();
+
+        for (size_t i = 0; i < n / 2; i++) {
+            side.vec.erase(side.vec.begin() + static_cast<int>(i));
+        }
+
+        erase_report("erase each even", n / 2, start, side.compactions);
+    }
+
+    {
+        ErasedVector side(n);
+        auto start = BenchSystem::Clock::now();
+        size_t removed = side.vec.erase_if([](int v) { return v % 2 == 0; });
+        erase_report("erase_if even", removed, start, side.compactions);
+    }
+
+    {
+        ErasedVector side(n);
+        auto start = BenchSystem::Clock::now();
+        size_t removed =
+            side.vec.remove_if([](int v) { return v % 2 == 0; });
+        erase_report("remove_if even", removed, start, side.compactions);
+    }
+
+    {
+        ErasedVector side(n);
+        auto start = BenchSystem::Clock::now();
+
+        for (size_t i = 0; i < n / 2; i++) {
+            side.vec.erase(side.vec.begin() + static_cast<int>(n / 4));
+        }
+
+        erase_report("erase middle half by element", n / 2, start,
+            side.compactions);
+    }
+
+    {
+        ErasedVector side(n);
+        auto start = BenchSystem::Clock::now();
+        side.vec.erase(side.vec.begin() + static_cast<int>(n / 4),
+            side.vec.begin() + static_cast<int>(3 * n / 4));
+        erase_report("erase middle half as range", n / 2, start,
+            side.compactions);
+    }
+}
+
+#pragma endregion
+
+int main(int argc, char** argv) {
+    BenchSystem::argc = argc;
+    BenchSystem::argv = argv;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--quick") == 0)
+            BenchSystem::scale = 100;
+    }
+
+    BenchSystem::start_bench(bench_push_back_growth, "push_back_growth");
+    BenchSystem::start_bench(bench_indexed_access, "indexed_access");
+    BenchSystem::start_bench(bench_relocation, "relocation");
+    BenchSystem::start_bench(bench_short_lived_vectors, "short_lived_vectors");
+    BenchSystem::start_bench(bench_large_vector, "large_vector");
+    BenchSystem::start_bench(bench_traversal, "traversal");
+    BenchSystem::start_bench(bench_dense_view, "dense_view");
+    BenchSystem::start_bench(bench_sort, "sort");
+    BenchSystem::start_bench(bench_parallel_sort, "parallel_sort");
+    BenchSystem::start_bench(bench_partial_sorts, "partial_sorts");
+    BenchSystem::start_bench(bench_simd_kernels, "simd_kernels");
+    BenchSystem::start_bench(bench_search, "search");
+    BenchSystem::start_bench(bench_search_all, "search_all");
+    BenchSystem::start_bench(bench_reductions, "reductions");
+    BenchSystem::start_bench(bench_push_front, "push_front");
+    BenchSystem::start_bench(bench_ring_buffer, "ring_buffer");
+    BenchSystem::start_bench(bench_compaction_latency, "compaction_latency");
+    BenchSystem::start_bench(bench_background_compaction,
+        "background_compaction");
+    BenchSystem::start_bench(bench_in_place_compaction, "in_place_compaction");
+    BenchSystem::start_bench(bench_free_slot_reuse, "free_slot_reuse");
+    BenchSystem::start_bench(bench_slot_map, "slot_map");
+    BenchSystem::start_bench(bench_bulk_append, "bulk_append");
+    BenchSystem::start_bench(bench_bulk_erase, "bulk_erase");
+
+    return 0;
+}
@@ -0,0 +1,371 @@
+// Copyright 2025 Chernykh Valentin
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+// Allocators for TVector<T, Growth, Allocator>. All of them follow the
+// standard Allocator requirements, so they work with std containers too.
+
+// count * sizeof(T) in bytes. Like std::allocator, a count whose size
+// overflows throws std::bad_array_new_length.
+template<typename T>
+inline std::size_t tv_allocation_bytes(std::size_t count) {
+    if (count > static_cast<std::size_t>(-1) / sizeof(T))
+        throw std::bad_array_new_length();
+
+    return count * sizeof(T);
+}
+
+#pragma region Arena
+
+// Monotonic arena: allocations bump a pointer inside large chunks,
+// deallocation is a no-op and release() frees everything at once.
+// Meant for many short-lived vectors that die together.
+class TArena {
+ private:
+    struct Chunk {
+        Chunk* next;
+        std::size_t size;
+    };
+
+    Chunk* _chunks;
+    char* _cursor;
+    char* _end;
+    std::size_t _chunk_size;
+    std::size_t _reserved;
+
+ public:
+    explicit TArena(std::size_t chunk_size = 64 * 1024) noexcept;
+    TArena(const TArena&) = delete;
+    ~TArena() noexcept;
+
+    TArena& operator=(const TArena&) = delete;
+
+    void* allocate(std::size_t, std::size_t);
+    void release() noexcept;
+    inline std::size_t reserved() const noexcept;
+};
+
+inline TArena::TArena(std::size_t chunk_size) noexcept : _chunks(nullptr),
+_cursor(nullptr), _end(nullptr), _chunk_size(chunk_size), _reserved(0) {}
+
+inline TArena::~TArena() noexcept {
+    release();
+}
+
+inline void* TArena::allocate(std::size_t bytes, std::size_t alignment) {
+    std::size_t address = reinterpret_cast<std::size_t>(_cursor);
+    std::size_t padding = (alignment - address % alignment) % alignment;
+
+    if (_cursor == nullptr ||
+        padding + bytes > static_cast<std::size_t>(_end - _cursor)) {
+        std::size_t header = (sizeof(Chunk) + alignof(std::max_align_t) - 1) /
+            alignof(std::max_align_t) * alignof(std::max_align_t);
+        std::size_t size = bytes + alignment > _chunk_size ?
+            bytes + alignment : _chunk_size;
+        Chunk* chunk = static_cast<Chunk*>(::operator new(header + size));
+
+        chunk->next = _chunks;
+        chunk->size = size;
+        _chunks = chunk;
+        _cursor = reinterpret_cast<char*>(chunk) + header;
+        _end = _cursor + size;
+        _reserved += size;
+
+        address = reinterpret_cast<std::size_t>(_cursor);
+        padding = (alignment - address % alignment) % alignment;
+    }
+
+    void* result = _cursor + padding;
+    _cursor += padding + bytes;
+
+    return result;
+}
+
+// Frees every chunk. Memory handed out before is invalid afterwards.
+inline void TArena::release() noexcept {
+    while (_chunks != nullptr) {
+        Chunk* next = _chunks->next;
+        ::operator delete(_chunks);
+        _chunks = next;
+    }
+
+    _cursor = nullptr;
+    _end = nullptr;
+    _reserved = 0;
+}
+
+inline std::size_t TArena::reserved() const noexcept {
+    return _reserved;
+}
+
+template<typename T>
+class TArenaAllocator {
+ private:
+    TArena* _arena;
+
+ public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+
+    explicit TArenaAllocator(TArena& arena) noexcept : _arena(&arena) {}
+    template<typename U>
+    TArenaAllocator(const TArenaAllocator<U>& other) noexcept
+        : _arena(other.arena()) {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(_arena->allocate(tv_allocation_bytes<T>(count),
+            alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) noexcept {}
+
+    TArena* arena() const noexcept {
+        return _arena;
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const TArenaAllocator<T>& first,
+    const TArenaAllocator<U>& second) noexcept {
+    return first.arena() == second.arena();
+}
+
+template<typename T, typename U>
+bool operator!=(const TArenaAllocator<T>& first,
+    const TArenaAllocator<U>& second) noexcept {
+    return !(first == second);
+}
+
+#pragma endregion Arena
+
+#pragma region Pool
+
+// Size-class pool: requests are rounded up to a power of two and freed
+// buffers are kept on a free list per class, so a vector that dies and a
+// vector of the same size that is born next reuse one buffer instead of
+// going through operator new. Requests above max_bytes bypass the pool.
+// A pool is not thread-safe and has no default instance: the owner
+// picks the pool, keeps it alive while any vector uses it and shares it
+// between threads only under its own lock.
+class TBufferPool {
+ private:
+    static constexpr std::size_t min_shift = 6;
+    static constexpr std::size_t class_count = 20;
+
+    struct Node {
+        Node* next;
+    };
+
+    Node* _free[class_count];
+    std::size_t _cached;
+
+    static inline std::size_t class_of(std::size_t) noexcept;
+
+ public:
+    static constexpr std::size_t max_bytes =
+        std::size_t(1) << (min_shift + class_count - 1);
+
+    TBufferPool() noexcept;
+    TBufferPool(const TBufferPool&) = delete;
+    ~TBufferPool() noexcept;
+
+    TBufferPool& operator=(const TBufferPool&) = delete;
+
+    void* allocate(std::size_t);
+    void deallocate(void*, std::size_t) noexcept;
+    void trim() noexcept;
+    inline std::size_t cached() const noexcept;
+};
+
+inline TBufferPool::TBufferPool() noexcept : _cached(0) {
+    for (std::size_t i = 0; i < class_count; i++) {
+        _free[i] = nullptr;
+    }
+}
+
+inline TBufferPool::~TBufferPool() noexcept {
+    trim();
+}
+
+inline std::size_t TBufferPool::class_of(std::size_t bytes) noexcept {
+    std::size_t index = 0;
+
+    while ((std::size_t(1) << (min_shift + index)) < bytes) {
+        index++;
+    }
+
+    return index;
+}
+
+inline void* TBufferPool::allocate(std::size_t bytes) {
+    if (bytes > max_bytes)
+        return ::operator new(bytes);
+
+    std::size_t index = class_of(bytes);
+    Node* node = _free[index];
+
+    if (node == nullptr)
+        return ::operator new(std::size_t(1) << (min_shift + index));
+
+    _free[index] = node->next;
+    _cached--;
+
+    return node;
+}
+
+inline void TBufferPool::deallocate(void* buffer, std::size_t bytes)
+noexcept {
+    if (bytes > max_bytes) {
+        ::operator delete(buffer);
+        return;
+    }
+
+    std::size_t index = class_of(bytes);
+    Node* node = static_cast<Node*>(buffer);
+
+    node->next = _free[index];
+    _free[index] = node;
+    _cached++;
+}
+
+// Gives every cached buffer back to operator delete.
+inline void TBufferPool::trim() noexcept {
+    for (std::size_t i = 0; i < class_count; i++) {
+        while (_free[i] != nullptr) {
+            Node* next = _free[i]->next;
+            ::operator delete(_free[i]);
+            _free[i] = next;
+        }
+    }
+
+    _cached = 0;
+}
+
+inline std::size_t TBufferPool::cached() const noexcept {
+    return _cached;
+}
+
+template<typename T>
+class TPoolAllocator {
+ private:
+    TBufferPool* _pool;
+
+ public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+
+    explicit TPoolAllocator(TBufferPool& pool) noexcept : _pool(&pool) {}
+    template<typename U>
+    TPoolAllocator(const TPoolAllocator<U>& other) noexcept
+        : _pool(other.pool()) {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(_pool->allocate(tv_allocation_bytes<T>(count)));
+    }
+
+    void deallocate(T* buffer, std::size_t count) noexcept {
+        _pool->deallocate(buffer, count * sizeof(T));
+    }
+
+    TBufferPool* pool() const noexcept {
+        return _pool;
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const TPoolAllocator<T>& first,
+    const TPoolAllocator<U>& second) noexcept {
+    return first.pool() == second.pool();
+}
+
+template<typename T, typename U>
+bool operator!=(const TPoolAllocator<T>& first,
+    const TPoolAllocator<U>& second) noexcept {
+    return !(first == second);
+}
+
+#pragma endregion Pool
+
+#pragma region HugePage
+
+// Buffers of at least Threshold bytes are mapped directly with mmap,
+// rounded up to 2 MiB and marked MADV_HUGEPAGE, which cuts TLB misses on
+// scans of very large vectors. Smaller buffers and platforms without mmap
+// use operator new.
+template<typename T, std::size_t Threshold = std::size_t(2) << 20>
+class THugePageAllocator {
+ public:
+    using value_type = T;
+
+    static constexpr std::size_t huge_page = std::size_t(2) << 20;
+
+    template<typename U>
+    struct rebind {
+        using other = THugePageAllocator<U, Threshold>;
+    };
+
+    THugePageAllocator() noexcept {}
+    template<typename U>
+    THugePageAllocator(const THugePageAllocator<U, Threshold>&) noexcept {}
+
+    T* allocate(std::size_t count) {
+        std::size_t bytes = tv_allocation_bytes<T>(count);
+
+#if defined(__linux__)
+        if (bytes >= Threshold) {
+            void* memory = mmap(nullptr, round_up(bytes),
+                PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (memory == MAP_FAILED)
+                throw std::bad_alloc();
+
+#if defined(MADV_HUGEPAGE)
+            madvise(memory, round_up(bytes), MADV_HUGEPAGE);
+#endif
+
+            return static_cast<T*>(memory);
+        }
+#endif
+
+        return static_cast<T*>(::operator new(bytes));
+    }
+
+    void deallocate(T* buffer, std::size_t count) noexcept {
+        std::size_t bytes = count * sizeof(T);
+
+#if defined(__linux__)
+        if (bytes >= Threshold) {
+            munmap(buffer, round_up(bytes));
+            return;
+        }
+#endif
+
+        ::operator delete(buffer);
+    }
+
+ private:
+    static std::size_t round_up(std::size_t bytes) noexcept {
+        return (bytes + huge_page - 1) / huge_page * huge_page;
+    }
+};
+
+template<typename T, typename U, std::size_t Threshold>
+bool operator==(const THugePageAllocator<T, Threshold>&,
+    const THugePageAllocator<U, Threshold>&) noexcept {
+    return true;
+}
+
+template<typename T, typename U, std::size_t Threshold>
+bool operator!=(const THugePageAllocator<T, Threshold>&,
+    const THugePageAllocator<U, Threshold>&) noexcept {
+    return false;
+}
+
+#pragma endregion HugePage
@@ -0,0 +1,64 @@
+// Copyright 2025 Chernykh Valentin
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#pragma region BitHelpers
+
+inline unsigned tv_popcount(uint64_t word) noexcept {
+#if defined(_MSC_VER)
+    return static_cast<unsigned>(__popcnt64(word));
+#else
+    return static_cast<unsigned>(__builtin_popcountll(word));
+#endif
+}
+
+// Index of the lowest set bit, word must not be zero.
+inline unsigned tv_ctz(uint64_t word) noexcept {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+}
+
+// Index of the highest set bit, word must not be zero.
+inline unsigned tv_msb(uint64_t word) noexcept {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return 63u - static_cast<unsigned>(__builtin_clzll(word));
+#endif
+}
+
+// Position of the n-th (0-based) set bit, word must have more than n bits.
+inline unsigned tv_select_in_word(uint64_t word, unsigned n) noexcept {
+    unsigned shift = 0;
+
+    for (;; shift += 8) {
+        unsigned count = tv_popcount((word >> shift) & 0xFFu);
+
+        if (n < count)
+            break;
+
+        n -= count;
+    }
+
+    uint64_t byte = (word >> shift) & 0xFFu;
+
+    for (; n > 0; n--) {
+        byte &= byte - 1;
+    }
+
+    return shift + tv_ctz(byte);
+}
+
+#pragma endregion BitHelpers
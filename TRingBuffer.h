@@ -0,0 +1,504 @@
+// Copyright 2025 Chernykh Valentin
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "TVector.h"
+
+#pragma region RingBuffer
+
+// What push_back does when a ring buffer is full:
+//  Grow      - reallocates through the growth policy (unbounded queue);
+//  Overwrite - drops the oldest element (keeps the last N);
+//  Reject    - leaves the buffer unchanged and returns false.
+enum class TOverflow { Grow, Overwrite, Reject };
+
+// FIFO over the raw element storage and slot state map TVector uses.
+// Elements live in [head, head + size()) modulo capacity(), so
+// push_back and pop_front are O(1) and never compact. Slot states are
+// written without the rank index, states() shows which slots are live.
+template<typename T, class Growth = TGrowth2x,
+    class Allocator = std::allocator<T>>
+class TRingBuffer {
+ private:
+    using allocator_traits = std::allocator_traits<Allocator>;
+    using word_allocator =
+        typename allocator_traits::template rebind_alloc<uint64_t>;
+    using state_map = TBasicStateMap<word_allocator>;
+
+    Allocator _allocator;
+    T* _data;
+    state_map _states;
+    size_t _capacity;
+    size_t _head;
+    size_t _size;
+    TOverflow _overflow;
+
+ public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using growth_policy = Growth;
+    using allocator_type = Allocator;
+
+    // Walks the elements from the oldest to the newest.
+    template<class Ring, typename Value>
+    class BasicIterator {
+     private:
+        Ring* _ring;
+        size_type _index;
+
+     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TRingBuffer::value_type;
+        using reference = Value&;
+        using pointer = Value*;
+        using difference_type = TRingBuffer::difference_type;
+
+        BasicIterator(Ring* ring, size_type index) noexcept
+            : _ring(ring), _index(index) {}
+
+        reference operator*() const { return (*_ring)[_index]; }
+        pointer operator->() const { return &(*_ring)[_index]; }
+
+        BasicIterator& operator++() noexcept {
+            _index++;
+            return *this;
+        }
+
+        BasicIterator operator++(int) noexcept {
+            BasicIterator temp = *this;
+            _index++;
+            return temp;
+        }
+
+        bool operator==(const BasicIterator& other) const noexcept {
+            return _ring == other._ring && _index == other._index;
+        }
+
+        bool operator!=(const BasicIterator& other) const noexcept {
+            return !(*this == other);
+        }
+    };
+
+    using Iterator = BasicIterator<TRingBuffer, T>;
+    using ConstIterator = BasicIterator<const TRingBuffer, const T>;
+
+    TRingBuffer() noexcept;
+    explicit TRingBuffer(const Allocator&) noexcept;
+    explicit TRingBuffer(size_type, TOverflow = TOverflow::Overwrite,
+        const Allocator& = Allocator());
+    TRingBuffer(const TRingBuffer&);
+    TRingBuffer(TRingBuffer&&) noexcept;
+    ~TRingBuffer() noexcept;
+
+    TRingBuffer& operator=(const TRingBuffer&);
+    TRingBuffer& operator=(TRingBuffer&&) noexcept;
+
+    inline TBasicStatesView<word_allocator> states() const noexcept;
+    inline allocator_type get_allocator() const noexcept;
+    inline size_type size() const noexcept;
+    inline size_type capacity() const noexcept;
+    inline TOverflow overflow() const noexcept;
+    inline bool is_empty() const noexcept;
+    inline bool is_full() const noexcept;
+    inline reference front();
+    inline reference back();
+    inline Iterator begin() noexcept;
+    inline Iterator end() noexcept;
+    inline ConstIterator begin() const noexcept;
+    inline ConstIterator end() const noexcept;
+    TDenseView<T> first_run() noexcept;
+    TDenseView<T> second_run() noexcept;
+
+    bool push_back(const value_type&);
+    bool push_back(value_type&&);
+    template <class... Args>
+    bool emplace_back(Args&&... args);
+    void pop_front();
+    void clear() noexcept;
+    reference operator[](size_type);
+    const_reference operator[](size_type) const;
+
+ private:
+    inline size_type slot(size_type) const noexcept;
+    template <class... Args>
+    void construct_back(Args&&... args);
+    void make_room();
+    void reallocate(size_type);
+    void destroy_all() noexcept;
+    void copy_from(const TRingBuffer&);
+};
+
+template<typename T, class G, class A>
+TRingBuffer<T, G, A>::TRingBuffer() noexcept : TRingBuffer(A()) {}
+
+template<typename T, class G, class A>
+TRingBuffer<T, G, A>::TRingBuffer(const A& allocator) noexcept
+    : _allocator(allocator), _data(nullptr),
+_states(word_allocator(allocator)), _capacity(0), _head(0), _size(0),
+_overflow(TOverflow::Grow) {}
+
+// A ring of fixed capacity. With TOverflow::Grow the capacity is only
+// the initial one.
+template<typename T, class G, class A>
+TRingBuffer<T, G, A>::TRingBuffer(size_type capacity, TOverflow overflow,
+    const A& allocator) : TRingBuffer(allocator) {
+    if (capacity == 0 && overflow != TOverflow::Grow) {
+        throw std::runtime_error("TRingBuffer of fixed capacity"
+                                 " can not be with zero capacity");
+    }
+
+    _overflow = overflow;
+
+    if (capacity > 0)
+        reallocate(capacity);
+}
+
+template<typename T, class G, class A>
+TRingBuffer<T, G, A>::TRingBuffer(const TRingBuffer& other)
+    : TRingBuffer(allocator_traits::select_on_container_copy_construction(
+        other._allocator)) {
+    copy_from(other);
+}
+
+template<typename T, class G, class A>
+TRingBuffer<T, G, A>::TRingBuffer(TRingBuffer&& other) noexcept
+    : _allocator(std::move(other._allocator)), _data(other._data),
+_states(std::move(other._states)), _capacity(other._capacity),
+_head(other._head), _size(other._size), _overflow(other._overflow) {
+    other._data = nullptr;
+    other._capacity = 0;
+    other._head = 0;
+    other._size = 0;
+}
+
+template<typename T, class G, class A>
+TRingBuffer<T, G, A>::~TRingBuffer() noexcept {
+    destroy_all();
+
+    if (_data != nullptr)
+        allocator_traits::deallocate(_allocator, _data, _capacity);
+}
+
+template<typename T, class G, class A>
+TRingBuffer<T, G, A>& TRingBuffer<T, G, A>::operator=(
+    const TRingBuffer& other) {
+    if (this != &other) {
+        clear();
+        copy_from(other);
+    }
+
+    return *this;
+}
+
+template<typename T, class G, class A>
+TRingBuffer<T, G, A>& TRingBuffer<T, G, A>::operator=(
+    TRingBuffer&& other) noexcept {
+    if (this != &other) {
+        destroy_all();
+
+        if (_data != nullptr)
+            allocator_traits::deallocate(_allocator, _data, _capacity);
+
+        _allocator = std::move(other._allocator);
+        _data = other._data;
+        _states = std::move(other._states);
+        _capacity = other._capacity;
+        _head = other._head;
+        _size = other._size;
+        _overflow = other._overflow;
+        other._data = nullptr;
+        other._capacity = 0;
+        other._head = 0;
+        other._size = 0;
+    }
+
+    return *this;
+}
+
+template<typename T, class G, class A>
+inline TBasicStatesView<typename TRingBuffer<T, G, A>::word_allocator>
+TRingBuffer<T, G, A>::states() const noexcept {
+    return TBasicStatesView<word_allocator>(_states, _capacity);
+}
+
+template<typename T, class G, class A>
+inline typename TRingBuffer<T, G, A>::allocator_type
+TRingBuffer<T, G, A>::get_allocator() const noexcept {
+    return _allocator;
+}
+
+template<typename T, class G, class A>
+inline typename TRingBuffer<T, G, A>::size_type
+TRingBuffer<T, G, A>::size() const noexcept {
+    return _size;
+}
+
+template<typename T, class G, class A>
+inline typename TRingBuffer<T, G, A>::size_type
+TRingBuffer<T, G, A>::capacity() const noexcept {
+    return _capacity;
+}
+
+template<typename T, class G, class A>
+inline TOverflow TRingBuffer<T, G, A>::overflow() const noexcept {
+    return _overflow;
+}
+
+template<typename T, class G, class A>
+inline bool TRingBuffer<T, G, A>::is_empty() const noexcept {
+    return _size == 0;
+}
+
+template<typename T, class G, class A>
+inline bool TRingBuffer<T, G, A>::is_full() const noexcept {
+    return _size == _capacity;
+}
+
+template<typename T, class G, class A>
+inline typename TRingBuffer<T, G, A>::reference
+TRingBuffer<T, G, A>::front() {
+    if (is_empty()) {
+        throw std::runtime_error("front() called on empty TRingBuffer");
+    }
+
+    return _data[_head];
+}
+
+template<typename T, class G, class A>
+inline typename TRingBuffer<T, G, A>::reference
+TRingBuffer<T, G, A>::back() {
+    if (is_empty()) {
+        throw std::runtime_error("back() called on empty TRingBuffer");
+    }
+
+    return _data[slot(_size - 1)];
+}
+
+template<typename T, class G, class A>
+inline typename TRingBuffer<T, G, A>::Iterator
+TRingBuffer<T, G, A>::begin() noexcept {
+    return Iterator(this, 0);
+}
+
+template<typename T, class G, class A>
+inline typename TRingBuffer<T, G, A>::Iterator
+TRingBuffer<T, G, A>::end() noexcept {
+    return Iterator(this, _size);
+}
+
+template<typename T, class G, class A>
+inline typename TRingBuffer<T, G, A>::ConstIterator
+TRingBuffer<T, G, A>::begin() const noexcept {
+    return ConstIterator(this, 0);
+}
+
+template<typename T, class G, class A>
+inline typename TRingBuffer<T, G, A>::ConstIterator
+TRingBuffer<T, G, A>::end() const noexcept {
+    return ConstIterator(this, _size);
+}
+
+// The elements from the oldest up to the end of the buffer. Together
+// with second_run() they cover the ring in order, so a consumer can
+// drain it with two contiguous passes.
+template<typename T, class G, class A>
+TDenseView<T> TRingBuffer<T, G, A>::first_run() noexcept {
+    size_type length = _capacity - _head < _size ? _capacity - _head : _size;
+    return TDenseView<T>(_data + _head, length);
+}
+
+// The elements that wrapped around to the start of the buffer.
+template<typename T, class G, class A>
+TDenseView<T> TRingBuffer<T, G, A>::second_run() noexcept {
+    size_type first = _capacity - _head < _size ? _capacity - _head : _size;
+    return TDenseView<T>(_data, _size - first);
+}
+
+template<typename T, class G, class A>
+bool TRingBuffer<T, G, A>::push_back(const value_type& value) {
+    return emplace_back(value);
+}
+
+template<typename T, class G, class A>
+bool TRingBuffer<T, G, A>::push_back(value_type&& value) {
+    return emplace_back(std::move(value));
+}
+
+// Appends after the newest element. Returns false when the buffer is
+// full and rejects new elements.
+template<typename T, class G, class A>
+template<class... Args>
+bool TRingBuffer<T, G, A>::emplace_back(Args&&... args) {
+    if (!is_full()) {
+        construct_back(std::forward<Args>(args)...);
+        return true;
+    }
+
+    if (_overflow == TOverflow::Reject)
+        return false;
+
+    // args may refer to an element of this buffer, so the new element is
+    // built before any element is moved or destroyed.
+    T value(std::forward<Args>(args)...);
+    make_room();
+    construct_back(std::move(value));
+
+    return true;
+}
+
+template<typename T, class G, class A>
+void TRingBuffer<T, G, A>::pop_front() {
+    if (is_empty())
+        throw std::runtime_error("Pop with empty ring buffer");
+
+    _data[_head].~T();
+    _states.write(_head, Empty);
+    _head = _head + 1 == _capacity ? 0 : _head + 1;
+    _size--;
+}
+
+// Destroys the elements and keeps the buffer.
+template<typename T, class G, class A>
+void TRingBuffer<T, G, A>::clear() noexcept {
+    destroy_all();
+    _head = 0;
+    _size = 0;
+}
+
+template<typename T, class G, class A>
+typename TRingBuffer<T, G, A>::reference
+TRingBuffer<T, G, A>::operator[](size_type index) {
+    if (index >= _size) {
+        throw std::out_of_range("TRingBuffer operator[]: Index out of range.");
+    }
+
+    return _data[slot(index)];
+}
+
+template<typename T, class G, class A>
+typename TRingBuffer<T, G, A>::const_reference
+TRingBuffer<T, G, A>::operator[](size_type index) const {
+    if (index >= _size) {
+        throw std::out_of_range("TRingBuffer operator[]: Index out of range.");
+    }
+
+    return _data[slot(index)];
+}
+
+// Slot of the element index positions after the oldest one.
+template<typename T, class G, class A>
+inline typename TRingBuffer<T, G, A>::size_type
+TRingBuffer<T, G, A>::slot(size_type index) const noexcept {
+    size_type position = _head + index;
+    return position >= _capacity ? position - _capacity : position;
+}
+
+template<typename T, class G, class A>
+template<class... Args>
+void TRingBuffer<T, G, A>::construct_back(Args&&... args) {
+    size_type index = slot(_size);
+
+    new (_data + index) T(std::forward<Args>(args)...);
+    _states.write(index, Busy);
+    _size++;
+}
+
+// Frees a slot in a full buffer: drops the oldest element or grows.
+template<typename T, class G, class A>
+void TRingBuffer<T, G, A>::make_room() {
+    if (_overflow == TOverflow::Overwrite)
+        pop_front();
+    else
+        reallocate(G::capacity_for(_capacity, _size + 1, sizeof(T)));
+}
+
+// Moves the elements, oldest first, to the start of a new buffer. The old
+// elements are destroyed only once all of them were moved (copied when
+// the move may throw), so a throw leaves the buffer as it was.
+template<typename T, class G, class A>
+void TRingBuffer<T, G, A>::reallocate(size_type new_capacity) {
+    T* new_data = allocator_traits::allocate(_allocator, new_capacity);
+    size_type built = 0;
+
+    try {
+        state_map new_states(new_capacity, word_allocator(_allocator));
+
+        for (; built < _size; built++) {
+            new (new_data + built) T(std::move_if_noexcept(
+                _data[slot(built)]));
+            new_states.write(built, Busy);
+        }
+
+        _states = std::move(new_states);
+    } catch (...) {
+        for (size_type i = 0; i < built; i++) {
+            new_data[i].~T();
+        }
+
+        allocator_traits::deallocate(_allocator, new_data, new_capacity);
+        throw;
+    }
+
+    if (!std::is_trivially_destructible<T>::value) {
+        for (size_type i = 0; i < _size; i++) {
+            _data[slot(i)].~T();
+        }
+    }
+
+    if (_data != nullptr)
+        allocator_traits::deallocate(_allocator, _data, _capacity);
+
+    _data = new_data;
+    _capacity = new_capacity;
+    _head = 0;
+}
+
+template<typename T, class G, class A>
+void TRingBuffer<T, G, A>::destroy_all() noexcept {
+    for (size_type i = 0; i < _size; i++) {
+        size_type index = slot(i);
+
+        if (!std::is_trivially_destructible<T>::value)
+            _data[index].~T();
+
+        _states.write(index, Empty);
+    }
+}
+
+// Takes the overflow mode and the elements of other into this empty
+// buffer, reallocating when they do not fit.
+template<typename T, class G, class A>
+void TRingBuffer<T, G, A>::copy_from(const TRingBuffer& other) {
+    _overflow = other._overflow;
+
+    if (_capacity != other._capacity) {
+        if (_data != nullptr)
+            allocator_traits::deallocate(_allocator, _data, _capacity);
+
+        _data = nullptr;
+        _capacity = 0;
+        _states = state_map(word_allocator(_allocator));
+
+        if (other._capacity > 0)
+            reallocate(other._capacity);
+    }
+
+    for (const T& value : other) {
+        emplace_back(value);
+    }
+}
+
+#pragma endregion RingBuffer
@@ -0,0 +1,567 @@
+// Copyright 2025 Chernykh Valentin
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "TBits.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define TV_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TV_TARGET_SSE42
+#define TV_TARGET_AVX2
+#else
+#define TV_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define TV_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define TV_SIMD_X86 0
+#endif
+
+// Vectorized predicate kernels for the search functions. A kernel turns up
+// to 64 consecutive elements into a match mask, bit i set when element i
+// matches; callers AND it with the busy word of the same 64 slots.
+
+#pragma region SearchPredicate
+
+enum class TSearchOp {
+    Equal,
+    Less,
+    Greater,
+    Range
+};
+
+// Predicate shapes the kernels understand: x == first, x < first,
+// x > first and first <= x <= second. Also an ordinary callable.
+template<typename T>
+struct TSearchPredicate {
+    TSearchOp op;
+    T first;
+    T second;
+
+    bool operator()(const T& value) const noexcept {
+        switch (op) {
+        case TSearchOp::Equal: return value == first;
+        case TSearchOp::Less: return value < first;
+        case TSearchOp::Greater: return value > first;
+        default: return first <= value && value <= second;
+        }
+    }
+};
+
+template<typename T>
+TSearchPredicate<T> tv_equal_to(T value) noexcept {
+    return TSearchPredicate<T>{ TSearchOp::Equal, value, value };
+}
+
+template<typename T>
+TSearchPredicate<T> tv_less_than(T value) noexcept {
+    return TSearchPredicate<T>{ TSearchOp::Less, value, value };
+}
+
+template<typename T>
+TSearchPredicate<T> tv_greater_than(T value) noexcept {
+    return TSearchPredicate<T>{ TSearchOp::Greater, value, value };
+}
+
+template<typename T>
+TSearchPredicate<T> tv_in_range(T low, T high) noexcept {
+    return TSearchPredicate<T>{ TSearchOp::Range, low, high };
+}
+
+#pragma endregion SearchPredicate
+
+#pragma region SimdDetection
+
+enum class TSimdLevel {
+    Scalar,
+    Sse42,
+    Avx2
+};
+
+inline TSimdLevel tv_detect_simd_level() noexcept {
+#if TV_SIMD_X86 && defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    __cpuid(info, 1);
+    bool sse42 = (info[2] & (1 << 20)) != 0;
+    bool os_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+
+    if (max_leaf >= 7 && os_avx && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(info, 7, 0);
+
+        if ((info[1] & (1 << 5)) != 0)
+            return TSimdLevel::Avx2;
+    }
+
+    return sse42 ? TSimdLevel::Sse42 : TSimdLevel::Scalar;
+#elif TV_SIMD_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return TSimdLevel::Avx2;
+
+    if (__builtin_cpu_supports("sse4.2"))
+        return TSimdLevel::Sse42;
+
+    return TSimdLevel::Scalar;
+#else
+    return TSimdLevel::Scalar;
+#endif
+}
+
+// Detected once, on first use.
+inline TSimdLevel tv_simd_level() noexcept {
+    static const TSimdLevel level = tv_detect_simd_level();
+    return level;
+}
+
+#pragma endregion SimdDetection
+
+#pragma region SimdKernels
+
+// Lane kinds with a vector kernel: 32 and 64-bit integers, IEEE float and
+// double. Everything else only has the scalar kernel.
+enum class TLaneKind {
+    None,
+    I32,
+    U32,
+    I64,
+    U64,
+    F32,
+    F64
+};
+
+template<typename T>
+struct TSimdLane : std::integral_constant<TLaneKind,
+    std::is_integral<T>::value && !std::is_same<T, bool>::value ?
+        (sizeof(T) == 4 ? (std::is_signed<T>::value ?
+            TLaneKind::I32 : TLaneKind::U32) :
+        sizeof(T) == 8 ? (std::is_signed<T>::value ?
+            TLaneKind::I64 : TLaneKind::U64) : TLaneKind::None) :
+    std::is_floating_point<T>::value && std::numeric_limits<T>::is_iec559 ?
+        (sizeof(T) == 4 ? TLaneKind::F32 :
+        sizeof(T) == 8 ? TLaneKind::F64 : TLaneKind::None) :
+    TLaneKind::None> {};
+
+template<typename T, class Predicate>
+inline uint64_t tv_match_word_scalar(const T* data, std::size_t count,
+    const Predicate& check) {
+    uint64_t mask = 0;
+
+    for (std::size_t i = 0; i < count; i++) {
+        mask |= static_cast<uint64_t>(check(data[i]) ? 1 : 0) << i;
+    }
+
+    return mask;
+}
+
+#if TV_SIMD_X86
+
+// Per ISA and lane kind: load, broadcast, the three comparisons and a
+// range test, each returning a lane mask, and bits() to pack it. Unsigned
+// lanes are biased by the sign bit so signed compares order them.
+template<TLaneKind Kind>
+struct TSse42Ops;
+
+template<TLaneKind Kind>
+struct TAvx2Ops;
+
+template<bool Unsigned>
+struct TSse42Int32 {
+    using vec = __m128i;
+
+    TV_TARGET_SSE42 static vec bias() {
+        return _mm_set1_epi32(Unsigned ? INT32_MIN : 0);
+    }
+    TV_TARGET_SSE42 static vec load(const void* data) {
+        return _mm_xor_si128(
+            _mm_loadu_si128(static_cast<const __m128i*>(data)), bias());
+    }
+    TV_TARGET_SSE42 static vec set1(const void* value) {
+        int32_t lane;
+        std::memcpy(&lane, value, sizeof(lane));
+        return _mm_xor_si128(_mm_set1_epi32(lane), bias());
+    }
+    TV_TARGET_SSE42 static vec eq(vec a, vec b) {
+        return _mm_cmpeq_epi32(a, b);
+    }
+    TV_TARGET_SSE42 static vec lt(vec a, vec b) {
+        return _mm_cmpgt_epi32(b, a);
+    }
+    TV_TARGET_SSE42 static vec gt(vec a, vec b) {
+        return _mm_cmpgt_epi32(a, b);
+    }
+    TV_TARGET_SSE42 static vec in_range(vec x, vec low, vec high) {
+        return _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi32(low, x),
+            _mm_cmpgt_epi32(x, high)), _mm_set1_epi32(-1));
+    }
+    TV_TARGET_SSE42 static unsigned bits(vec mask) {
+        return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+    }
+};
+
+template<bool Unsigned>
+struct TSse42Int64 {
+    using vec = __m128i;
+
+    TV_TARGET_SSE42 static vec bias() {
+        return _mm_set1_epi64x(Unsigned ? INT64_MIN : 0);
+    }
+    TV_TARGET_SSE42 static vec load(const void* data) {
+        return _mm_xor_si128(
+            _mm_loadu_si128(static_cast<const __m128i*>(data)), bias());
+    }
+    TV_TARGET_SSE42 static vec set1(const void* value) {
+        int64_t lane;
+        std::memcpy(&lane, value, sizeof(lane));
+        return _mm_xor_si128(_mm_set1_epi64x(lane), bias());
+    }
+    TV_TARGET_SSE42 static vec eq(vec a, vec b) {
+        return _mm_cmpeq_epi64(a, b);
+    }
+    TV_TARGET_SSE42 static vec lt(vec a, vec b) {
+        return _mm_cmpgt_epi64(b, a);
+    }
+    TV_TARGET_SSE42 static vec gt(vec a, vec b) {
+        return _mm_cmpgt_epi64(a, b);
+    }
+    TV_TARGET_SSE42 static vec in_range(vec x, vec low, vec high) {
+        return _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi64(low, x),
+            _mm_cmpgt_epi64(x, high)), _mm_set1_epi32(-1));
+    }
+    TV_TARGET_SSE42 static unsigned bits(vec mask) {
+        return static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(mask)));
+    }
+};
+
+template<>
+struct TSse42Ops<TLaneKind::I32> : TSse42Int32<false> {};
+template<>
+struct TSse42Ops<TLaneKind::U32> : TSse42Int32<true> {};
+template<>
+struct TSse42Ops<TLaneKind::I64> : TSse42Int64<false> {};
+template<>
+struct TSse42Ops<TLaneKind::U64> : TSse42Int64<true> {};
+
+template<>
+struct TSse42Ops<TLaneKind::F32> {
+    using vec = __m128;
+
+    TV_TARGET_SSE42 static vec load(const void* data) {
+        return _mm_loadu_ps(static_cast<const float*>(data));
+    }
+    TV_TARGET_SSE42 static vec set1(const void* value) {
+        return _mm_set1_ps(*static_cast<const float*>(value));
+    }
+    TV_TARGET_SSE42 static vec eq(vec a, vec b) {
+        return _mm_cmpeq_ps(a, b);
+    }
+    TV_TARGET_SSE42 static vec lt(vec a, vec b) {
+        return _mm_cmplt_ps(a, b);
+    }
+    TV_TARGET_SSE42 static vec gt(vec a, vec b) {
+        return _mm_cmpgt_ps(a, b);
+    }
+    TV_TARGET_SSE42 static vec in_range(vec x, vec low, vec high) {
+        return _mm_and_ps(_mm_cmpge_ps(x, low), _mm_cmple_ps(x, high));
+    }
+    TV_TARGET_SSE42 static unsigned bits(vec mask) {
+        return static_cast<unsigned>(_mm_movemask_ps(mask));
+    }
+};
+
+template<>
+struct TSse42Ops<TLaneKind::F64> {
+    using vec = __m128d;
+
+    TV_TARGET_SSE42 static vec load(const void* data) {
+        return _mm_loadu_pd(static_cast<const double*>(data));
+    }
+    TV_TARGET_SSE42 static vec set1(const void* value) {
+        return _mm_set1_pd(*static_cast<const double*>(value));
+    }
+    TV_TARGET_SSE42 static vec eq(vec a, vec b) {
+        return _mm_cmpeq_pd(a, b);
+    }
+    TV_TARGET_SSE42 static vec lt(vec a, vec b) {
+        return _mm_cmplt_pd(a, b);
+    }
+    TV_TARGET_SSE42 static vec gt(vec a, vec b) {
+        return _mm_cmpgt_pd(a, b);
+    }
+    TV_TARGET_SSE42 static vec in_range(vec x, vec low, vec high) {
+        return _mm_and_pd(_mm_cmpge_pd(x, low), _mm_cmple_pd(x, high));
+    }
+    TV_TARGET_SSE42 static unsigned bits(vec mask) {
+        return static_cast<unsigned>(_mm_movemask_pd(mask));
+    }
+};
+
+template<bool Unsigned>
+struct TAvx2Int32 {
+    using vec = __m256i;
+
+    TV_TARGET_AVX2 static vec bias() {
+        return _mm256_set1_epi32(Unsigned ? INT32_MIN : 0);
+    }
+    TV_TARGET_AVX2 static vec load(const void* data) {
+        return _mm256_xor_si256(
+            _mm256_loadu_si256(static_cast<const __m256i*>(data)), bias());
+    }
+    TV_TARGET_AVX2 static vec set1(const void* value) {
+        int32_t lane;
+        std::memcpy(&lane, value, sizeof(lane));
+        return _mm256_xor_si256(_mm256_set1_epi32(lane), bias());
+    }
+    TV_TARGET_AVX2 static vec eq(vec a, vec b) {
+        return _mm256_cmpeq_epi32(a, b);
+    }
+    TV_TARGET_AVX2 static vec lt(vec a, vec b) {
+        return _mm256_cmpgt_epi32(b, a);
+    }
+    TV_TARGET_AVX2 static vec gt(vec a, vec b) {
+        return _mm256_cmpgt_epi32(a, b);
+    }
+    TV_TARGET_AVX2 static vec in_range(vec x, vec low, vec high) {
+        return _mm256_andnot_si256(_mm256_or_si256(
+            _mm256_cmpgt_epi32(low, x), _mm256_cmpgt_epi32(x, high)),
+            _mm256_set1_epi32(-1));
+    }
+    TV_TARGET_AVX2 static unsigned bits(vec mask) {
+        return static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+    }
+};
+
+template<bool Unsigned>
+struct TAvx2Int64 {
+    using vec = __m256i;
+
+    TV_TARGET_AVX2 static vec bias() {
+        return _mm256_set1_epi64x(Unsigned ? INT64_MIN : 0);
+    }
+    TV_TARGET_AVX2 static vec load(const void* data) {
+        return _mm256_xor_si256(
+            _mm256_loadu_si256(static_cast<const __m256i*>(data)), bias());
+    }
+    TV_TARGET_AVX2 static vec set1(const void* value) {
+        int64_t lane;
+        std::memcpy(&lane, value, sizeof(lane));
+        return _mm256_xor_si256(_mm256_set1_epi64x(lane), bias());
+    }
+    TV_TARGET_AVX2 static vec eq(vec a, vec b) {
+        return _mm256_cmpeq_epi64(a, b);
+    }
+    TV_TARGET_AVX2 static vec lt(vec a, vec b) {
+        return _mm256_cmpgt_epi64(b, a);
+    }
+    TV_TARGET_AVX2 static vec gt(vec a, vec b) {
+        return _mm256_cmpgt_epi64(a, b);
+    }
+    TV_TARGET_AVX2 static vec in_range(vec x, vec low, vec high) {
+        return _mm256_andnot_si256(_mm256_or_si256(
+            _mm256_cmpgt_epi64(low, x), _mm256_cmpgt_epi64(x, high)),
+            _mm256_set1_epi32(-1));
+    }
+    TV_TARGET_AVX2 static unsigned bits(vec mask) {
+        return static_cast<unsigned>(
+            _mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+    }
+};
+
+template<>
+struct TAvx2Ops<TLaneKind::I32> : TAvx2Int32<false> {};
+template<>
+struct TAvx2Ops<TLaneKind::U32> : TAvx2Int32<true> {};
+template<>
+struct TAvx2Ops<TLaneKind::I64> : TAvx2Int64<false> {};
+template<>
+struct TAvx2Ops<TLaneKind::U64> : TAvx2Int64<true> {};
+
+template<>
+struct TAvx2Ops<TLaneKind::F32> {
+    using vec = __m256;
+
+    TV_TARGET_AVX2 static vec load(const void* data) {
+        return _mm256_loadu_ps(static_cast<const float*>(data));
+    }
+    TV_TARGET_AVX2 static vec set1(const void* value) {
+        return _mm256_set1_ps(*static_cast<const float*>(value));
+    }
+    TV_TARGET_AVX2 static vec eq(vec a, vec b) {
+        return _mm256_cmp_ps(a, b, _CMP_EQ_OQ);
+    }
+    TV_TARGET_AVX2 static vec lt(vec a, vec b) {
+        return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+    }
+    TV_TARGET_AVX2 static vec gt(vec a, vec b) {
+        return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+    }
+    TV_TARGET_AVX2 static vec in_range(vec x, vec low, vec high) {
+        return _mm256_and_ps(_mm256_cmp_ps(x, low, _CMP_GE_OQ),
+            _mm256_cmp_ps(x, high, _CMP_LE_OQ));
+    }
+    TV_TARGET_AVX2 static unsigned bits(vec mask) {
+        return static_cast<unsigned>(_mm256_movemask_ps(mask));
+    }
+};
+
+template<>
+struct TAvx2Ops<TLaneKind::F64> {
+    using vec = __m256d;
+
+    TV_TARGET_AVX2 static vec load(const void* data) {
+        return _mm256_loadu_pd(static_cast<const double*>(data));
+    }
+    TV_TARGET_AVX2 static vec set1(const void* value) {
+        return _mm256_set1_pd(*static_cast<const double*>(value));
+    }
+    TV_TARGET_AVX2 static vec eq(vec a, vec b) {
+        return _mm256_cmp_pd(a, b, _CMP_EQ_OQ);
+    }
+    TV_TARGET_AVX2 static vec lt(vec a, vec b) {
+        return _mm256_cmp_pd(a, b, _CMP_LT_OQ);
+    }
+    TV_TARGET_AVX2 static vec gt(vec a, vec b) {
+        return _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+    }
+    TV_TARGET_AVX2 static vec in_range(vec x, vec low, vec high) {
+        return _mm256_and_pd(_mm256_cmp_pd(x, low, _CMP_GE_OQ),
+            _mm256_cmp_pd(x, high, _CMP_LE_OQ));
+    }
+    TV_TARGET_AVX2 static unsigned bits(vec mask) {
+        return static_cast<unsigned>(_mm256_movemask_pd(mask));
+    }
+};
+
+// The same loop for both instruction sets; target attributes do not reach
+// into lambdas or helpers, so it is spelled out once per ISA.
+#define TV_SIMD_MATCH_LOOP(Ops, data, count, check)                         \
+    const std::size_t lanes = sizeof(typename Ops::vec) / sizeof(T);        \
+    typename Ops::vec first = Ops::set1(&check.first);                      \
+    typename Ops::vec second = Ops::set1(&check.second);                    \
+    uint64_t mask = 0;                                                      \
+    std::size_t i = 0;                                                      \
+                                                                            \
+    switch (check.op) {                                                     \
+    case TSearchOp::Equal:                                                  \
+        for (; i + lanes <= count; i += lanes) {                            \
+            mask |= static_cast<uint64_t>(Ops::bits(                        \
+                Ops::eq(Ops::load(data + i), first))) << i;                 \
+        }                                                                   \
+        break;                                                              \
+    case TSearchOp::Less:                                                   \
+        for (; i + lanes <= count; i += lanes) {                            \
+            mask |= static_cast<uint64_t>(Ops::bits(                        \
+                Ops::lt(Ops::load(data + i), first))) << i;                 \
+        }                                                                   \
+        break;                                                              \
+    case TSearchOp::Greater:                                                \
+        for (; i + lanes <= count; i += lanes) {                            \
+            mask |= static_cast<uint64_t>(Ops::bits(                        \
+                Ops::gt(Ops::load(data + i), first))) << i;                 \
+        }                                                                   \
+        break;                                                              \
+    default:                                                                \
+        for (; i + lanes <= count; i += lanes) {                            \
+            mask |= static_cast<uint64_t>(Ops::bits(                        \
+                Ops::in_range(Ops::load(data + i), first, second))) << i;   \
+        }                                                                   \
+        break;                                                              \
+    }                                                                       \
+                                                                            \
+    for (; i < count; i++) {                                                \
+        mask |= static_cast<uint64_t>(check(data[i]) ? 1 : 0) << i;         \
+    }                                                                       \
+                                                                            \
+    return mask
+
+template<typename T>
+TV_TARGET_SSE42 uint64_t tv_match_word_sse42(const T* data,
+    std::size_t count, const TSearchPredicate<T>& check) {
+    using Ops = TSse42Ops<TSimdLane<T>::value>;
+    TV_SIMD_MATCH_LOOP(Ops, data, count, check);
+}
+
+template<typename T>
+TV_TARGET_AVX2 uint64_t tv_match_word_avx2(const T* data,
+    std::size_t count, const TSearchPredicate<T>& check) {
+    using Ops = TAvx2Ops<TSimdLane<T>::value>;
+    TV_SIMD_MATCH_LOOP(Ops, data, count, check);
+}
+
+#undef TV_SIMD_MATCH_LOOP
+
+template<typename T>
+inline uint64_t tv_match_word_simd(TSimdLevel level, const T* data,
+    std::size_t count, const TSearchPredicate<T>& check, std::true_type) {
+    if (level == TSimdLevel::Avx2)
+        return tv_match_word_avx2(data, count, check);
+
+    if (level == TSimdLevel::Sse42)
+        return tv_match_word_sse42(data, count, check);
+
+    return tv_match_word_scalar(data, count, check);
+}
+
+#endif
+
+template<typename T>
+inline uint64_t tv_match_word_simd(TSimdLevel, const T* data,
+    std::size_t count, const TSearchPredicate<T>& check, std::false_type) {
+    return tv_match_word_scalar(data, count, check);
+}
+
+// Match mask of data[0, count), count <= 64, with the kernel of the given
+// level. Every element in the range is read.
+template<typename T>
+inline uint64_t tv_match_word(TSimdLevel level, const T* data,
+    std::size_t count, const TSearchPredicate<T>& check) {
+    return tv_match_word_simd(level, data, count, check,
+        std::integral_constant<bool, TV_SIMD_X86 &&
+        TSimdLane<T>::value != TLaneKind::None>());
+}
+
+// Calls check only on the slots set in busy, for callables and element
+// types without a kernel: their tombstones may hold no object.
+template<typename T, class Predicate>
+inline uint64_t tv_match_busy_slots(const T* data, uint64_t busy,
+    const Predicate& check) {
+    uint64_t mask = 0;
+
+    while (busy != 0) {
+        unsigned bit = tv_ctz(busy);
+        busy &= busy - 1;
+        mask |= static_cast<uint64_t>(check(data[bit]) ? 1 : 0) << bit;
+    }
+
+    return mask;
+}
+
+template<typename T, class Predicate>
+inline uint64_t tv_match_busy(const T* data, std::size_t, uint64_t busy,
+    const Predicate& check) {
+    return tv_match_busy_slots(data, busy, check);
+}
+
+// Vector kernels read the whole block, tombstones included: their bytes
+// are plain numbers and the busy word masks them out.
+template<typename T>
+inline uint64_t tv_match_busy(const T* data, std::size_t count, uint64_t busy,
+    const TSearchPredicate<T>& check) {
+    if (TSimdLane<T>::value == TLaneKind::None)
+        return tv_match_busy_slots(data, busy, check);
+
+    return tv_match_word(tv_simd_level(), data, count, check) & busy;
+}
+
+#pragma endregion SimdKernels
@@ -0,0 +1,524 @@
+// Copyright 2025 Chernykh Valentin
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "TVector.h"
+
+#pragma region SlotMap
+
+// Unordered container addressed by handles. A handle holds the slot in
+// its low 32 bits and the slot generation in the high ones; erase bumps
+// the generation, so handles to erased elements stop matching even
+// after the slot is reused. Slots live in fixed pages that are never
+// reallocated: an element stays at its address until it is erased.
+// Slot states use TVector's state map, Deleted marking freed slots, and
+// iteration skips the free ones a word of states at a time.
+template<typename T, class Allocator = std::allocator<T>>
+class TSlotMap {
+ private:
+    using allocator_traits = std::allocator_traits<Allocator>;
+    using word_allocator =
+        typename allocator_traits::template rebind_alloc<uint64_t>;
+    using state_map = TBasicStateMap<word_allocator>;
+
+ public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using allocator_type = Allocator;
+    using handle_type = uint64_t;
+
+    // Generations start at 1, so no element ever has the null handle.
+    static constexpr handle_type null_handle = 0;
+    static constexpr size_type page_slots = 1024;
+
+ private:
+    static constexpr size_type page_shift = 10;
+
+    Allocator _allocator;
+    std::vector<T*> _pages;
+    std::vector<uint32_t> _generations;
+    // Freed slots, the last freed reused first.
+    std::vector<uint32_t> _free;
+    state_map _states;
+    size_t _state_slots;
+    size_t _used;
+    size_t _size;
+
+ public:
+    // Walks the live elements in slot order.
+    template<class Map, typename Value>
+    class BasicIterator {
+     private:
+        Map* _map;
+        size_type _slot;
+
+     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TSlotMap::value_type;
+        using reference = Value&;
+        using pointer = Value*;
+        using difference_type = TSlotMap::difference_type;
+
+        BasicIterator(Map* map, size_type slot) noexcept
+            : _map(map), _slot(slot) {}
+
+        reference operator*() const { return _map->element(_slot); }
+        pointer operator->() const { return &_map->element(_slot); }
+
+        // Handle of the element the iterator points to.
+        handle_type handle() const noexcept {
+            return _map->make_handle(_slot);
+        }
+
+        BasicIterator& operator++() noexcept {
+            _slot = _map->_states.next_busy(_slot + 1, _map->_used);
+            return *this;
+        }
+
+        BasicIterator operator++(int) noexcept {
+            BasicIterator temp = *this;
+            ++*this;
+            return temp;
+        }
+
+        bool operator==(const BasicIterator& other) const noexcept {
+            return _map == other._map && _slot == other._slot;
+        }
+
+        bool operator!=(const BasicIterator& other) const noexcept {
+            return !(*this == other);
+        }
+    };
+
+    using Iterator = BasicIterator<TSlotMap, T>;
+    using ConstIterator = BasicIterator<const TSlotMap, const T>;
+
+    TSlotMap() noexcept;
+    explicit TSlotMap(const Allocator&) noexcept;
+    TSlotMap(const TSlotMap&);
+    TSlotMap(TSlotMap&&) noexcept;
+    ~TSlotMap() noexcept;
+
+    TSlotMap& operator=(const TSlotMap&);
+    TSlotMap& operator=(TSlotMap&&) noexcept;
+
+    inline TBasicStatesView<word_allocator> states() const noexcept;
+    inline allocator_type get_allocator() const noexcept;
+    inline size_type size() const noexcept;
+    inline size_type capacity() const noexcept;
+    inline bool is_empty() const noexcept;
+    inline Iterator begin() noexcept;
+    inline Iterator end() noexcept;
+    inline ConstIterator begin() const noexcept;
+    inline ConstIterator end() const noexcept;
+
+    handle_type insert(const value_type&);
+    handle_type insert(value_type&&);
+    template <class... Args>
+    handle_type emplace(Args&&... args);
+    bool erase(handle_type);
+    inline bool contains(handle_type) const noexcept;
+    inline pointer find(handle_type) noexcept;
+    inline const_pointer find(handle_type) const noexcept;
+    reference at(handle_type);
+    const_reference at(handle_type) const;
+    void reserve(size_type);
+    void clear() noexcept;
+
+ private:
+    inline T& element(size_type) const noexcept;
+    inline handle_type make_handle(size_type) const noexcept;
+    inline bool live(handle_type) const noexcept;
+    void release(size_type) noexcept;
+    void add_page();
+    void destroy_all() noexcept;
+    void free_pages() noexcept;
+    void copy_from(const TSlotMap&);
+};
+
+template<typename T, class A>
+constexpr typename TSlotMap<T, A>::handle_type TSlotMap<T, A>::null_handle;
+
+template<typename T, class A>
+constexpr typename TSlotMap<T, A>::size_type TSlotMap<T, A>::page_slots;
+
+template<typename T, class A>
+constexpr typename TSlotMap<T, A>::size_type TSlotMap<T, A>::page_shift;
+
+template<typename T, class A>
+TSlotMap<T, A>::TSlotMap() noexcept : TSlotMap(A()) {}
+
+template<typename T, class A>
+TSlotMap<T, A>::TSlotMap(const A& allocator) noexcept
+    : _allocator(allocator), _states(word_allocator(allocator)),
+_state_slots(0), _used(0), _size(0) {}
+
+template<typename T, class A>
+TSlotMap<T, A>::TSlotMap(const TSlotMap& other)
+    : TSlotMap(allocator_traits::select_on_container_copy_construction(
+        other._allocator)) {
+    copy_from(other);
+}
+
+template<typename T, class A>
+TSlotMap<T, A>::TSlotMap(TSlotMap&& other) noexcept
+    : _allocator(std::move(other._allocator)),
+_pages(std::move(other._pages)),
+_generations(std::move(other._generations)),
+_free(std::move(other._free)), _states(std::move(other._states)),
+_state_slots(other._state_slots), _used(other._used), _size(other._size) {
+    other._pages.clear();
+    other._generations.clear();
+    other._free.clear();
+    other._state_slots = 0;
+    other._used = 0;
+    other._size = 0;
+}
+
+template<typename T, class A>
+TSlotMap<T, A>::~TSlotMap() noexcept {
+    free_pages();
+}
+
+// Takes the slots and generations of other, so its handles address
+// the same elements here. Handles to the old elements must be dropped.
+template<typename T, class A>
+TSlotMap<T, A>& TSlotMap<T, A>::operator=(const TSlotMap& other) {
+    if (this != &other) {
+        free_pages();
+        copy_from(other);
+    }
+
+    return *this;
+}
+
+// Unequal allocators that do not propagate cannot hand the pages over,
+// the elements are copied instead, as TVector does.
+template<typename T, class A>
+TSlotMap<T, A>& TSlotMap<T, A>::operator=(TSlotMap&& other) noexcept {
+    if (this != &other) {
+        if (!allocator_traits::propagate_on_container_move_assignment::value
+            && !(_allocator == other._allocator))
+            return *this = other;
+
+        free_pages();
+
+        if (allocator_traits::propagate_on_container_move_assignment::value)
+            _allocator = std::move(other._allocator);
+
+        _pages = std::move(other._pages);
+        _generations = std::move(other._generations);
+        _free = std::move(other._free);
+        _states = std::move(other._states);
+        _state_slots = other._state_slots;
+        _used = other._used;
+        _size = other._size;
+        other._pages.clear();
+        other._generations.clear();
+        other._free.clear();
+        other._state_slots = 0;
+        other._used = 0;
+        other._size = 0;
+    }
+
+    return *this;
+}
+
+template<typename T, class A>
+inline TBasicStatesView<typename TSlotMap<T, A>::word_allocator>
+TSlotMap<T, A>::states() const noexcept {
+    return TBasicStatesView<word_allocator>(_states, _used);
+}
+
+template<typename T, class A>
+inline typename TSlotMap<T, A>::allocator_type
+TSlotMap<T, A>::get_allocator() const noexcept {
+    return _allocator;
+}
+
+template<typename T, class A>
+inline typename TSlotMap<T, A>::size_type
+TSlotMap<T, A>::size() const noexcept {
+    return _size;
+}
+
+template<typename T, class A>
+inline typename TSlotMap<T, A>::size_type
+TSlotMap<T, A>::capacity() const noexcept {
+    return _pages.size() * page_slots;
+}
+
+template<typename T, class A>
+inline bool TSlotMap<T, A>::is_empty() const noexcept {
+    return _size == 0;
+}
+
+template<typename T, class A>
+inline typename TSlotMap<T, A>::Iterator TSlotMap<T, A>::begin() noexcept {
+    return Iterator(this, _states.next_busy(0, _used));
+}
+
+template<typename T, class A>
+inline typename TSlotMap<T, A>::Iterator TSlotMap<T, A>::end() noexcept {
+    return Iterator(this, _used);
+}
+
+template<typename T, class A>
+inline typename TSlotMap<T, A>::ConstIterator
+TSlotMap<T, A>::begin() const noexcept {
+    return ConstIterator(this, _states.next_busy(0, _used));
+}
+
+template<typename T, class A>
+inline typename TSlotMap<T, A>::ConstIterator
+TSlotMap<T, A>::end() const noexcept {
+    return ConstIterator(this, _used);
+}
+
+template<typename T, class A>
+typename TSlotMap<T, A>::handle_type
+TSlotMap<T, A>::insert(const value_type& value) {
+    return emplace(value);
+}
+
+template<typename T, class A>
+typename TSlotMap<T, A>::handle_type
+TSlotMap<T, A>::insert(value_type&& value) {
+    return emplace(std::move(value));
+}
+
+// Builds the element in the last freed slot, or in a new one when none
+// is free, and returns its handle. If the constructor throws the map is
+// unchanged.
+template<typename T, class A>
+template<class... Args>
+typename TSlotMap<T, A>::handle_type TSlotMap<T, A>::emplace(Args&&... args) {
+    if (_free.empty() && _used == capacity())
+        add_page();
+
+    size_type slot = _free.empty() ? _used : _free.back();
+    new (&element(slot)) T(std::forward<Args>(args)...);
+
+    if (slot == _used) {
+        _generations.push_back(1);
+        _used++;
+    } else {
+        _free.pop_back();
+    }
+
+    _states.write(slot, Busy);
+    _size++;
+
+    return make_handle(slot);
+}
+
+// Destroys the element of handle. Returns false when the handle is
+// stale or null.
+template<typename T, class A>
+bool TSlotMap<T, A>::erase(handle_type handle) {
+    if (!live(handle))
+        return false;
+
+    size_type slot = static_cast<uint32_t>(handle);
+    element(slot).~T();
+    release(slot);
+    _size--;
+
+    return true;
+}
+
+template<typename T, class A>
+inline bool TSlotMap<T, A>::contains(handle_type handle) const noexcept {
+    return live(handle);
+}
+
+// The element of handle, nullptr when the handle is stale.
+template<typename T, class A>
+inline typename TSlotMap<T, A>::pointer
+TSlotMap<T, A>::find(handle_type handle) noexcept {
+    return live(handle) ? &element(static_cast<uint32_t>(handle)) : nullptr;
+}
+
+template<typename T, class A>
+inline typename TSlotMap<T, A>::const_pointer
+TSlotMap<T, A>::find(handle_type handle) const noexcept {
+    return live(handle) ? &element(static_cast<uint32_t>(handle)) : nullptr;
+}
+
+template<typename T, class A>
+typename TSlotMap<T, A>::reference TSlotMap<T, A>::at(handle_type handle) {
+    if (!live(handle))
+        throw std::out_of_range("TSlotMap at: Stale handle.");
+
+    return element(static_cast<uint32_t>(handle));
+}
+
+template<typename T, class A>
+typename TSlotMap<T, A>::const_reference
+TSlotMap<T, A>::at(handle_type handle) const {
+    if (!live(handle))
+        throw std::out_of_range("TSlotMap at: Stale handle.");
+
+    return element(static_cast<uint32_t>(handle));
+}
+
+// Allocates the pages for count elements up front.
+template<typename T, class A>
+void TSlotMap<T, A>::reserve(size_type count) {
+    while (capacity() < count) {
+        add_page();
+    }
+}
+
+// Destroys the elements and keeps the pages. Every handle goes stale.
+template<typename T, class A>
+void TSlotMap<T, A>::clear() noexcept {
+    destroy_all();
+    _size = 0;
+}
+
+template<typename T, class A>
+inline T& TSlotMap<T, A>::element(size_type slot) const noexcept {
+    return _pages[slot >> page_shift][slot & (page_slots - 1)];
+}
+
+template<typename T, class A>
+inline typename TSlotMap<T, A>::handle_type
+TSlotMap<T, A>::make_handle(size_type slot) const noexcept {
+    return (static_cast<handle_type>(_generations[slot]) << 32) | slot;
+}
+
+// A generation only matches while its slot is busy: erase bumps it,
+// and generation 0 belongs to retired slots and the null handle.
+template<typename T, class A>
+inline bool TSlotMap<T, A>::live(handle_type handle) const noexcept {
+    size_type slot = static_cast<uint32_t>(handle);
+    uint32_t generation = static_cast<uint32_t>(handle >> 32);
+    return slot < _used && generation != 0 &&
+        _generations[slot] == generation;
+}
+
+// Frees a slot whose element is already destroyed. A slot whose
+// generation wraps around is retired instead of reused, so an old
+// handle can never match it again. _free has room for every slot, so
+// the push never allocates.
+template<typename T, class A>
+void TSlotMap<T, A>::release(size_type slot) noexcept {
+    _states.write(slot, Deleted);
+
+    if (++_generations[slot] != 0)
+        _free.push_back(static_cast<uint32_t>(slot));
+}
+
+// Adds a page of slots. Pages are never moved; only the state map is
+// copied, into one twice as large, when it runs out, and the generation
+// and free lists are reserved to the same size with it. Everything that
+// can throw is built aside first, so a throw leaves the map unchanged.
+template<typename T, class A>
+void TSlotMap<T, A>::add_page() {
+    if (uint64_t(capacity()) + page_slots > (uint64_t(1) << 32))
+        throw std::length_error("TSlotMap: Too many slots.");
+
+    size_type slots = _state_slots;
+    state_map states{word_allocator(_allocator)};
+    T* page = allocator_traits::allocate(_allocator, page_slots);
+
+    try {
+        if (capacity() + page_slots > _state_slots) {
+            slots = _state_slots == 0 ? page_slots : 2 * _state_slots;
+            states = state_map(slots, word_allocator(_allocator));
+
+            for (size_type i = 0; i < _used; i++) {
+                states.write(i, _states.get(i));
+            }
+
+            _generations.reserve(slots);
+            _free.reserve(slots);
+        }
+
+        if (_pages.size() == _pages.capacity())
+            _pages.reserve(2 * _pages.size() + 1);
+    } catch (...) {
+        allocator_traits::deallocate(_allocator, page, page_slots);
+        throw;
+    }
+
+    _pages.push_back(page);
+
+    if (slots != _state_slots) {
+        _states = std::move(states);
+        _state_slots = slots;
+    }
+}
+
+// Destroys the elements and frees their slots, for clear(): the pages
+// stay and every handle goes stale.
+template<typename T, class A>
+void TSlotMap<T, A>::destroy_all() noexcept {
+    for (size_type i = _states.next_busy(0, _used); i < _used;
+        i = _states.next_busy(i + 1, _used)) {
+        if (!std::is_trivially_destructible<T>::value)
+            element(i).~T();
+
+        release(i);
+    }
+}
+
+// Destroys the elements and frees the pages, without the slot
+// bookkeeping of destroy_all().
+template<typename T, class A>
+void TSlotMap<T, A>::free_pages() noexcept {
+    if (!std::is_trivially_destructible<T>::value) {
+        for (size_type i = _states.next_busy(0, _used); i < _used;
+            i = _states.next_busy(i + 1, _used)) {
+            element(i).~T();
+        }
+    }
+
+    for (T* page : _pages) {
+        allocator_traits::deallocate(_allocator, page, page_slots);
+    }
+
+    _pages.clear();
+    _generations.clear();
+    _free.clear();
+    _states = state_map(word_allocator(_allocator));
+    _state_slots = 0;
+    _used = 0;
+    _size = 0;
+}
+
+// Takes the slots, generations and elements of other into this map,
+// which has no pages.
+template<typename T, class A>
+void TSlotMap<T, A>::copy_from(const TSlotMap& other) {
+    reserve(other._used);
+    _generations = other._generations;
+
+    for (size_type i = 0; i < other._used; i++) {
+        if (other._states.busy(i))
+            new (&element(i)) T(other.element(i));
+
+        _states.write(i, other._states.get(i));
+        _used = i + 1;
+        _size += other._states.busy(i) ? 1 : 0;
+    }
+
+    _free = other._free;
+}
+
+#pragma endregion SlotMap
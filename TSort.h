@@ -0,0 +1,786 @@
+// Copyright 2025 Chernykh Valentin
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "TThreadPool.h"
+
+// Sorting engines over contiguous ranges [begin, end) of T*. TVector's
+// sort family compacts the vector and runs them on its dense storage.
+// Comparators are template parameters so calls inline.
+
+#pragma region PatternDefeatingQuicksort
+
+// Pattern-defeating quicksort (pdqsort): introsort with a median-of-3 or
+// ninther pivot, insertion sort for small partitions, detection of
+// already partitioned ranges, shuffles against bad patterns and a
+// heapsort fallback after log2(n) unbalanced partitions, so the worst
+// case stays O(n log n) with O(log n) recursion depth.
+constexpr std::ptrdiff_t tv_insertion_sort_threshold = 24;
+constexpr std::ptrdiff_t tv_ninther_threshold = 128;
+constexpr std::ptrdiff_t tv_partial_insertion_sort_limit = 8;
+constexpr std::size_t tv_partition_block = 64;
+
+inline int tv_log2(std::ptrdiff_t size) noexcept {
+    int log2 = 0;
+
+    for (; size > 1; size >>= 1) {
+        log2++;
+    }
+
+    return log2;
+}
+
+template<typename T, class Compare>
+inline void tv_sort2(T* a, T* b, Compare& comp) {
+    if (comp(*b, *a))
+        std::iter_swap(a, b);
+}
+
+template<typename T, class Compare>
+inline void tv_sort3(T* a, T* b, T* c, Compare& comp) {
+    tv_sort2(a, b, comp);
+    tv_sort2(b, c, comp);
+    tv_sort2(a, b, comp);
+}
+
+template<typename T, class Compare>
+void tv_insertion_sort(T* begin, T* end, Compare& comp) {
+    if (begin == end)
+        return;
+
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+
+        if (comp(*sift, *sift_1)) {
+            T tmp = std::move(*sift);
+
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (sift != begin && comp(tmp, *--sift_1));
+
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Same as tv_insertion_sort, but *(begin - 1) must not be greater than any
+// element of the range, which removes the bounds check from the inner loop.
+template<typename T, class Compare>
+void tv_unguarded_insertion_sort(T* begin, T* end, Compare& comp) {
+    if (begin == end)
+        return;
+
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+
+        if (comp(*sift, *sift_1)) {
+            T tmp = std::move(*sift);
+
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (comp(tmp, *--sift_1));
+
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Insertion sort that gives up after tv_partial_insertion_sort_limit moves.
+// Returns true when the range ended up sorted.
+template<typename T, class Compare>
+bool tv_partial_insertion_sort(T* begin, T* end, Compare& comp) {
+    if (begin == end)
+        return true;
+
+    std::ptrdiff_t limit = 0;
+
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+
+        if (comp(*sift, *sift_1)) {
+            T tmp = std::move(*sift);
+
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (sift != begin && comp(tmp, *--sift_1));
+
+            *sift = std::move(tmp);
+            limit += cur - sift;
+        }
+
+        if (limit > tv_partial_insertion_sort_limit)
+            return false;
+    }
+
+    return true;
+}
+
+// Moves the pivot to *begin: median of three, or the ninther (median of
+// three medians) for big ranges. The samples also guard the partition
+// loops, so the range must hold at least tv_insertion_sort_threshold.
+template<typename T, class Compare>
+inline void tv_choose_pivot(T* begin, T* end, Compare& comp) {
+    std::ptrdiff_t size = end - begin;
+    std::ptrdiff_t half = size / 2;
+
+    if (size > tv_ninther_threshold) {
+        tv_sort3(begin, begin + half, end - 1, comp);
+        tv_sort3(begin + 1, begin + (half - 1), end - 2, comp);
+        tv_sort3(begin + 2, begin + (half + 1), end - 3, comp);
+        tv_sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+        std::iter_swap(begin, begin + half);
+    } else {
+        tv_sort3(begin + half, begin, end - 1, comp);
+    }
+}
+
+// Partitions [begin, end) around the pivot *begin: elements less than the
+// pivot go left, the rest right. Returns the final pivot position and
+// whether the range was already partitioned.
+template<typename T, class Compare>
+std::pair<T*, bool> tv_partition_right(T* begin, T* end, Compare& comp) {
+    T pivot(std::move(*begin));
+    T* first = begin;
+    T* last = end;
+
+    while (comp(*++first, pivot)) {}
+
+    if (first - 1 == begin) {
+        while (first < last && !comp(*--last, pivot)) {}
+    } else {
+        while (!comp(*--last, pivot)) {}
+    }
+
+    bool already_partitioned = first >= last;
+
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(*++first, pivot)) {}
+        while (!comp(*--last, pivot)) {}
+    }
+
+    T* pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+
+    return std::make_pair(pivot_pos, already_partitioned);
+}
+
+// Moves num misplaced pairs found by the block partition. A cyclic
+// permutation halves the moves, plain swaps keep descending inputs O(n).
+template<typename T>
+void tv_swap_offsets(T* first, T* last, const unsigned char* offsets_l,
+    const unsigned char* offsets_r, std::size_t num, bool use_swaps) {
+    if (use_swaps) {
+        for (std::size_t i = 0; i < num; i++) {
+            std::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+        }
+    } else if (num > 0) {
+        T* l = first + offsets_l[0];
+        T* r = last - offsets_r[0];
+        T tmp(std::move(*l));
+        *l = std::move(*r);
+
+        for (std::size_t i = 1; i < num; i++) {
+            l = first + offsets_l[i];
+            *r = std::move(*l);
+            r = last - offsets_r[i];
+            *l = std::move(*r);
+        }
+
+        *r = std::move(tmp);
+    }
+}
+
+// tv_partition_right without data-dependent branches in the scan: blocks
+// of comparison results are recorded as offsets first and swapped after
+// (BlockQuicksort), which avoids branch mispredictions on cheap compares.
+template<typename T, class Compare>
+std::pair<T*, bool> tv_partition_right_branchless(T* begin, T* end,
+    Compare& comp) {
+    T pivot(std::move(*begin));
+    T* first = begin;
+    T* last = end;
+
+    while (comp(*++first, pivot)) {}
+
+    if (first - 1 == begin) {
+        while (first < last && !comp(*--last, pivot)) {}
+    } else {
+        while (!comp(*--last, pivot)) {}
+    }
+
+    bool already_partitioned = first >= last;
+
+    if (!already_partitioned) {
+        std::iter_swap(first, last);
+        ++first;
+
+        unsigned char offsets_l[tv_partition_block];
+        unsigned char offsets_r[tv_partition_block];
+        T* offsets_l_base = first;
+        T* offsets_r_base = last;
+        std::size_t num_l = 0;
+        std::size_t num_r = 0;
+        std::size_t start_l = 0;
+        std::size_t start_r = 0;
+
+        while (first < last) {
+            std::size_t num_unknown = last - first;
+            std::size_t left_split = num_l == 0 ?
+                (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+            std::size_t right_split = num_r == 0 ?
+                num_unknown - left_split : 0;
+
+            if (left_split > tv_partition_block)
+                left_split = tv_partition_block;
+
+            if (right_split > tv_partition_block)
+                right_split = tv_partition_block;
+
+            for (std::size_t i = 0; i < left_split; i++) {
+                offsets_l[num_l] = static_cast<unsigned char>(i);
+                num_l += !comp(*first, pivot);
+                ++first;
+            }
+
+            for (std::size_t i = 0; i < right_split; i++) {
+                offsets_r[num_r] = static_cast<unsigned char>(i + 1);
+                num_r += comp(*--last, pivot);
+            }
+
+            std::size_t num = num_l < num_r ? num_l : num_r;
+            tv_swap_offsets(offsets_l_base, offsets_r_base,
+                offsets_l + start_l, offsets_r + start_r, num, num_l == num_r);
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+
+            if (num_l == 0) {
+                start_l = 0;
+                offsets_l_base = first;
+            }
+
+            if (num_r == 0) {
+                start_r = 0;
+                offsets_r_base = last;
+            }
+        }
+
+        if (num_l > 0) {
+            while (num_l--) {
+                std::iter_swap(offsets_l_base + offsets_l[start_l + num_l],
+                    --last);
+            }
+
+            first = last;
+        }
+
+        if (num_r > 0) {
+            while (num_r--) {
+                std::iter_swap(offsets_r_base - offsets_r[start_r + num_r],
+                    first);
+                ++first;
+            }
+
+            last = first;
+        }
+    }
+
+    T* pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+
+    return std::make_pair(pivot_pos, already_partitioned);
+}
+
+// Puts every element equal to the pivot *begin to its left part, used when
+// the pivot equals the element before the range (many duplicates).
+template<typename T, class Compare>
+T* tv_partition_left(T* begin, T* end, Compare& comp) {
+    T pivot(std::move(*begin));
+    T* first = begin;
+    T* last = end;
+
+    while (comp(pivot, *--last)) {}
+
+    if (last + 1 == end) {
+        while (first < last && !comp(pivot, *++first)) {}
+    } else {
+        while (!comp(pivot, *++first)) {}
+    }
+
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(pivot, *--last)) {}
+        while (!comp(pivot, *++first)) {}
+    }
+
+    T* pivot_pos = last;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+
+    return pivot_pos;
+}
+
+template<typename T, class Compare>
+inline std::pair<T*, bool> tv_partition_right(T* begin, T* end,
+    Compare& comp, std::true_type) {
+    return tv_partition_right_branchless(begin, end, comp);
+}
+
+template<typename T, class Compare>
+inline std::pair<T*, bool> tv_partition_right(T* begin, T* end,
+    Compare& comp, std::false_type) {
+    return tv_partition_right(begin, end, comp);
+}
+
+template<typename T, class Compare>
+void tv_pdqsort_loop(T* begin, T* end, Compare& comp, int bad_allowed,
+    bool leftmost) {
+    using branchless = std::integral_constant<bool,
+        std::is_arithmetic<T>::value || std::is_pointer<T>::value>;
+
+    for (;;) {
+        std::ptrdiff_t size = end - begin;
+
+        if (size < tv_insertion_sort_threshold) {
+            if (leftmost)
+                tv_insertion_sort(begin, end, comp);
+            else
+                tv_unguarded_insertion_sort(begin, end, comp);
+
+            return;
+        }
+
+        tv_choose_pivot(begin, end, comp);
+
+        if (!leftmost && !comp(*(begin - 1), *begin)) {
+            begin = tv_partition_left(begin, end, comp) + 1;
+            continue;
+        }
+
+        std::pair<T*, bool> part = tv_partition_right(begin, end, comp,
+            branchless());
+        T* pivot_pos = part.first;
+        std::ptrdiff_t l_size = pivot_pos - begin;
+        std::ptrdiff_t r_size = end - (pivot_pos + 1);
+
+        if (l_size < size / 8 || r_size < size / 8) {
+            if (--bad_allowed == 0) {
+                std::make_heap(begin, end, comp);
+                std::sort_heap(begin, end, comp);
+                return;
+            }
+
+            if (l_size >= tv_insertion_sort_threshold) {
+                std::iter_swap(begin, begin + l_size / 4);
+                std::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+
+                if (l_size > tv_ninther_threshold) {
+                    std::iter_swap(begin + 1, begin + (l_size / 4 + 1));
+                    std::iter_swap(begin + 2, begin + (l_size / 4 + 2));
+                    std::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                    std::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                }
+            }
+
+            if (r_size >= tv_insertion_sort_threshold) {
+                std::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                std::iter_swap(end - 1, end - r_size / 4);
+
+                if (r_size > tv_ninther_threshold) {
+                    std::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                    std::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                    std::iter_swap(end - 2, end - (1 + r_size / 4));
+                    std::iter_swap(end - 3, end - (2 + r_size / 4));
+                }
+            }
+        } else if (part.second &&
+            tv_partial_insertion_sort(begin, pivot_pos, comp) &&
+            tv_partial_insertion_sort(pivot_pos + 1, end, comp)) {
+            return;
+        }
+
+        tv_pdqsort_loop(begin, pivot_pos, comp, bad_allowed, leftmost);
+        begin = pivot_pos + 1;
+        leftmost = false;
+    }
+}
+
+template<typename T, class Compare>
+void tv_pdqsort(T* begin, T* end, Compare comp) {
+    if (end - begin < 2)
+        return;
+
+    tv_pdqsort_loop(begin, end, comp, tv_log2(end - begin), true);
+}
+
+#pragma endregion PatternDefeatingQuicksort
+
+#pragma region ParallelSort
+
+// Ranges below this many elements are sorted by a single pdqsort task.
+constexpr std::ptrdiff_t tv_parallel_sort_grain = 16384;
+
+// Parallel pdqsort: partitions serially, hands the left part to the pool
+// and keeps partitioning the right part. Runs of keys equal to an earlier
+// pivot are split off with tv_partition_left as pdqsort does, ranges that
+// keep partitioning badly are finished by the serial pdqsort.
+template<typename T, class Compare>
+void tv_parallel_pdqsort_loop(T* begin, T* end, Compare& comp,
+    TTaskGroup& group, int bad_allowed, bool leftmost) {
+    using branchless = std::integral_constant<bool,
+        std::is_arithmetic<T>::value || std::is_pointer<T>::value>;
+
+    while (end - begin > tv_parallel_sort_grain) {
+        std::ptrdiff_t size = end - begin;
+        tv_choose_pivot(begin, end, comp);
+
+        if (!leftmost && !comp(*(begin - 1), *begin)) {
+            begin = tv_partition_left(begin, end, comp) + 1;
+            continue;
+        }
+
+        T* pivot_pos = tv_partition_right(begin, end, comp,
+            branchless()).first;
+        std::ptrdiff_t l_size = pivot_pos - begin;
+        std::ptrdiff_t r_size = end - (pivot_pos + 1);
+
+        if ((l_size < size / 8 || r_size < size / 8) && --bad_allowed == 0) {
+            tv_pdqsort(begin, end, comp);
+            return;
+        }
+
+        T* left = begin;
+        group.run([left, pivot_pos, &comp, &group, bad_allowed, leftmost] {
+            tv_parallel_pdqsort_loop(left, pivot_pos, comp, group,
+                bad_allowed, leftmost);
+        });
+
+        begin = pivot_pos + 1;
+        leftmost = false;
+    }
+
+    tv_pdqsort(begin, end, comp);
+}
+
+// Sorts [begin, end) on the pool's workers and the calling thread. comp
+// is shared by every thread and must be safe to call concurrently.
+template<typename T, class Compare>
+void tv_parallel_pdqsort(T* begin, T* end, Compare comp, TThreadPool& pool) {
+    if (end - begin < 2)
+        return;
+
+    TTaskGroup group(pool);
+    tv_parallel_pdqsort_loop(begin, end, comp, group, tv_log2(end - begin),
+        true);
+    group.wait();
+}
+
+#pragma endregion ParallelSort
+
+#pragma region SelectionAndMerge
+
+// Quickselect on the pdqsort partitions: afterwards *nth is the element a
+// full sort would put there, [begin, nth) holds nothing greater and
+// (nth, end) nothing less. Keys equal to an earlier pivot are split off
+// with tv_partition_left, after log2(n) unbalanced partitions the rest is
+// handed to std::nth_element, so the expected cost stays O(n).
+template<typename T, class Compare>
+void tv_select(T* begin, T* nth, T* end, Compare comp) {
+    using branchless = std::integral_constant<bool,
+        std::is_arithmetic<T>::value || std::is_pointer<T>::value>;
+
+    if (nth >= end || end - begin < 2)
+        return;
+
+    T* first = begin;
+    int bad_allowed = tv_log2(end - begin);
+
+    while (end - begin >= tv_insertion_sort_threshold) {
+        std::ptrdiff_t size = end - begin;
+        tv_choose_pivot(begin, end, comp);
+
+        if (begin != first && !comp(*(begin - 1), *begin)) {
+            T* equal_end = tv_partition_left(begin, end, comp) + 1;
+
+            if (nth < equal_end)
+                return;
+
+            begin = equal_end;
+            continue;
+        }
+
+        T* pivot_pos = tv_partition_right(begin, end, comp,
+            branchless()).first;
+
+        if (pivot_pos == nth)
+            return;
+
+        std::ptrdiff_t l_size = pivot_pos - begin;
+        std::ptrdiff_t r_size = end - (pivot_pos + 1);
+
+        if ((l_size < size / 8 || r_size < size / 8) && --bad_allowed == 0) {
+            std::nth_element(begin, nth, end, comp);
+            return;
+        }
+
+        if (nth < pivot_pos)
+            end = pivot_pos;
+        else
+            begin = pivot_pos + 1;
+    }
+
+    tv_insertion_sort(begin, end, comp);
+}
+
+// Destroys [begin, end) unless released, for buffers filled by placement
+// new that a throwing comparator could leave behind.
+template<typename T>
+struct TDestroyGuard {
+    T* begin;
+    T* end;
+
+    ~TDestroyGuard() {
+        for (T* it = begin; it != end; ++it) {
+            it->~T();
+        }
+    }
+};
+
+// Runs this short are insertion sorted before merging.
+constexpr std::ptrdiff_t tv_merge_sort_run = 32;
+
+// Merges the sorted runs [begin, middle) and [middle, end): the left run
+// is moved into the raw buffer and merged back. Ties take the left
+// element, which keeps the merge stable.
+template<typename T, class Compare>
+void tv_merge_with_buffer(T* begin, T* middle, T* end, T* buffer,
+    Compare& comp) {
+    TDestroyGuard<T> guard = { buffer, buffer };
+
+    for (T* it = begin; it != middle; ++it, ++guard.end) {
+        ::new (static_cast<void*>(guard.end)) T(std::move(*it));
+    }
+
+    T* left = buffer;
+    T* right = middle;
+    T* out = begin;
+
+    while (left != guard.end && right != end) {
+        if (comp(*right, *left))
+            *out++ = std::move(*right++);
+        else
+            *out++ = std::move(*left++);
+    }
+
+    std::move(left, guard.end, out);
+}
+
+template<typename T, class Compare>
+void tv_merge_sort_loop(T* begin, T* end, T* buffer, Compare& comp) {
+    if (end - begin <= tv_merge_sort_run) {
+        tv_insertion_sort(begin, end, comp);
+        return;
+    }
+
+    T* middle = begin + (end - begin) / 2;
+    tv_merge_sort_loop(begin, middle, buffer, comp);
+    tv_merge_sort_loop(middle, end, buffer, comp);
+
+    if (comp(*middle, *(middle - 1)))
+        tv_merge_with_buffer(begin, middle, end, buffer, comp);
+}
+
+// Stable top-down merge sort. buffer is raw storage for (end - begin) / 2
+// elements; already ordered neighbouring runs are not merged, so sorted
+// input costs O(n) comparisons.
+template<typename T, class Compare>
+void tv_merge_sort(T* begin, T* end, T* buffer, Compare comp) {
+    tv_merge_sort_loop(begin, end, buffer, comp);
+}
+
+#pragma endregion SelectionAndMerge
+
+#pragma region RadixSort
+
+// Maps arithmetic keys to unsigned integers with the same order: signed
+// integers get the sign bit flipped, IEEE floats get every bit flipped
+// when negative and only the sign bit otherwise. Types without a mapping
+// (long double, user types) have enabled == false.
+template<typename T, class Enable = void>
+struct TRadixKey {
+    static constexpr bool enabled = false;
+};
+
+template<std::size_t Size>
+struct TRadixBits;
+
+template<>
+struct TRadixBits<4> {
+    using type = uint32_t;
+};
+
+template<>
+struct TRadixBits<8> {
+    using type = uint64_t;
+};
+
+template<>
+struct TRadixKey<bool> {
+    static constexpr bool enabled = true;
+    using type = unsigned char;
+
+    static type map(bool value) noexcept {
+        return value ? 1 : 0;
+    }
+};
+
+template<typename T>
+struct TRadixKey<T, typename std::enable_if<std::is_integral<T>::value &&
+    !std::is_same<T, bool>::value>::type> {
+    static constexpr bool enabled = true;
+    using type = typename std::make_unsigned<T>::type;
+
+    static type map(T value) noexcept {
+        const type sign = std::is_signed<T>::value ?
+            static_cast<type>(type(1) << (sizeof(T) * 8 - 1)) : type(0);
+        return static_cast<type>(static_cast<type>(value) ^ sign);
+    }
+};
+
+template<typename T>
+struct TRadixKey<T, typename std::enable_if<
+    std::is_floating_point<T>::value && std::numeric_limits<T>::is_iec559 &&
+    (sizeof(T) == 4 || sizeof(T) == 8)>::type> {
+    static constexpr bool enabled = true;
+    using type = typename TRadixBits<sizeof(T)>::type;
+
+    static type map(T value) noexcept {
+        const type sign = type(1) << (sizeof(T) * 8 - 1);
+        type bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        return bits ^ (bits & sign ? ~type(0) : sign);
+    }
+};
+
+// Radix sort replaces the comparison sort when the elements have a key
+// mapping and the comparator is the default ascending order.
+template<typename T, class Compare>
+struct TRadixSortable : std::integral_constant<bool, TRadixKey<T>::enabled &&
+    (std::is_same<Compare, std::less<T>>::value ||
+    std::is_same<Compare, std::less<>>::value)> {};
+
+// Below this size the histograms cost more than pdqsort does.
+constexpr std::size_t tv_radix_sort_threshold = 256;
+
+struct TRadixIdentity {
+    template<typename T>
+    const T& operator()(const T& value) const noexcept {
+        return value;
+    }
+};
+
+// LSD radix sort of [begin, end) by the arithmetic key(element), stable
+// and ascending. Keys up to 16 bits use 8-bit digits, wider keys 11-bit
+// digits (3 passes for 32 bits, 6 for 64). All histograms are built in one
+// scan and passes whose digit is equal for every element are skipped.
+// buffer is raw storage for end - begin elements; elements are relocated
+// between it and the range, so T must be nothrow move constructible.
+// A key that may throw is called once per element, in the histogram scan
+// before anything moves, and the mapped keys travel with the elements.
+template<typename T, class Key>
+void tv_lsd_radix_sort(T* begin, T* end, T* buffer, Key key) {
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+        "radix sort relocates elements and needs a noexcept move");
+
+    using key_traits = TRadixKey<typename std::decay<
+        decltype(key(*begin))>::type>;
+    using key_type = typename key_traits::type;
+
+    const std::size_t key_bits = sizeof(key_type) * 8;
+    const std::size_t digit_bits = sizeof(key_type) <= 2 ? 8 : 11;
+    const std::size_t passes = (key_bits + digit_bits - 1) / digit_bits;
+    const std::size_t radix = std::size_t(1) << digit_bits;
+    const std::size_t mask = radix - 1;
+    const std::size_t size = static_cast<std::size_t>(end - begin);
+
+    if (size < 2)
+        return;
+
+    const bool cached = !noexcept(key(*begin));
+    std::unique_ptr<key_type[]> keys(cached ? new key_type[2 * size] : nullptr);
+    key_type* keys_from = keys.get();
+    key_type* keys_to = keys.get() + size * cached;
+    std::size_t counts[passes][radix];
+    std::memset(counts, 0, sizeof(counts));
+
+    for (T* it = begin; it != end; ++it) {
+        key_type mapped = key_traits::map(key(*it));
+
+        if (cached)
+            keys_from[it - begin] = mapped;
+
+        for (std::size_t pass = 0; pass < passes; pass++) {
+            counts[pass][(mapped >> (pass * digit_bits)) & mask]++;
+        }
+    }
+
+    T* from = begin;
+    T* to = buffer;
+
+    for (std::size_t pass = 0; pass < passes; pass++) {
+        std::size_t* count = counts[pass];
+        std::size_t shift = pass * digit_bits;
+        std::size_t offset = 0;
+        bool trivial = false;
+
+        for (std::size_t digit = 0; digit < radix; digit++) {
+            std::size_t bucket = count[digit];
+            trivial = trivial || bucket == size;
+            count[digit] = offset;
+            offset += bucket;
+        }
+
+        if (trivial)
+            continue;
+
+        for (std::size_t i = 0; i < size; i++) {
+            key_type mapped =
+                cached ? keys_from[i] : key_traits::map(key(from[i]));
+            std::size_t slot = count[(mapped >> shift) & mask]++;
+            ::new (static_cast<void*>(to + slot)) T(std::move(from[i]));
+            from[i].~T();
+
+            if (cached)
+                keys_to[slot] = mapped;
+        }
+
+        std::swap(from, to);
+        std::swap(keys_from, keys_to);
+    }
+
+    if (from != begin) {
+        for (std::size_t i = 0; i < size; i++) {
+            ::new (static_cast<void*>(begin + i)) T(std::move(from[i]));
+            from[i].~T();
+        }
+    }
+}
+
+#pragma endregion RadixSort
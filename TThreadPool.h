@@ -0,0 +1,286 @@
+// Copyright 2025 Chernykh Valentin
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#pragma region ThreadPool
+
+// Small work-stealing pool for fork-join algorithms. Every worker owns a
+// deque: it pushes and pops its own tasks at the back (LIFO, cache warm)
+// and steals from the front of the others' deques when it runs dry.
+// Threads outside the pool submit round-robin and may help run tasks
+// while they wait, see TTaskGroup. Objects that keep a pointer to the
+// pool between calls attach to it and must detach before it is
+// destroyed; a debug build asserts that none is left.
+class TThreadPool {
+ private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::mutex _sleep_mutex;
+    std::condition_variable _wake;
+    std::atomic<std::size_t> _queued;
+    std::atomic<std::size_t> _next_queue;
+    std::atomic<std::size_t> _attached;
+    bool _stop;
+
+    static inline TThreadPool*& current_pool() noexcept;
+    static inline std::size_t& current_index() noexcept;
+
+    bool pop(std::size_t, std::function<void()>&);
+    void work(std::size_t);
+
+ public:
+    explicit TThreadPool(std::size_t threads =
+        std::thread::hardware_concurrency());
+    TThreadPool(const TThreadPool&) = delete;
+    ~TThreadPool() noexcept;
+
+    TThreadPool& operator=(const TThreadPool&) = delete;
+
+    void submit(std::function<void()>);
+    bool run_one();
+    inline std::size_t size() const noexcept;
+    inline void attach() noexcept;
+    inline void detach() noexcept;
+};
+
+inline TThreadPool*& TThreadPool::current_pool() noexcept {
+    static thread_local TThreadPool* pool = nullptr;
+    return pool;
+}
+
+inline std::size_t& TThreadPool::current_index() noexcept {
+    static thread_local std::size_t index = 0;
+    return index;
+}
+
+inline TThreadPool::TThreadPool(std::size_t threads) : _queued(0),
+_next_queue(0), _attached(0), _stop(false) {
+    if (threads == 0)
+        threads = 1;
+
+    for (std::size_t i = 0; i < threads; i++) {
+        _queues.emplace_back(new Queue());
+    }
+
+    try {
+        for (std::size_t i = 0; i < threads; i++) {
+            _workers.emplace_back(&TThreadPool::work, this, i);
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(_sleep_mutex);
+            _stop = true;
+        }
+
+        _wake.notify_all();
+
+        for (std::thread& worker : _workers) {
+            worker.join();
+        }
+
+        throw;
+    }
+}
+
+// Queued tasks still run: the workers empty the queues before they
+// exit, and tasks the last ones submitted run on the calling thread, so
+// a TTaskGroup waiting on them is released.
+inline TThreadPool::~TThreadPool() noexcept {
+    assert(_attached.load() == 0 && "TThreadPool destroyed while in use");
+
+    {
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+        _stop = true;
+    }
+
+    _wake.notify_all();
+
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+
+    while (run_one()) {}
+}
+
+inline void TThreadPool::submit(std::function<void()> task) {
+    std::size_t index = current_pool() == this ? current_index() :
+        _next_queue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+    Queue& queue = *_queues[index];
+
+    // Counted before the push, so _queued never drops below the number
+    // of tasks a worker can see.
+    {
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+        _queued.fetch_add(1, std::memory_order_release);
+    }
+
+    try {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    } catch (...) {
+        _queued.fetch_sub(1, std::memory_order_relaxed);
+        throw;
+    }
+
+    _wake.notify_one();
+}
+
+// Own deque first, from the back, then the other deques from the front.
+inline bool TThreadPool::pop(std::size_t self,
+    std::function<void()>& task) {
+    std::size_t count = _queues.size();
+
+    for (std::size_t i = 0; i < count; i++) {
+        Queue& queue = *_queues[(self + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.tasks.empty())
+            continue;
+
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+
+        _queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+// Runs one queued task on the calling thread, false if there was none.
+inline bool TThreadPool::run_one() {
+    std::size_t self = current_pool() == this ? current_index() :
+        _next_queue.load(std::memory_order_relaxed) % _queues.size();
+    std::function<void()> task;
+
+    if (!pop(self, task))
+        return false;
+
+    task();
+    return true;
+}
+
+inline void TThreadPool::work(std::size_t index) {
+    current_pool() = this;
+    current_index() = index;
+
+    while (true) {
+        std::function<void()> task;
+
+        if (pop(index, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleep_mutex);
+        _wake.wait(lock, [this] {
+            return _stop || _queued.load(std::memory_order_acquire) > 0;
+        });
+
+        if (_stop && _queued.load(std::memory_order_acquire) == 0)
+            return;
+    }
+}
+
+inline std::size_t TThreadPool::size() const noexcept {
+    return _workers.size();
+}
+
+inline void TThreadPool::attach() noexcept {
+    _attached.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void TThreadPool::detach() noexcept {
+    _attached.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// Fork-join scope over a pool. run() submits a task, wait() blocks until
+// every task of the group, including the ones they spawned, finished.
+// The waiting thread runs queued tasks meanwhile, so nested groups in
+// pool tasks cannot deadlock. The first exception is rethrown by wait().
+class TTaskGroup {
+ private:
+    TThreadPool& _pool;
+    std::atomic<std::size_t> _pending;
+    std::mutex _error_mutex;
+    std::exception_ptr _error;
+
+ public:
+    explicit TTaskGroup(TThreadPool& pool) noexcept : _pool(pool),
+        _pending(0) {}
+    TTaskGroup(const TTaskGroup&) = delete;
+    ~TTaskGroup() noexcept;
+
+    TTaskGroup& operator=(const TTaskGroup&) = delete;
+
+    template<class Task>
+    void run(Task task);
+    void wait();
+};
+
+inline TTaskGroup::~TTaskGroup() noexcept {
+    while (_pending.load(std::memory_order_acquire) > 0) {
+        if (!_pool.run_one())
+            std::this_thread::yield();
+    }
+}
+
+template<class Task>
+void TTaskGroup::run(Task task) {
+    _pending.fetch_add(1, std::memory_order_relaxed);
+
+    try {
+        _pool.submit([this, task = std::move(task)]() mutable {
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(_error_mutex);
+
+                if (!_error)
+                    _error = std::current_exception();
+            }
+
+            _pending.fetch_sub(1, std::memory_order_release);
+        });
+    } catch (...) {
+        _pending.fetch_sub(1, std::memory_order_relaxed);
+        throw;
+    }
+}
+
+inline void TTaskGroup::wait() {
+    while (_pending.load(std::memory_order_acquire) > 0) {
+        if (!_pool.run_one())
+            std::this_thread::yield();
+    }
+
+    if (_error) {
+        std::exception_ptr error = _error;
+        _error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+#pragma endregion ThreadPool
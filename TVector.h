@@ -1,10 +1,28 @@
 // Copyright 2025 Chernykh Valentin
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <ctime>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "TBits.h"
+#include "TSimdSearch.h"
+#include "TSort.h"
+#include "TThreadPool.h"
 
 enum State {
     Empty,
@@ -12,962 +30,3318 @@ enum State {
     Deleted
 };
 
-template<typename T>
-class TVector {
- private:
-    T* _data;
-    State* _states;
-    size_t _capacity;
-    size_t _used;
-    size_t _deleted;
-    size_t _capacity_step = 15;
-    float _removal_coefficient = 0.15f;
+#pragma region GrowthPolicies
+
+// Growth policies decide the capacity of a new buffer. capacity_for()
+// receives the current capacity, the number of elements that must fit
+// and sizeof(T), and returns the capacity to allocate (>= required).
+// An optional shrink_capacity(current, size, elem_size) picks the
+// capacity to keep once tombstones are compacted away: returning current
+// compacts in place without reallocating. Without it the buffer shrinks
+// to capacity_for(0, size, elem_size).
+
+// Rounds up to the next multiple of Step. Every reallocation adds a constant
+// number of slots, so push_back is amortized O(n). Kept as the default for
+// compatibility with existing capacity expectations.
+template<std::size_t Step = 15>
+struct TLinearGrowth {
+    static std::size_t capacity_for(std::size_t, std::size_t required,
+        std::size_t) noexcept {
+        return (required / Step + 1) * Step;
+    }
+};
+
+// Multiplies the current capacity by Numerator / Denominator,
+// so push_back is amortized O(1).
+template<std::size_t Numerator, std::size_t Denominator,
+    std::size_t MinCapacity = 16>
+struct TGeometricGrowth {
+    static_assert(Numerator > Denominator && Denominator > 0,
+        "TGeometricGrowth factor must be greater than one");
+
+    static std::size_t capacity_for(std::size_t current, std::size_t required,
+        std::size_t) noexcept {
+        std::size_t grown = current + current / Denominator *
+            (Numerator - Denominator) +
+            current % Denominator * (Numerator - Denominator) / Denominator;
+
+        if (grown < MinCapacity)
+            grown = MinCapacity;
+
+        return grown < required ? required : grown;
+    }
+
+    // Keeps the buffer until the elements fit in a quarter of it.
+    static std::size_t shrink_capacity(std::size_t current, std::size_t size,
+        std::size_t) noexcept {
+        if (size > current / 4)
+            return current;
+
+        return 2 * size < MinCapacity ? MinCapacity : 2 * size;
+    }
+};
+
+template<class G>
+auto tv_shrink_capacity(std::size_t current, std::size_t size,
+    std::size_t elem_size, int) noexcept
+    -> decltype(G::shrink_capacity(current, size, elem_size)) {
+    return G::shrink_capacity(current, size, elem_size);
+}
+
+template<class G>
+std::size_t tv_shrink_capacity(std::size_t, std::size_t size,
+    std::size_t elem_size, long) noexcept {
+    return G::capacity_for(0, size, elem_size);
+}
+
+using TGrowth2x = TGeometricGrowth<2, 1>;
+using TGrowth1_5x = TGeometricGrowth<3, 2>;
+
+// Applies Base and rounds the buffer up to a whole number of pages,
+// so the tail of the last page is never wasted.
+template<class Base = TGrowth2x, std::size_t PageSize = 4096>
+struct TPageGrowth {
+    static std::size_t capacity_for(std::size_t current, std::size_t required,
+        std::size_t elem_size) noexcept {
+        std::size_t capacity = Base::capacity_for(current, required, elem_size);
+
+        if (elem_size == 0 || elem_size >= PageSize)
+            return capacity;
+
+        std::size_t pages = (capacity * elem_size + PageSize - 1) / PageSize;
+
+        return pages * PageSize / elem_size;
+    }
+
+    static std::size_t shrink_capacity(std::size_t current, std::size_t size,
+        std::size_t elem_size) noexcept {
+        std::size_t capacity =
+            tv_shrink_capacity<Base>(current, size, elem_size, 0);
+
+        if (capacity == current || elem_size == 0 || elem_size >= PageSize)
+            return capacity;
+
+        std::size_t pages = (capacity * elem_size + PageSize - 1) / PageSize;
 
+        return pages * PageSize / elem_size;
+    }
+};
+
+#pragma endregion GrowthPolicies
+
+#pragma region CompactionPolicies
+
+// Passed to the compaction hook after the tombstones were removed.
+struct TCompactionEvent {
+    std::size_t tombstones;
+    std::size_t size;
+    std::size_t capacity;
+    bool manual;
+};
+
+// Decides when erase, pop_back and pop_front compact the tombstones of a
+// TVector away. Threshold compacts once they reach per_mille of the used
+// slots, ByteBudget once they hold that many bytes, Interval at most
+// once per period (the clock is read once 64 tombstones were made since
+// the last read) and Never leaves it to compact().
+class TCompactionPolicy {
  public:
-    using value_type = T;
-    using reference = T&;
-    using const_reference = const T&;
-    using pointer = T*;
-    using const_pointer = const T*;
-    using size_type = std::size_t;
-    using difference_type = std::ptrdiff_t;
+    enum class Kind { Threshold, Never, ByteBudget, Interval };
+    using clock = std::chrono::steady_clock;
 
-    class Iterator {
-     private:
-        T* _ptr;
-        TVector<T>& _parent;
+    static constexpr std::size_t interval_check = 64;
 
-     public:
-        using iterator_category = std::random_access_iterator_tag;
-        using value_type = TVector::value_type;
-        using reference = TVector::reference;
-        using pointer = TVector::pointer;
-        using difference_type = TVector::difference_type;
+    TCompactionPolicy() noexcept;
 
-        Iterator(T*, TVector<T>&) noexcept;
-        Iterator(const Iterator&) noexcept;
+    static TCompactionPolicy threshold(std::size_t per_mille) noexcept;
+    static TCompactionPolicy never() noexcept;
+    static TCompactionPolicy byte_budget(std::size_t bytes) noexcept;
+    static TCompactionPolicy interval(clock::duration period) noexcept;
 
-        inline reference operator*();
-        inline pointer operator->() noexcept;
-        inline Iterator& operator=(const Iterator&) noexcept;
-        Iterator& operator++() noexcept;
-        inline Iterator operator++(int) noexcept;
-        Iterator& operator--() noexcept;
-        inline Iterator operator--(int) noexcept;
-        Iterator operator+(int) const;
-        Iterator operator-(int) const;
-        Iterator& operator+=(int);
-        Iterator& operator-=(int);
-        inline bool operator!=(const Iterator&) const noexcept;
-        inline bool operator==(const Iterator&) const noexcept;
-        difference_type operator-(const Iterator&) const;
-        inline difference_type index() const noexcept;
-        bool operator<(const Iterator&) const noexcept;
-        bool operator>(const Iterator&) const noexcept;
-        bool operator<=(const Iterator&) const noexcept;
-        bool operator>=(const Iterator&) const noexcept;
-        reference operator[](difference_type);
-    };
+    inline Kind kind() const noexcept;
+    inline bool due(std::size_t deleted, std::size_t used,
+        std::size_t elem_size) noexcept;
+    inline void compacted() noexcept;
 
-    class ConstIterator {
-     private:
-        const T* _ptr;
-        const TVector<T>& _parent;
+ private:
+    TCompactionPolicy(Kind, std::size_t, clock::duration) noexcept;
 
-     public:
-        using iterator_category = std::random_access_iterator_tag;
-        using value_type = TVector::value_type;
-        using reference = TVector::const_reference;
-        using pointer = TVector::const_pointer;
-        using difference_type = TVector::difference_type;
+    Kind _kind;
+    std::size_t _limit;
+    clock::duration _period;
+    clock::time_point _last;
+    std::size_t _checked;
+};
 
-        ConstIterator(const T*, const TVector<T>&) noexcept;
-        ConstIterator(const ConstIterator&) noexcept;
+inline TCompactionPolicy::TCompactionPolicy() noexcept
+    : TCompactionPolicy(Kind::Threshold, 150, clock::duration::zero()) {}
 
-        inline reference operator*();
-        inline pointer operator->() noexcept;
-        ConstIterator& operator++() noexcept;
-        inline ConstIterator operator++(int) noexcept;
-        ConstIterator& operator--() noexcept;
-        inline ConstIterator operator--(int) noexcept;
-        ConstIterator operator+(int) const;
-        ConstIterator operator-(int) const;
-        ConstIterator& operator+=(int);
-        ConstIterator& operator-=(int);
-        inline bool operator!=(const ConstIterator&) const noexcept;
-        inline bool operator==(const ConstIterator&) const noexcept;
-        difference_type operator-(const ConstIterator&) const;
-        inline difference_type index() const noexcept;
-        bool operator<(const ConstIterator&) const noexcept;
-        bool operator>(const ConstIterator&) const noexcept;
-        bool operator<=(const ConstIterator&) const noexcept;
-        bool operator>=(const ConstIterator&) const noexcept;
-        reference operator[](difference_type);
-    };
+inline TCompactionPolicy::TCompactionPolicy(Kind kind, std::size_t limit,
+    clock::duration period) noexcept
+    : _kind(kind), _limit(limit), _period(period), _last(), _checked(0) {}
 
-    TVector() noexcept;
-    explicit TVector(size_type) noexcept;
-    TVector(size_type, value_type);
-    TVector(const TVector&) noexcept;
-    TVector(TVector&&) noexcept;
-    TVector(pointer, size_type);
-    TVector(std::initializer_list<value_type>) noexcept;
-    ~TVector() noexcept;
+inline TCompactionPolicy TCompactionPolicy::threshold(
+    std::size_t per_mille) noexcept {
+    return TCompactionPolicy(Kind::Threshold, per_mille,
+        clock::duration::zero());
+}
 
-    inline pointer data() noexcept;
-    inline const_pointer data() const noexcept;
-    inline State* states() noexcept;
-    inline const State* states() const noexcept;
-    inline size_type size() const noexcept;
-    inline size_type used() const noexcept;
-    inline size_type capacity() const noexcept;
-    inline reference front();
-    inline reference back();
-    inline Iterator begin() noexcept;
-    inline Iterator end() noexcept;
-    inline ConstIterator begin() const noexcept;
-    inline ConstIterator end() const noexcept;
+inline TCompactionPolicy TCompactionPolicy::never() noexcept {
+    return TCompactionPolicy(Kind::Never, 0, clock::duration::zero());
+}
 
-    void push_back(const value_type&) noexcept;
-    void push_back(value_type&&) noexcept;
-    void push_front(const value_type&) noexcept;
-    void push_front(value_type&&) noexcept;
-    Iterator insert(Iterator, const value_type&) noexcept;
-    Iterator insert(Iterator position, size_type n,
-        const value_type& value) noexcept;
-    Iterator insert(Iterator, value_type&&) noexcept;
-    template <class... Args>
-    Iterator emplace(Iterator position, Args&&... args);
-    void pop_back();
-    void pop_front();
-    Iterator erase(Iterator);
+inline TCompactionPolicy TCompactionPolicy::byte_budget(
+    std::size_t bytes) noexcept {
+    return TCompactionPolicy(Kind::ByteBudget, bytes,
+        clock::duration::zero());
+}
 
-    TVector& assign(const TVector&);
-    reference at(size_type);
-    inline void clear() noexcept;
-    void shrink_to_fit();
-    void resize(size_type);
-    inline bool is_empty() const noexcept;
-    TVector& operator=(const TVector&) noexcept;
-    TVector& operator=(TVector&&) noexcept;
-    bool operator==(const TVector<value_type>&) const noexcept;
-    bool operator!=(const TVector<value_type>&) const noexcept;
-    reference operator[](size_type);
-    const_reference operator[](size_type) const;
+inline TCompactionPolicy TCompactionPolicy::interval(
+    clock::duration period) noexcept {
+    TCompactionPolicy policy(Kind::Interval, 0, period);
+    policy._last = clock::now();
+    return policy;
+}
+
+inline TCompactionPolicy::Kind TCompactionPolicy::kind() const noexcept {
+    return _kind;
+}
+
+// used counts the slots from the first element to the last one.
+inline bool TCompactionPolicy::due(std::size_t deleted, std::size_t used,
+    std::size_t elem_size) noexcept {
+    switch (_kind) {
+    case Kind::Threshold:
+        return deleted * 1000 >= used * _limit;
+    case Kind::ByteBudget:
+        return deleted > 0 && deleted * elem_size >= _limit;
+    case Kind::Interval:
+        // Fewer tombstones than at the last read: some were reused.
+        if (deleted < _checked)
+            _checked = deleted;
+
+        if (deleted == 0 || deleted - _checked < interval_check)
+            return false;
+
+        _checked = deleted;
+        return clock::now() - _last >= _period;
+    default:
+        return false;
+    }
+}
+
+inline void TCompactionPolicy::compacted() noexcept {
+    if (_kind == Kind::Interval) {
+        _last = clock::now();
+        _checked = 0;
+    }
+}
 
-    template<typename U>
-    friend std::ostream& operator<<(std::ostream&, const TVector<U>&) noexcept;
-    template<typename U>
-    friend void shuffle(TVector<U>&) noexcept;
-    template<typename U>
-    inline friend void tv_sort(TVector<U>&, bool(*comp)(U, U)) noexcept;
-    template<typename U>
-    friend int* search_all(TVector<U>&, bool(*check) (U)) noexcept;
-    template<typename U>
-    friend int search_begin(TVector<U>&, bool(*check) (U)) noexcept;
-    template<typename U>
-    friend int search_end(TVector<U>&, bool(*check) (U)) noexcept;
+#pragma endregion CompactionPolicies
 
+#pragma region BusyIndex
+
+// Rank/select index over the busy slots of a TVector.
+// Slots are kept in a bitmap of 64-bit blocks. Every 8 blocks form a
+// superblock and superblock popcounts live in a Fenwick tree, so rank(),
+// select() and a single set()/unset() are O(log n). Bulk changes go
+// through write() and are published with one O(n / 64) rebuild().
+// Both arrays come from Allocator, rebound to their element types.
+template<class Allocator = std::allocator<uint64_t>>
+class TBasicBusyIndex {
  private:
-    void reset_memory_for_delete() noexcept;
-    void reset_memory(size_type) noexcept;
-    Iterator reset_memory(size_type, const Iterator&) noexcept;
-    inline bool is_full() const noexcept;
-    template <typename U>
-    friend size_t partition(TVector<U>&, size_type,
-        size_type, bool (*comp)(U, U))noexcept;
-    template <typename U>
-    friend void quick_sort(TVector<U>&, size_type,
-        size_type, bool (*comp)(U, U)) noexcept;
-    inline void swap_elem(size_type, size_type) noexcept;
+    using block_allocator = typename std::allocator_traits<Allocator>::
+        template rebind_alloc<uint64_t>;
+    using tree_allocator = typename std::allocator_traits<Allocator>::
+        template rebind_alloc<std::size_t>;
+    using block_traits = std::allocator_traits<block_allocator>;
+    using tree_traits = std::allocator_traits<tree_allocator>;
+
+    static constexpr std::size_t block_bits = 64;
+    static constexpr std::size_t superblock_blocks = 8;
+    static constexpr std::size_t superblock_bits =
+        block_bits * superblock_blocks;
+
+    block_allocator _allocator;
+    uint64_t* _blocks;
+    std::size_t* _tree;
+    std::size_t _block_count;
+    std::size_t _superblock_count;
+
+ public:
+    using allocator_type = Allocator;
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    TBasicBusyIndex() noexcept;
+    explicit TBasicBusyIndex(const Allocator&) noexcept;
+    explicit TBasicBusyIndex(std::size_t, const Allocator& = Allocator());
+    TBasicBusyIndex(const TBasicBusyIndex&);
+    TBasicBusyIndex(TBasicBusyIndex&&) noexcept;
+    ~TBasicBusyIndex() noexcept;
+
+    TBasicBusyIndex& operator=(const TBasicBusyIndex&);
+    TBasicBusyIndex& operator=(TBasicBusyIndex&&) noexcept;
+
+    void reset(std::size_t);
+    inline bool test(std::size_t) const noexcept;
+    inline void write(std::size_t, bool) noexcept;
+    inline void set(std::size_t) noexcept;
+    inline void unset(std::size_t) noexcept;
+    void rebuild() noexcept;
+    std::size_t rank(std::size_t) const noexcept;
+    std::size_t select(std::size_t) const noexcept;
+    std::size_t next(std::size_t, std::size_t) const noexcept;
+    std::size_t next_free(std::size_t, std::size_t) const noexcept;
+    std::size_t prev(std::size_t) const noexcept;
+    inline const uint64_t* words() const noexcept;
+
+ private:
+    inline void add(std::size_t, std::ptrdiff_t) noexcept;
+    std::size_t prefix(std::size_t) const noexcept;
+    void release() noexcept;
 };
 
-#pragma region TVectorRealization
+using TBusyIndex = TBasicBusyIndex<>;
+
+template<class A>
+TBasicBusyIndex<A>::TBasicBusyIndex() noexcept : TBasicBusyIndex(A()) {}
+
+template<class A>
+TBasicBusyIndex<A>::TBasicBusyIndex(const A& allocator) noexcept
+    : _allocator(allocator), _blocks(nullptr), _tree(nullptr),
+_block_count(0), _superblock_count(0) {}
+
+template<class A>
+TBasicBusyIndex<A>::TBasicBusyIndex(std::size_t size, const A& allocator)
+    : TBasicBusyIndex(allocator) {
+    reset(size);
+}
+
+template<class A>
+TBasicBusyIndex<A>::TBasicBusyIndex(const TBasicBusyIndex& other)
+    : TBasicBusyIndex(A(block_traits::select_on_container_copy_construction(
+        other._allocator))) {
+    *this = other;
+}
+
+template<class A>
+TBasicBusyIndex<A>::TBasicBusyIndex(TBasicBusyIndex&& other) noexcept
+    : _allocator(std::move(other._allocator)), _blocks(other._blocks),
+_tree(other._tree), _block_count(other._block_count),
+_superblock_count(other._superblock_count) {
+    other._blocks = nullptr;
+    other._tree = nullptr;
+    other._block_count = 0;
+    other._superblock_count = 0;
+}
+
+template<class A>
+TBasicBusyIndex<A>::~TBasicBusyIndex() noexcept {
+    release();
+}
+
+template<class A>
+TBasicBusyIndex<A>& TBasicBusyIndex<A>::operator=(
+    const TBasicBusyIndex& other) {
+    if (this != &other) {
+        reset(other._block_count * block_bits);
+
+        for (std::size_t i = 0; i < _block_count; i++) {
+            _blocks[i] = other._blocks[i];
+        }
+
+        for (std::size_t i = 0; _tree != nullptr && i <= _superblock_count;
+            i++) {
+            _tree[i] = other._tree[i];
+        }
+    }
+
+    return *this;
+}
+
+template<class A>
+TBasicBusyIndex<A>& TBasicBusyIndex<A>::operator=(TBasicBusyIndex&& other)
+noexcept {
+    if (this != &other) {
+        release();
+        _allocator = other._allocator;
+        _blocks = other._blocks;
+        _tree = other._tree;
+        _block_count = other._block_count;
+        _superblock_count = other._superblock_count;
+        other._blocks = nullptr;
+        other._tree = nullptr;
+        other._block_count = 0;
+        other._superblock_count = 0;
+    }
+
+    return *this;
+}
+
+// Resizes the index to hold size slots, all of them cleared. Both
+// arrays are allocated before the old ones are freed, so a throw leaves
+// the index as it was.
+template<class A>
+void TBasicBusyIndex<A>::reset(std::size_t size) {
+    std::size_t block_count = (size + block_bits - 1) / block_bits;
+    std::size_t superblock_count =
+        (block_count + superblock_blocks - 1) / superblock_blocks;
+
+    if (block_count != _block_count) {
+        tree_allocator tree_alloc(_allocator);
+        uint64_t* blocks = block_count > 0 ?
+            block_traits::allocate(_allocator, block_count) : nullptr;
+        std::size_t* tree;
+
+        try {
+            tree = tree_traits::allocate(tree_alloc, superblock_count + 1);
+        } catch (...) {
+            if (blocks != nullptr)
+                block_traits::deallocate(_allocator, blocks, block_count);
+
+            throw;
+        }
+
+        release();
+        _blocks = blocks;
+        _tree = tree;
+        _block_count = block_count;
+        _superblock_count = superblock_count;
+    }
+
+    for (std::size_t i = 0; i < _block_count; i++) {
+        _blocks[i] = 0;
+    }
+
+    for (std::size_t i = 0; _tree != nullptr && i <= _superblock_count; i++) {
+        _tree[i] = 0;
+    }
+}
+
+// Bit i of word w is slot 64 * w + i.
+template<class A>
+inline const uint64_t* TBasicBusyIndex<A>::words() const noexcept {
+    return _blocks;
+}
+
+template<class A>
+inline bool TBasicBusyIndex<A>::test(std::size_t pos) const noexcept {
+    return (_blocks[pos / block_bits] >> (pos % block_bits)) & 1u;
+}
+
+// Changes a slot without updating the superblock counts,
+// rebuild() must be called before the next rank() or select().
+template<class A>
+inline void TBasicBusyIndex<A>::write(std::size_t pos, bool busy) noexcept {
+    uint64_t mask = uint64_t(1) << (pos % block_bits);
+
+    if (busy)
+        _blocks[pos / block_bits] |= mask;
+    else
+        _blocks[pos / block_bits] &= ~mask;
+}
+
+template<class A>
+inline void TBasicBusyIndex<A>::set(std::size_t pos) noexcept {
+    if (!test(pos)) {
+        write(pos, true);
+        add(pos / superblock_bits, 1);
+    }
+}
+
+template<class A>
+inline void TBasicBusyIndex<A>::unset(std::size_t pos) noexcept {
+    if (test(pos)) {
+        write(pos, false);
+        add(pos / superblock_bits, -1);
+    }
+}
+
+template<class A>
+void TBasicBusyIndex<A>::rebuild() noexcept {
+    if (_tree == nullptr)
+        return;
+
+    _tree[0] = 0;
+
+    for (std::size_t sb = 0; sb < _superblock_count; sb++) {
+        std::size_t count = 0;
+        std::size_t last = (sb + 1) * superblock_blocks;
+
+        for (std::size_t i = sb * superblock_blocks;
+            i < last && i < _block_count; i++) {
+            count += tv_popcount(_blocks[i]);
+        }
+
+        _tree[sb + 1] = count;
+    }
+
+    for (std::size_t i = 1; i <= _superblock_count; i++) {
+        std::size_t parent = i + (i & (~i + 1));
+
+        if (parent <= _superblock_count)
+            _tree[parent] += _tree[i];
+    }
+}
+
+// Number of busy slots in [0, pos).
+template<class A>
+std::size_t TBasicBusyIndex<A>::rank(std::size_t pos) const noexcept {
+    std::size_t block = pos / block_bits;
+    std::size_t result = prefix(pos / superblock_bits);
+
+    for (std::size_t i = pos / superblock_bits * superblock_blocks;
+        i < block; i++) {
+        result += tv_popcount(_blocks[i]);
+    }
+
+    if (pos % block_bits != 0) {
+        uint64_t mask = (uint64_t(1) << (pos % block_bits)) - 1;
+        result += tv_popcount(_blocks[block] & mask);
+    }
+
+    return result;
+}
+
+// Position of the n-th (0-based) busy slot, n must be less than the
+// number of busy slots.
+template<class A>
+std::size_t TBasicBusyIndex<A>::select(std::size_t n) const noexcept {
+    std::size_t superblock = 0;
+    std::size_t step = 1;
+
+    while (step * 2 <= _superblock_count) {
+        step *= 2;
+    }
+
+    for (; step > 0; step /= 2) {
+        if (superblock + step <= _superblock_count &&
+            _tree[superblock + step] <= n) {
+            superblock += step;
+            n -= _tree[superblock];
+        }
+    }
+
+    std::size_t block = superblock * superblock_blocks;
+
+    for (;; block++) {
+        std::size_t count = tv_popcount(_blocks[block]);
+
+        if (n < count)
+            break;
+
+        n -= count;
+    }
+
+    return block * block_bits +
+        tv_select_in_word(_blocks[block], static_cast<unsigned>(n));
+}
+
+// First busy slot in [from, limit), or limit when there is none.
+template<class A>
+std::size_t TBasicBusyIndex<A>::next(std::size_t from, std::size_t limit)
+const noexcept {
+    if (from >= limit)
+        return limit;
+
+    std::size_t block = from / block_bits;
+    std::size_t last_block = (limit - 1) / block_bits;
+    uint64_t word = _blocks[block] & (~uint64_t(0) << (from % block_bits));
+
+    for (;;) {
+        if (word != 0) {
+            std::size_t pos = block * block_bits + tv_ctz(word);
+            return pos < limit ? pos : limit;
+        }
+
+        if (++block > last_block)
+            return limit;
+
+        word = _blocks[block];
+    }
+}
+
+// First non-busy slot in [from, limit), or limit when every slot is busy.
+template<class A>
+std::size_t TBasicBusyIndex<A>::next_free(std::size_t from, std::size_t limit)
+const noexcept {
+    if (from >= limit)
+        return limit;
+
+    std::size_t block = from / block_bits;
+    std::size_t last_block = (limit - 1) / block_bits;
+    uint64_t word = ~_blocks[block] & (~uint64_t(0) << (from % block_bits));
+
+    for (;;) {
+        if (word != 0) {
+            std::size_t pos = block * block_bits + tv_ctz(word);
+            return pos < limit ? pos : limit;
+        }
+
+        if (++block > last_block)
+            return limit;
+
+        word = ~_blocks[block];
+    }
+}
+
+// Last busy slot before pos, or npos when there is none.
+template<class A>
+std::size_t TBasicBusyIndex<A>::prev(std::size_t pos) const noexcept {
+    if (pos == 0)
+        return npos;
+
+    std::size_t block = (pos - 1) / block_bits;
+    uint64_t word = _blocks[block] &
+        (~uint64_t(0) >> (block_bits - 1 - (pos - 1) % block_bits));
+
+    for (;;) {
+        if (word != 0)
+            return block * block_bits + tv_msb(word);
+
+        if (block == 0)
+            return npos;
+
+        word = _blocks[--block];
+    }
+}
+
+template<class A>
+inline void TBasicBusyIndex<A>::add(std::size_t superblock,
+    std::ptrdiff_t delta) noexcept {
+    for (std::size_t i = superblock + 1; i <= _superblock_count;
+        i += i & (~i + 1)) {
+        _tree[i] += delta;
+    }
+}
+
+// Number of busy slots in the first superblock_count superblocks.
+template<class A>
+std::size_t TBasicBusyIndex<A>::prefix(std::size_t superblock_count)
+const noexcept {
+    std::size_t result = 0;
+
+    for (std::size_t i = superblock_count; i > 0; i -= i & (~i + 1)) {
+        result += _tree[i];
+    }
+
+    return result;
+}
+
+template<class A>
+void TBasicBusyIndex<A>::release() noexcept {
+    tree_allocator tree_alloc(_allocator);
+
+    if (_blocks != nullptr)
+        block_traits::deallocate(_allocator, _blocks, _block_count);
+
+    if (_tree != nullptr)
+        tree_traits::deallocate(tree_alloc, _tree, _superblock_count + 1);
+
+    _blocks = nullptr;
+    _tree = nullptr;
+    _block_count = 0;
+    _superblock_count = 0;
+}
+
+#pragma endregion BusyIndex
+
+#pragma region StateMap
+
+// Packed slot states: one busy bit (with its rank/select index) and one
+// deleted bit per slot, Empty when neither is set. Replaces a full State
+// per slot and lets scans skip 64 slots per word.
+template<class Allocator = std::allocator<uint64_t>>
+class TBasicStateMap {
+ private:
+    using block_allocator = typename std::allocator_traits<Allocator>::
+        template rebind_alloc<uint64_t>;
+    using block_traits = std::allocator_traits<block_allocator>;
+
+    static constexpr std::size_t block_bits = 64;
+
+    TBasicBusyIndex<Allocator> _busy;
+    block_allocator _allocator;
+    uint64_t* _deleted;
+    std::size_t _block_count;
+
+ public:
+    using allocator_type = Allocator;
+
+    static constexpr std::size_t npos = TBasicBusyIndex<Allocator>::npos;
+
+    TBasicStateMap() noexcept;
+    explicit TBasicStateMap(const Allocator&) noexcept;
+    explicit TBasicStateMap(std::size_t, const Allocator& = Allocator());
+    TBasicStateMap(const TBasicStateMap&);
+    TBasicStateMap(TBasicStateMap&&) noexcept;
+    ~TBasicStateMap() noexcept;
+
+    TBasicStateMap& operator=(const TBasicStateMap&);
+    TBasicStateMap& operator=(TBasicStateMap&&) noexcept;
+
+    void reset(std::size_t);
+    inline State get(std::size_t) const noexcept;
+    inline bool busy(std::size_t) const noexcept;
+    inline void set(std::size_t, State) noexcept;
+    inline void write(std::size_t, State) noexcept;
+    inline void rebuild() noexcept;
+    inline std::size_t next_busy(std::size_t, std::size_t) const noexcept;
+    inline std::size_t next_free(std::size_t, std::size_t) const noexcept;
+    inline std::size_t prev_busy(std::size_t) const noexcept;
+    inline std::size_t rank(std::size_t) const noexcept;
+    inline std::size_t select(std::size_t) const noexcept;
+    inline const uint64_t* busy_words() const noexcept;
+
+ private:
+    void release() noexcept;
+};
+
+template<class Allocator>
+constexpr std::size_t TBasicBusyIndex<Allocator>::npos;
+
+template<class Allocator>
+constexpr std::size_t TBasicStateMap<Allocator>::npos;
+
+using TStateMap = TBasicStateMap<>;
+
+// Read-only view that keeps the old State-per-slot interface of states().
+template<class Allocator = std::allocator<uint64_t>>
+class TBasicStatesView {
+ private:
+    const TBasicStateMap<Allocator>* _map;
+    std::size_t _size;
+
+ public:
+    TBasicStatesView(const TBasicStateMap<Allocator>&, std::size_t) noexcept;
+
+    inline State operator[](std::size_t) const noexcept;
+    inline std::size_t size() const noexcept;
+    inline const uint64_t* busy_words() const noexcept;
+};
+
+using TStatesView = TBasicStatesView<>;
+
+template<class A>
+TBasicStateMap<A>::TBasicStateMap() noexcept : TBasicStateMap(A()) {}
+
+template<class A>
+TBasicStateMap<A>::TBasicStateMap(const A& allocator) noexcept
+    : _busy(allocator), _allocator(allocator), _deleted(nullptr),
+_block_count(0) {}
+
+template<class A>
+TBasicStateMap<A>::TBasicStateMap(std::size_t size, const A& allocator)
+    : TBasicStateMap(allocator) {
+    reset(size);
+}
+
+template<class A>
+TBasicStateMap<A>::TBasicStateMap(const TBasicStateMap& other)
+    : TBasicStateMap(A(block_traits::select_on_container_copy_construction(
+        other._allocator))) {
+    *this = other;
+}
+
+template<class A>
+TBasicStateMap<A>::TBasicStateMap(TBasicStateMap&& other) noexcept
+    : _busy(std::move(other._busy)), _allocator(std::move(other._allocator)),
+_deleted(other._deleted), _block_count(other._block_count) {
+    other._deleted = nullptr;
+    other._block_count = 0;
+}
+
+template<class A>
+TBasicStateMap<A>::~TBasicStateMap() noexcept {
+    release();
+}
+
+template<class A>
+TBasicStateMap<A>& TBasicStateMap<A>::operator=(const TBasicStateMap& other) {
+    if (this != &other) {
+        if (_block_count != other._block_count) {
+            release();
+            _deleted = other._block_count > 0 ?
+                block_traits::allocate(_allocator, other._block_count) :
+                nullptr;
+            _block_count = other._block_count;
+        }
+
+        for (std::size_t i = 0; i < _block_count; i++) {
+            _deleted[i] = other._deleted[i];
+        }
+
+        _busy = other._busy;
+    }
+
+    return *this;
+}
+
+template<class A>
+TBasicStateMap<A>& TBasicStateMap<A>::operator=(TBasicStateMap&& other)
+noexcept {
+    if (this != &other) {
+        release();
+        _busy = std::move(other._busy);
+        _allocator = other._allocator;
+        _deleted = other._deleted;
+        _block_count = other._block_count;
+        other._deleted = nullptr;
+        other._block_count = 0;
+    }
+
+    return *this;
+}
+
+// Resizes the map to hold size slots, all of them Empty. A throw leaves
+// the map as it was.
+template<class A>
+void TBasicStateMap<A>::reset(std::size_t size) {
+    std::size_t block_count = (size + block_bits - 1) / block_bits;
+
+    if (block_count != _block_count) {
+        uint64_t* deleted = block_count > 0 ?
+            block_traits::allocate(_allocator, block_count) : nullptr;
+
+        try {
+            _busy.reset(size);
+        } catch (...) {
+            if (deleted != nullptr)
+                block_traits::deallocate(_allocator, deleted, block_count);
+
+            throw;
+        }
+
+        release();
+        _deleted = deleted;
+        _block_count = block_count;
+    } else {
+        _busy.reset(size);
+    }
+
+    for (std::size_t i = 0; i < _block_count; i++) {
+        _deleted[i] = 0;
+    }
+}
+
+template<class A>
+inline State TBasicStateMap<A>::get(std::size_t pos) const noexcept {
+    if (_busy.test(pos))
+        return Busy;
+
+    return (_deleted[pos / block_bits] >> (pos % block_bits)) & 1u ?
+        Deleted : Empty;
+}
+
+template<class A>
+inline bool TBasicStateMap<A>::busy(std::size_t pos) const noexcept {
+    return _busy.test(pos);
+}
+
+template<class A>
+inline void TBasicStateMap<A>::set(std::size_t pos, State state) noexcept {
+    uint64_t mask = uint64_t(1) << (pos % block_bits);
+
+    if (state == Busy)
+        _busy.set(pos);
+    else
+        _busy.unset(pos);
+
+    if (state == Deleted)
+        _deleted[pos / block_bits] |= mask;
+    else
+        _deleted[pos / block_bits] &= ~mask;
+}
+
+// Changes a slot without updating the rank/select index,
+// rebuild() must be called before the next rank() or select().
+template<class A>
+inline void TBasicStateMap<A>::write(std::size_t pos, State state) noexcept {
+    uint64_t mask = uint64_t(1) << (pos % block_bits);
+
+    _busy.write(pos, state == Busy);
+
+    if (state == Deleted)
+        _deleted[pos / block_bits] |= mask;
+    else
+        _deleted[pos / block_bits] &= ~mask;
+}
+
+template<class A>
+inline void TBasicStateMap<A>::rebuild() noexcept {
+    _busy.rebuild();
+}
+
+template<class A>
+inline std::size_t TBasicStateMap<A>::next_busy(std::size_t from,
+    std::size_t limit) const noexcept {
+    return _busy.next(from, limit);
+}
+
+template<class A>
+inline std::size_t TBasicStateMap<A>::next_free(std::size_t from,
+    std::size_t limit) const noexcept {
+    return _busy.next_free(from, limit);
+}
+
+template<class A>
+inline std::size_t TBasicStateMap<A>::prev_busy(std::size_t pos)
+const noexcept {
+    return _busy.prev(pos);
+}
+
+template<class A>
+inline std::size_t TBasicStateMap<A>::rank(std::size_t pos) const noexcept {
+    return _busy.rank(pos);
+}
+
+template<class A>
+inline std::size_t TBasicStateMap<A>::select(std::size_t n) const noexcept {
+    return _busy.select(n);
+}
+
+template<class A>
+inline const uint64_t* TBasicStateMap<A>::busy_words() const noexcept {
+    return _busy.words();
+}
+
+template<class A>
+void TBasicStateMap<A>::release() noexcept {
+    if (_deleted != nullptr)
+        block_traits::deallocate(_allocator, _deleted, _block_count);
+
+    _deleted = nullptr;
+    _block_count = 0;
+}
+
+template<class A>
+TBasicStatesView<A>::TBasicStatesView(const TBasicStateMap<A>& map,
+    std::size_t size) noexcept : _map(&map), _size(size) {}
+
+template<class A>
+inline State TBasicStatesView<A>::operator[](std::size_t pos) const noexcept {
+    return _map->get(pos);
+}
+
+template<class A>
+inline std::size_t TBasicStatesView<A>::size() const noexcept {
+    return _size;
+}
+
+// The busy bits in 64-slot words, for scans that skip tombstones a word
+// at a time. Covers at least size() slots.
+template<class A>
+inline const uint64_t* TBasicStatesView<A>::busy_words() const noexcept {
+    return _map->busy_words();
+}
+
+#pragma endregion StateMap
+
+#pragma region DenseView
+
+// Contiguous range over the elements of a TVector without tombstones.
+// Iterators are raw pointers, so std:: algorithms and auto-vectorization
+// apply directly. Any change of the vector invalidates the view.
+template<typename T>
+class TDenseView {
+ private:
+    T* _data;
+    std::size_t _size;
+
+ public:
+    using value_type = typename std::remove_const<T>::type;
+    using reference = T&;
+    using pointer = T*;
+    using iterator = T*;
+    using size_type = std::size_t;
+
+    TDenseView(T*, std::size_t) noexcept;
+
+    inline iterator begin() const noexcept;
+    inline iterator end() const noexcept;
+    inline pointer data() const noexcept;
+    inline size_type size() const noexcept;
+    inline bool empty() const noexcept;
+    inline reference operator[](size_type) const noexcept;
+};
+
+template<typename T>
+TDenseView<T>::TDenseView(T* data, std::size_t size) noexcept
+    : _data(data), _size(size) {}
+
+template<typename T>
+inline typename TDenseView<T>::iterator TDenseView<T>::begin() const
+noexcept {
+    return _data;
+}
+
+template<typename T>
+inline typename TDenseView<T>::iterator TDenseView<T>::end() const noexcept {
+    return _data + _size;
+}
+
+template<typename T>
+inline typename TDenseView<T>::pointer TDenseView<T>::data() const noexcept {
+    return _data;
+}
+
+template<typename T>
+inline typename TDenseView<T>::size_type TDenseView<T>::size() const
+noexcept {
+    return _size;
+}
+
+template<typename T>
+inline bool TDenseView<T>::empty() const noexcept {
+    return _size == 0;
+}
+
+template<typename T>
+inline typename TDenseView<T>::reference
+TDenseView<T>::operator[](size_type index) const noexcept {
+    return _data[index];
+}
+
+#pragma endregion DenseView
+
+// Range overloads take any type with an iterator category, which keeps
+// insert(position, 3, 7) on a TVector<int> off the range overload.
+template<class It>
+using tv_iterator_category =
+    typename std::iterator_traits<It>::iterator_category;
+
+template<typename T, class Growth = TLinearGrowth<>,
+    class Allocator = std::allocator<T>>
+class TVector {
+ private:
+    using allocator_traits = std::allocator_traits<Allocator>;
+    using word_allocator =
+        typename allocator_traits::template rebind_alloc<uint64_t>;
+    using state_map = TBasicStateMap<word_allocator>;
+
+    Allocator _allocator;
+    T* _data;
+    state_map _states;
+    size_t _capacity;
+    size_t _used;
+    size_t _deleted;
+    // Empty slots before the first element, left by push_front so the
+    // next front inserts need no shift. Busy slots lie in [_front, _used).
+    size_t _front = 0;
+    TCompactionPolicy _compaction;
+    std::function<void(const TCompactionEvent&)> _compaction_hook;
+    // Incremental compaction slides elements left over the tombstones a
+    // few at a time. Holes are searched from _compact_write and elements
+    // from _compact_read; no slot in between is busy.
+    size_t _compaction_step = 0;
+    size_t _compact_write = 0;
+    size_t _compact_read = 0;
+    bool _compacting = false;
+    // Tombstones for insert_any, lowest slot last. Entries go stale when
+    // a slot is refilled or the slots are rearranged, so each one is
+    // checked when taken and the list is collected again after a
+    // relayout.
+    std::vector<size_t> _free;
+    bool _free_valid = false;
+
+    // A background compaction. The pool copies the elements busy in the
+    // first frozen slots of source into data while erase and pop only
+    // log the frozen slots they free. The writer applies the log and the
+    // slots appended since when it publishes data in place of source.
+    struct CompactionJob {
+        enum Phase { Pending, Copying, Stopped, Copied };
+
+        std::atomic<int> phase;
+        std::atomic<bool> cancel;
+        std::atomic<bool> finished;
+        Allocator allocator;
+        const T* source = nullptr;
+        T* data = nullptr;
+        T* retired = nullptr;
+        size_t capacity = 0;
+        state_map states;
+        size_t frozen = 0;
+        size_t tombstones = 0;
+        size_t count = 0;
+        std::vector<uint64_t> busy;
+        std::vector<size_t> ranks;
+        std::vector<size_t> erased;
+        // Last, so its destructor waits for the tasks before the rest of
+        // the job goes.
+        TTaskGroup group;
+
+        CompactionJob(TThreadPool& pool, const Allocator& alloc)
+            : phase(Pending), cancel(false), finished(false),
+            allocator(alloc), states(word_allocator(alloc)), group(pool) {}
+
+        void copy() noexcept;
+        void retire() noexcept;
+        inline size_t rank(size_t) const noexcept;
+        void release(T*, size_t) noexcept;
+    };
+
+    TThreadPool* _bg_pool = nullptr;
+    std::unique_ptr<CompactionJob> _bg_job;
+    std::unique_ptr<CompactionJob> _bg_retiring;
+
+ public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using growth_policy = Growth;
+    using allocator_type = Allocator;
+
+    class Iterator {
+     private:
+        T* _ptr;
+        TVector* _parent;
+
+     public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = TVector::value_type;
+        using reference = TVector::reference;
+        using pointer = TVector::pointer;
+        using difference_type = TVector::difference_type;
+
+        Iterator(T*, TVector&) noexcept;
+        Iterator(const Iterator&) noexcept;
+
+        inline reference operator*();
+        inline pointer operator->() noexcept;
+        inline Iterator& operator=(const Iterator&) noexcept;
+        Iterator& operator++() noexcept;
+        inline Iterator operator++(int) noexcept;
+        Iterator& operator--() noexcept;
+        inline Iterator operator--(int) noexcept;
+        Iterator operator+(int) const;
+        Iterator operator-(int) const;
+        Iterator& operator+=(int);
+        Iterator& operator-=(int);
+        inline bool operator!=(const Iterator&) const noexcept;
+        inline bool operator==(const Iterator&) const noexcept;
+        difference_type operator-(const Iterator&) const;
+        inline difference_type index() const noexcept;
+        bool operator<(const Iterator&) const noexcept;
+        bool operator>(const Iterator&) const noexcept;
+        bool operator<=(const Iterator&) const noexcept;
+        bool operator>=(const Iterator&) const noexcept;
+        reference operator[](difference_type);
+    };
+
+    class ConstIterator {
+     private:
+        const T* _ptr;
+        const TVector* _parent;
+
+     public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = TVector::value_type;
+        using reference = TVector::const_reference;
+        using pointer = TVector::const_pointer;
+        using difference_type = TVector::difference_type;
+
+        ConstIterator(const T*, const TVector&) noexcept;
+        ConstIterator(const ConstIterator&) noexcept;
+
+        inline reference operator*();
+        inline pointer operator->() noexcept;
+        ConstIterator& operator++() noexcept;
+        inline ConstIterator operator++(int) noexcept;
+        ConstIterator& operator--() noexcept;
+        inline ConstIterator operator--(int) noexcept;
+        ConstIterator operator+(int) const;
+        ConstIterator operator-(int) const;
+        ConstIterator& operator+=(int);
+        ConstIterator& operator-=(int);
+        inline bool operator!=(const ConstIterator&) const noexcept;
+        inline bool operator==(const ConstIterator&) const noexcept;
+        difference_type operator-(const ConstIterator&) const;
+        inline difference_type index() const noexcept;
+        bool operator<(const ConstIterator&) const noexcept;
+        bool operator>(const ConstIterator&) const noexcept;
+        bool operator<=(const ConstIterator&) const noexcept;
+        bool operator>=(const ConstIterator&) const noexcept;
+        reference operator[](difference_type);
+    };
+
+    TVector() noexcept;
+    explicit TVector(const Allocator&) noexcept;
+    explicit TVector(size_type, const Allocator& = Allocator()) noexcept;
+    TVector(size_type, value_type, const Allocator& = Allocator());
+    TVector(const TVector&) noexcept;
+    TVector(TVector&&) noexcept;
+    TVector(pointer, size_type, const Allocator& = Allocator());
+    TVector(std::initializer_list<value_type>,
+        const Allocator& = Allocator()) noexcept;
+    ~TVector() noexcept;
+
+    inline pointer data() noexcept;
+    inline const_pointer data() const noexcept;
+    inline TBasicStatesView<word_allocator> states() const noexcept;
+    inline allocator_type get_allocator() const noexcept;
+    inline size_type size() const noexcept;
+    inline size_type used() const noexcept;
+    inline size_type capacity() const noexcept;
+    inline reference front();
+    inline reference back();
+    inline Iterator begin() noexcept;
+    inline Iterator end() noexcept;
+    inline ConstIterator begin() const noexcept;
+    inline ConstIterator end() const noexcept;
+
+    void push_back(const value_type&) noexcept;
+    void push_back(value_type&&) noexcept;
+    void push_front(const value_type&) noexcept;
+    void push_front(value_type&&) noexcept;
+    Iterator insert(Iterator, const value_type&) noexcept;
+    Iterator insert(Iterator position, size_type n,
+        const value_type& value) noexcept;
+    Iterator insert(Iterator, value_type&&) noexcept;
+    template <class... Args>
+    Iterator emplace(Iterator position, Args&&... args);
+    template <class InputIt, class = tv_iterator_category<InputIt>>
+    Iterator insert(Iterator position, InputIt first, InputIt last);
+    Iterator insert(Iterator, std::initializer_list<value_type>);
+    template <class InputIt, class = tv_iterator_category<InputIt>>
+    void append(InputIt first, InputIt last);
+    size_type insert_any(const value_type&) noexcept;
+    size_type insert_any(value_type&&) noexcept;
+    void pop_back();
+    void pop_front();
+    Iterator erase(Iterator);
+    Iterator erase(Iterator, Iterator);
+    template <class Predicate>
+    size_type erase_if(Predicate);
+    template <class Predicate>
+    size_type remove_if(Predicate);
+    void erase_slot(size_type);
+    reference at_slot(size_type);
+    const_reference at_slot(size_type) const;
+    void set_incremental_compaction(size_type) noexcept;
+    bool compact_step(size_type) noexcept;
+    void set_compaction_policy(const TCompactionPolicy&) noexcept;
+    inline const TCompactionPolicy& compaction_policy() const noexcept;
+    void set_compaction_hook(std::function<void(const TCompactionEvent&)>);
+    void compact();
+    void set_background_compaction(TThreadPool*) noexcept;
+
+    TVector& assign(const TVector&);
+    template <class InputIt, class = tv_iterator_category<InputIt>>
+    void assign(InputIt first, InputIt last);
+    reference at(size_type);
+    inline void clear() noexcept;
+    void shrink_to_fit();
+    void resize(size_type);
+    inline bool is_empty() const noexcept;
+    inline bool is_dense() const noexcept;
+    TDenseView<T> dense_view();
+    TDenseView<const T> dense_view() const;
+    TVector& operator=(const TVector&) noexcept;
+    TVector& operator=(TVector&&) noexcept;
+    bool operator==(const TVector&) const noexcept;
+    bool operator!=(const TVector&) const noexcept;
+    reference operator[](size_type);
+    const_reference operator[](size_type) const;
+
+    template<typename U, class G, class A>
+    friend std::ostream& operator<<(std::ostream&,
+        const TVector<U, G, A>&) noexcept;
+    template<typename U, class G, class A>
+    friend void shuffle(TVector<U, G, A>&) noexcept;
+
+ private:
+    void reset_memory_for_delete() noexcept;
+    void after_delete() noexcept;
+    void run_compaction(bool);
+    inline void tick_compaction() noexcept;
+    inline void note_busy(size_type) noexcept;
+    inline void restart_compaction() noexcept;
+    void adopt_compaction(TVector&) noexcept;
+    inline void note_free(size_type) noexcept;
+    size_type claim_slot() noexcept;
+    size_type free_slot() noexcept;
+    inline void destroy_slot(size_type);
+    void start_background(std::true_type) noexcept;
+    void start_background(std::false_type) noexcept;
+    inline void poll_background() noexcept;
+    void publish_background() noexcept;
+    inline void cancel_background() noexcept;
+    inline void unfreeze(size_type) noexcept;
+    void adopt_background(TVector&) noexcept;
+    void abandon_background() noexcept;
+    void retire_background(std::unique_ptr<CompactionJob>) noexcept;
+    void reset_memory(size_type) noexcept;
+    Iterator reset_memory(size_type, const Iterator&) noexcept;
+    size_type compact_into(T*, state_map&, size_type = 0, size_type = 0,
+        size_type = state_map::npos) noexcept;
+    size_type open_gap(size_type, size_type) noexcept;
+    template <class InputIt>
+    Iterator insert_range(Iterator, InputIt, InputIt,
+        std::input_iterator_tag);
+    template <class ForwardIt>
+    Iterator insert_range(Iterator, ForwardIt, ForwardIt,
+        std::forward_iterator_tag);
+    template <class ForwardIt>
+    void fill_gap(size_type, ForwardIt, size_type, std::false_type);
+    void fill_gap(size_type, const T*, size_type, std::true_type) noexcept;
+    size_type front_slot() const noexcept;
+    void make_front_room() noexcept;
+    inline void shift_right(size_type, size_type) noexcept;
+    inline T* allocate(size_type);
+    inline void deallocate(T*, size_type) noexcept;
+    void destroy_busy() noexcept;
+    inline bool is_full() const noexcept;
+    inline size_type grow_capacity(size_type) const noexcept;
+    static inline size_type initial_capacity(size_type) noexcept;
+    template <typename U, class G, class A>
+    friend size_t partition(TVector<U, G, A>&, size_type,
+        size_type, bool (*comp)(U, U))noexcept;
+    template <typename U, class G, class A>
+    friend void quick_sort(TVector<U, G, A>&, size_type,
+        size_type, bool (*comp)(U, U)) noexcept;
+    inline void swap_elem(size_type, size_type) noexcept;
+    inline size_type begin_index() const noexcept;
+    inline size_type end_index() const noexcept;
+    size_type offset_index(size_type, difference_type) const noexcept;
+
+    // Elements are relocated with memcpy/memmove when T is trivially
+    // copyable and element by element with std::move otherwise.
+    // Relocation constructs the destination and destroys the source.
+    // It is noexcept and has no rollback: a move (or, for types without
+    // one, a copy) that throws while relocating calls std::terminate.
+    using trivially_copyable =
+        std::integral_constant<bool, std::is_trivially_copyable<T>::value>;
+    static inline void relocate(T*, T*) noexcept;
+    static inline void relocate_elements(T*, T*, size_type,
+        std::true_type) noexcept;
+    static inline void relocate_elements(T*, T*, size_type,
+        std::false_type) noexcept;
+    inline void relocate_right(size_type, size_type,
+        std::true_type) noexcept;
+    inline void relocate_right(size_type, size_type,
+        std::false_type) noexcept;
+    static inline void relocate_left(T*, T*, size_type,
+        std::true_type) noexcept;
+    static inline void relocate_left(T*, T*, size_type,
+        std::false_type) noexcept;
+    void compact_in_place() noexcept;
+};
+
+#pragma region TVectorRealization
+
+template<typename T, class G, class A>
+TVector<T, G, A>::TVector() noexcept : _allocator(), _data(nullptr),
+_states(), _capacity(0), _used(0), _deleted(0) {}
+
+template<typename T, class G, class A>
+TVector<T, G, A>::TVector(const A& allocator) noexcept
+    : _allocator(allocator), _data(nullptr),
+_states(word_allocator(allocator)), _capacity(0), _used(0), _deleted(0) {}
+
+template<typename T, class G, class A>
+TVector<T, G, A>::TVector(size_type size, const A& allocator) noexcept
+    : _allocator(allocator), _states(word_allocator(allocator)), _used(size),
+_deleted(0) {
+    _capacity = initial_capacity(size) * (size > 0);
+    _data = allocate(_capacity);
+    _states.reset(_capacity);
+
+    for (size_type i = 0; i < _used; i++) {
+        new (_data + i) T();
+        _states.write(i, Busy);
+    }
+
+    _states.rebuild();
+}
+
+template<typename T, class G, class A>
+TVector<T, G, A>::TVector(size_type size, value_type elem,
+    const A& allocator) : _allocator(allocator),
+_states(word_allocator(allocator)), _used(size), _deleted(0) {
+    if (size == 0) {
+        throw std::runtime_error("TVector with value"
+                                 " can not be with zero size");
+    }
+
+    _capacity = initial_capacity(size) * (size > 0);
+    _data = allocate(_capacity);
+    _states.reset(_capacity);
+
+    for (size_type i = 0; i < _used; i++) {
+        new (_data + i) T(elem);
+        _states.write(i, Busy);
+    }
+
+    _states.rebuild();
+}
+
+template<typename T, class G, class A>
+TVector<T, G, A>::TVector(const TVector& other) noexcept :
+_allocator(allocator_traits::select_on_container_copy_construction(
+    other._allocator)), _data(allocate(other._capacity)),
+_states(other._states), _capacity(other._capacity), _used(other._used),
+_deleted(other._deleted), _front(other._front) {
+    for (size_type i = _states.next_busy(0, _used); i < _used;
+        i = _states.next_busy(i + 1, _used)) {
+        new (_data + i) T(other._data[i]);
+    }
+}
+
+template<typename T, class G, class A>
+TVector<T, G, A>::TVector(TVector&& other) noexcept :
+_allocator(std::move(other._allocator)), _data(other._data),
+_states(std::move(other._states)), _capacity(other._capacity),
+_used(other._used), _deleted(other._deleted), _front(other._front) {
+    other.cancel_background();
+    adopt_compaction(other);
+    other._data = nullptr;
+    other._used = 0;
+    other._deleted = 0;
+    other._front = 0;
+    other._capacity = 0;
+}
+
+template<typename T, class G, class A>
+TVector<T, G, A>::TVector(pointer array, size_type size,
+    const A& allocator) : _allocator(allocator),
+_states(word_allocator(allocator)), _used(size), _deleted(0) {
+    _capacity = initial_capacity(size) * (size > 0);
+    _data = allocate(_capacity);
+    _states.reset(_capacity);
+
+    for (size_type i = 0; i < _used; i++) {
+        new (_data + i) T(array[i]);
+        _states.write(i, Busy);
+    }
+
+    _states.rebuild();
+}
+
+template<typename T, class G, class A>
+TVector<T, G, A>::TVector(std::initializer_list<value_type> init,
+    const A& allocator) noexcept : _allocator(allocator),
+_states(word_allocator(allocator)), _used(init.size()), _deleted(0) {
+    size_type first_block = initial_capacity(0);
+
+    if (init.size() <= first_block)
+        _capacity = first_block * (init.size() > 0);
+    else
+        _capacity = initial_capacity(init.size());
+
+    _data = allocate(_capacity);
+    _states.reset(_capacity);
+    size_t index = 0;
+
+    for (const auto& elem : init) {
+        new (_data + index) T(elem);
+        _states.write(index, Busy);
+        index++;
+    }
+
+    _states.rebuild();
+}
+
+template<typename T, class G, class A>
+TVector<T, G, A>::~TVector() noexcept {
+    cancel_background();
+    _bg_retiring.reset();
+
+    if (_bg_pool != nullptr)
+        _bg_pool->detach();
+
+    destroy_busy();
+    deallocate(_data, _capacity);
+}
+
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::pointer TVector<T, G, A>::data() noexcept {
+    cancel_background();
+    return _data;
+}
+
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::const_pointer TVector<T, G, A>::data() const
+noexcept {
+    return _data;
+}
+
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::size_type
+TVector<T, G, A>::size() const noexcept {
+    return _used - _front - _deleted;
+}
+
+// Slots in use, tombstones included: the busy slots all lie in
+// [0, used()).
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::size_type
+TVector<T, G, A>::used() const noexcept {
+    return _used;
+}
+
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::size_type TVector<T, G, A>::capacity() const
+noexcept {
+    return _capacity;
+}
+
+template<typename T, class G, class A>
+inline TBasicStatesView<typename TVector<T, G, A>::word_allocator>
+TVector<T, G, A>::states() const noexcept {
+    return TBasicStatesView<word_allocator>(_states, _capacity);
+}
+
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::allocator_type
+TVector<T, G, A>::get_allocator() const noexcept {
+    return _allocator;
+}
+
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::reference TVector<T, G, A>::front() {
+    if (is_empty()) {
+        throw std::runtime_error("front() called on empty TVector");
+    }
+
+    unfreeze(begin_index());
+    return _data[begin_index()];
+}
+
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::reference TVector<T, G, A>::back() {
+    if (is_empty()) {
+        throw std::runtime_error("back() called on empty TVector");
+    }
+
+    unfreeze(end_index() - 1);
+    return _data[end_index() - 1];
+}
+
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::Iterator TVector<T, G, A>::begin() noexcept {
+    return Iterator(_data + begin_index(), *this);
+}
+
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::Iterator TVector<T, G, A>::end() noexcept {
+    return Iterator(_data + end_index(), *this);
+}
+
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::ConstIterator TVector<T, G, A>::begin() const
+noexcept {
+    return ConstIterator(_data + begin_index(), *this);
+}
+
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::ConstIterator TVector<T, G, A>::end() const
+noexcept {
+    return ConstIterator(_data + end_index(), *this);
+}
+
+template<typename T, class G, class A>
+void TVector<T, G, A>::push_back(const value_type& value) noexcept {
+    if (_bg_job && is_full()) {
+        poll_background();
+        cancel_background();
+    }
+
+    if (_used > 0 && _states.get(_used - 1) == Deleted &&
+        (!_bg_job || _used > _bg_job->frozen)) {
+        new (_data + _used - 1) T(value);
+        _states.set(_used - 1, Busy);
+        _deleted--;
+        note_busy(_used - 1);
+        tick_compaction();
+        return;
+    }
+
+    if (is_full()) {
+        reset_memory(size() + 1);
+    }
+
+    new (_data + _used) T(value);
+    _states.set(_used, Busy);
+    note_busy(_used);
+    _used++;
+    tick_compaction();
+}
+
+template<typename T, class G, class A>
+void TVector<T, G, A>::push_back(value_type&& value) noexcept {
+    if (_bg_job && is_full()) {
+        poll_background();
+        cancel_background();
+    }
+
+    if (_used > 0 && _states.get(_used - 1) == Deleted &&
+        (!_bg_job || _used > _bg_job->frozen)) {
+        new (_data + _used - 1) T(std::move(value));
+        _states.set(_used - 1, Busy);
+        _deleted--;
+        note_busy(_used - 1);
+        tick_compaction();
+        return;
+    }
+
+    if (is_full()) {
+        reset_memory(size() + 1);
+    }
+
+    new (_data + _used) T(std::move(value));
+    _states.set(_used, Busy);
+    note_busy(_used);
+    _used++;
+    tick_compaction();
+}
+
+template<typename T, class G, class A>
+void TVector<T, G, A>::push_front(const value_type& value) noexcept {
+    cancel_background();
+    size_type slot = front_slot();
+
+    if (slot == state_map::npos) {
+        make_front_room();
+        slot = _front - 1;
+    }
+
+    new (_data + slot) T(value);
+
+    if (slot < _front)
+        _front--;
+    else
+        _deleted--;
+
+    _states.set(slot, Busy);
+    note_busy(slot);
+    tick_compaction();
+}
+
+template<typename T, class G, class A>
+void TVector<T, G, A>::push_front(value_type&& value) noexcept {
+    cancel_background();
+    size_type slot = front_slot();
+
+    if (slot == state_map::npos) {
+        make_front_room();
+        slot = _front - 1;
+    }
+
+    new (_data + slot) T(std::move(value));
+
+    if (slot < _front)
+        _front--;
+    else
+        _deleted--;
+
+    _states.set(slot, Busy);
+    note_busy(slot);
+    tick_compaction();
+}
+
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator TVector<T, G, A>::insert(Iterator position,
+    const value_type& value) noexcept {
+    cancel_background();
+
+    if (!is_full()) {
+        size_t insert_index = position.index();
+
+        shift_right(insert_index, 1);
+
+        new (_data + insert_index) T(value);
+        _states.write(insert_index, Busy);
+        _used++;
+        _states.rebuild();
+
+        return position;
+    }
+
+    Iterator new_position = reset_memory(size() + 1, position);
+
+    size_t insert_index = new_position.index();
+
+    shift_right(insert_index, 1);
+
+    new (_data + insert_index) T(value);
+    _states.write(insert_index, Busy);
+    _used++;
+    _states.rebuild();
+
+    return new_position;
+}
+
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator TVector<T, G, A>::insert(Iterator position,
+    size_type n, const value_type& value) noexcept {
+    cancel_background();
+
+    if (_capacity - _used >= n) {
+        size_type insert_index = position.index();
+
+        shift_right(insert_index, n);
+
+        for (size_type i = insert_index; i < insert_index + n; i++) {
+            new (_data + i) T(value);
+            _states.write(i, Busy);
+            _used++;
+        }
+
+        _states.rebuild();
+
+        return position;
+    }
+
+    Iterator new_position = reset_memory(size() + n, position);
+
+    size_t insert_index = new_position.index();
+
+    shift_right(insert_index, n);
+
+    for (size_t i = insert_index; i < insert_index + n; i++) {
+        new (_data + i) T(value);
+        _states.write(i, Busy);
+        _used++;
+    }
+
+    _states.rebuild();
+
+    return new_position;
+}
+
+template<typename T, class G, class A>
+template<class ...Args>
+typename TVector<T, G, A>::Iterator TVector<T, G, A>::emplace(Iterator position,
+    Args && ...args) {
+    cancel_background();
+
+    if (!is_full()) {
+        size_t insert_index = position.index();
+
+        shift_right(insert_index, 1);
+
+        new (_data + insert_index) T(std::forward<Args>(args)...);
+        _states.write(insert_index, Busy);
+        _used++;
+        _states.rebuild();
+
+        return position;
+    }
+
+    Iterator new_position = reset_memory(size() + 1, position);
+
+    size_t insert_index = new_position.index();
+
+    shift_right(insert_index, 1);
+
+    new (_data + insert_index) T(std::forward<Args>(args)...);
+    _states.write(insert_index, Busy);
+    _used++;
+    _states.rebuild();
+
+    return new_position;
+}
+
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator
+TVector<T, G, A>::insert(Iterator position, value_type&& value)
+noexcept {
+    cancel_background();
+
+    if (!is_full()) {
+        size_t insert_index = position.index();
+
+        shift_right(insert_index, 1);
+
+        new (_data + insert_index) T(std::move(value));
+        _states.write(insert_index, Busy);
+        _used++;
+        _states.rebuild();
+
+        return position;
+    }
+
+    Iterator new_position = reset_memory(size() + 1, position);
+
+    size_t insert_index = new_position.index();
+
+    shift_right(insert_index, 1);
+
+    new (_data + insert_index) T(std::move(value));
+    _states.write(insert_index, Busy);
+    _used++;
+    _states.rebuild();
+
+    return new_position;
+}
+
+// Inserts the elements of [first, last) before position and returns an
+// iterator to the first of them. The buffer grows at most once, to the
+// capacity for the final size, and the elements after position are
+// relocated once. Pass move iterators to move the elements in. The
+// range must not point into this vector.
+template<typename T, class G, class A>
+template<class InputIt, class>
+typename TVector<T, G, A>::Iterator TVector<T, G, A>::insert(Iterator position,
+    InputIt first, InputIt last) {
+    cancel_background();
+    return insert_range(position, first, last,
+        tv_iterator_category<InputIt>());
+}
+
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator TVector<T, G, A>::insert(Iterator position,
+    std::initializer_list<value_type> init) {
+    return insert(position, init.begin(), init.end());
+}
+
+// Adds [first, last) after the last element. See insert().
+template<typename T, class G, class A>
+template<class InputIt, class>
+void TVector<T, G, A>::append(InputIt first, InputIt last) {
+    insert(end(), first, last);
+}
+
+// Inserts value in a free slot, the most recently freed tombstone first
+// (the free list is a stack, rebuilt lowest slot on top), and appends
+// only when there is none. Returns the slot, which stays
+// valid for at_slot and erase_slot until the vector is compacted or
+// rearranged. Order is not kept.
+template<typename T, class G, class A>
+typename TVector<T, G, A>::size_type
+TVector<T, G, A>::insert_any(const value_type& value) noexcept {
+    size_type slot = claim_slot();
+    new (_data + slot) T(value);
+    _states.set(slot, Busy);
+    note_busy(slot);
+    return slot;
+}
+
+template<typename T, class G, class A>
+typename TVector<T, G, A>::size_type
+TVector<T, G, A>::insert_any(value_type&& value) noexcept {
+    size_type slot = claim_slot();
+    new (_data + slot) T(std::move(value));
+    _states.set(slot, Busy);
+    note_busy(slot);
+    return slot;
+}
+
+template<typename T, class G, class A>
+void TVector<T, G, A>::pop_back() {
+    if (is_empty())
+        throw std::runtime_error("Pop with empty vector");
+
+    size_t remove_index = end_index() - 1;
+
+    destroy_slot(remove_index);
+    _states.set(remove_index, Deleted);
+    _deleted++;
+    note_free(remove_index);
+
+    after_delete();
+}
+
+template<typename T, class G, class A>
+void TVector<T, G, A>::pop_front() {
+    if (is_empty())
+        throw std::runtime_error("Pop with empty vector");
+
+    size_t remove_index = _states.next_busy(_front, _used);
+
+    destroy_slot(remove_index);
+    _states.set(remove_index, Deleted);
+    _deleted++;
+    note_free(remove_index);
+
+    after_delete();
+}
+
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator TVector<T, G, A>::erase(Iterator position) {
+    if (_data == nullptr)
+        throw std::runtime_error("Erase with empty vector");
+
+    size_t deleted_index = position.index();
+
+    if (_states.busy(deleted_index))
+        destroy_slot(deleted_index);
+
+    _states.set(deleted_index, Deleted);
+    _deleted++;
+    note_free(deleted_index);
+
+    after_delete();
+
+    return position;
+}
+
+// Turns the elements of [first, last) into tombstones and lets the
+// compaction policy run once for all of them. Returns an iterator to
+// the element that followed the range.
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator TVector<T, G, A>::erase(Iterator first,
+    Iterator last) {
+    if (_data == nullptr)
+        throw std::runtime_error("Erase with empty vector");
+
+    size_type from = first.index();
+    size_type to = last.index();
+    size_type rank = _states.rank(from);
+    size_type removed = 0;
+
+    for (size_type i = _states.next_busy(from, to); i < to;
+        i = _states.next_busy(i + 1, to)) {
+        destroy_slot(i);
+        _states.set(i, Deleted);
+        _deleted++;
+        note_free(i);
+        removed++;
+    }
+
+    if (removed > 0)
+        after_delete();
+
+    if (rank >= size())
+        return end();
+
+    return Iterator(_data + _states.select(rank), *this);
+}
+
+// Turns every element pred accepts into a tombstone in one pass over
+// the slots and returns how many there were. The compaction policy
+// runs once afterwards, so at most one compaction follows.
+template<typename T, class G, class A>
+template<class Predicate>
+typename TVector<T, G, A>::size_type
+TVector<T, G, A>::erase_if(Predicate pred) {
+    size_type removed = 0;
+
+    try {
+        for (size_type i = _states.next_busy(_front, _used); i < _used;
+            i = _states.next_busy(i + 1, _used)) {
+            if (!pred(static_cast<const T&>(_data[i])))
+                continue;
+
+            destroy_slot(i);
+            _states.write(i, Deleted);
+            _deleted++;
+            note_free(i);
+            removed++;
+        }
+    } catch (...) {
+        _states.rebuild();
+        throw;
+    }
+
+    if (removed == 0)
+        return 0;
+
+    _states.rebuild();
+    after_delete();
+
+    return removed;
+}
+
+// Removes every element pred accepts and slides the rest left over
+// them and over the old tombstones in the same pass, keeping order.
+// Returns the number removed. The buffer is reallocated only when the
+// growth policy shrinks it, and never more than once.
+template<typename T, class G, class A>
+template<class Predicate>
+typename TVector<T, G, A>::size_type
+TVector<T, G, A>::remove_if(Predicate pred) {
+    cancel_background();
+    size_type tombstones = _deleted;
+    size_type removed = 0;
+    size_type write = 0;
+    size_type i = _states.next_busy(_front, _used);
+
+    try {
+        for (; i < _used; i = _states.next_busy(i + 1, _used)) {
+            if (pred(static_cast<const T&>(_data[i]))) {
+                _data[i].~T();
+                removed++;
+                continue;
+            }
+
+            if (write != i)
+                relocate(_data + write, _data + i);
+
+            write++;
+        }
+    } catch (...) {
+        // Slots left behind the write position are tombstones now.
+        for (size_type j = 0; j < i; j++) {
+            _states.write(j, j < write ? Busy : Deleted);
+        }
+
+        _deleted = i - write;
+
+        for (size_type j = i; j < _used; j++) {
+            _deleted += _states.get(j) == Deleted ? 1 : 0;
+        }
+
+        _front = 0;
+        _states.rebuild();
+        restart_compaction();
+        throw;
+    }
+
+    for (size_type j = 0; j < _used; j++) {
+        _states.write(j, j < write ? Busy : Empty);
+    }
+
+    _used = write;
+    _deleted = 0;
+    _front = 0;
+    _states.rebuild();
+    restart_compaction();
+    _compaction.compacted();
+
+    if (removed + tombstones > 0 &&
+        tv_shrink_capacity<G>(_capacity, _used, sizeof(T), 0) != _capacity)
+        reset_memory_for_delete();
+
+    return removed;
+}
+
+template<typename T, class G, class A>
+void TVector<T, G, A>::erase_slot(size_type slot) {
+    if (slot >= _used || !_states.busy(slot))
+        throw std::out_of_range("TVector erase_slot: Slot is not busy.");
+
+    destroy_slot(slot);
+    _states.set(slot, Deleted);
+    _deleted++;
+    note_free(slot);
+
+    after_delete();
+}
+
+template<typename T, class G, class A>
+typename TVector<T, G, A>::reference
+TVector<T, G, A>::at_slot(size_type slot) {
+    if (slot >= _used || !_states.busy(slot))
+        throw std::out_of_range("TVector at_slot: Slot is not busy.");
+
+    unfreeze(slot);
+    return _data[slot];
+}
+
+template<typename T, class G, class A>
+typename TVector<T, G, A>::const_reference
+TVector<T, G, A>::at_slot(size_type slot) const {
+    if (slot >= _used || !_states.busy(slot))
+        throw std::out_of_range("TVector at_slot: Slot is not busy.");
+
+    return _data[slot];
+}
+
+// Moves per mutating call for incremental compaction. Once the
+// compaction policy is due, erase, pop_back, pop_front, push_back and
+// push_front each slide up to moves elements left instead of one call
+// compacting the whole buffer. 0 (the default) keeps the full pass.
+template<typename T, class G, class A>
+void TVector<T, G, A>::set_incremental_compaction(size_type moves) noexcept {
+    _compaction_step = moves;
+}
+
+// Runs up to budget element moves of incremental compaction, starting a
+// pass when there are tombstones, and returns false once none is left.
+// Leading tombstones join the front gap and trailing ones are dropped
+// from used() without moving anything. Capacity is kept.
+template<typename T, class G, class A>
+bool TVector<T, G, A>::compact_step(size_type budget) noexcept {
+    cancel_background();
+    if (_deleted == 0) {
+        _compacting = false;
+        return false;
+    }
+
+    if (!_compacting) {
+        _compacting = true;
+        restart_compaction();
+    }
+
+    size_type moves = 0;
+    size_type trims = budget * 64;
+
+    while (_deleted > 0 && moves < budget && trims > 0) {
+        if (_compact_write == _front && !_states.busy(_front)) {
+            _states.write(_front, Empty);
+            _front++;
+            _compact_write++;
+            _deleted--;
+            trims--;
+            continue;
+        }
+
+        size_type hole = _states.next_free(_compact_write, _used);
+        size_type from = hole + 1 > _compact_read ? hole + 1 : _compact_read;
+        size_type next = _states.next_busy(from, _used);
+
+        if (next < _used) {
+            relocate(_data + hole, _data + next);
+            _states.set(hole, Busy);
+            _states.set(next, Deleted);
+            note_free(next);
+            _compact_write = hole + 1;
+            _compact_read = next + 1;
+            moves++;
+            continue;
+        }
+
+        _compact_read = _used;
+
+        if (_used > hole) {
+            _used--;
+            _states.write(_used, Empty);
+            _deleted--;
+            trims--;
+            continue;
+        }
+
+        // The pass reached the end. Tombstones made behind it are left
+        // for the next one.
+        _compacting = false;
+        break;
+    }
+
+    if (_deleted == 0)
+        _compacting = false;
+
+    if (!_compacting)
+        _compaction.compacted();
+
+    return _deleted > 0;
+}
+
+// The default policy is TCompactionPolicy::threshold(150), 15% of the
+// used slots. The policy and the hook belong to this vector and are not
+// copied with its elements. A move takes them along, together with the
+// incremental step, and leaves the moved-from vector with the defaults.
+template<typename T, class G, class A>
+void TVector<T, G, A>::set_compaction_policy(
+    const TCompactionPolicy& policy) noexcept {
+    _compaction = policy;
+}
+
+template<typename T, class G, class A>
+inline const TCompactionPolicy&
+TVector<T, G, A>::compaction_policy() const noexcept {
+    return _compaction;
+}
+
+// Called after every compaction, automatic or through compact(), with
+// the number of tombstones removed. Incremental passes do not report.
+// Automatic compactions run inside noexcept calls, so the hook must not
+// throw.
+template<typename T, class G, class A>
+void TVector<T, G, A>::set_compaction_hook(
+    std::function<void(const TCompactionEvent&)> hook) {
+    _compaction_hook = std::move(hook);
+}
+
+// Removes every tombstone now, whatever the policy says.
+template<typename T, class G, class A>
+void TVector<T, G, A>::compact() {
+    cancel_background();
+
+    if (_deleted > 0)
+        run_compaction(true);
+}
+
+// Moves threshold compactions off the erase path. Once the policy is
+// due, erase and pop hand a snapshot of the busy slots to pool, which
+// copies the elements into a new buffer, and return. Until the copy is
+// published by a later erase, pop or push_back, elements freed in the
+// snapshot stay alive and push_back only appends.
+//
+// The pool only copies; the vector itself is not synchronized. Threads
+// that read it while another one writes need a lock of their own, as
+// with any TVector. A mutable reference to a snapshot slot (non-const
+// operator[], front(), back(), at_slot(), Iterator's *, -> and []) and
+// data(), dense_view() or any call that moves elements cancel the copy
+// and keep the layout. Mutable access to slots appended after the
+// snapshot and every const read do not.
+//
+// The vector attaches to pool, which must outlive it or be replaced
+// first; ~TThreadPool asserts it. A move takes the pool along and leaves
+// the moved-from vector detached. T's allocator must be usable from the
+// pool. nullptr switches back to inline compaction. The old buffer is
+// destroyed on the pool too, so T's destructor runs there.
+template<typename T, class G, class A>
+void TVector<T, G, A>::set_background_compaction(TThreadPool* pool) noexcept {
+    cancel_background();
+    _bg_retiring.reset();
+
+    if (_bg_pool != nullptr)
+        _bg_pool->detach();
+
+    _bg_pool = pool;
+
+    if (_bg_pool != nullptr)
+        _bg_pool->attach();
+
+    _compacting = false;
+}
+
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::destroy_slot(size_type slot) {
+    if (_bg_job && slot < _bg_job->frozen)
+        _bg_job->erased.push_back(slot);
+    else
+        _data[slot].~T();
+}
+
+template<typename T, class G, class A>
+void TVector<T, G, A>::start_background(std::true_type) noexcept {
+    if (_bg_retiring) {
+        if (!_bg_retiring->finished.load(std::memory_order_acquire))
+            return;
+
+        _bg_retiring.reset();
+    }
+
+    std::unique_ptr<CompactionJob> job(
+        new CompactionJob(*_bg_pool, _allocator));
+    size_type words = (_used + 63) / 64;
+    const uint64_t* busy = _states.busy_words();
+
+    job->source = _data;
+    job->capacity = _capacity;
+    job->frozen = _used;
+    job->tombstones = _deleted;
+    job->busy.assign(busy, busy + words);
+    job->ranks.resize(words);
+    job->data = allocate(_capacity);
+    job->states = state_map(_capacity, word_allocator(_allocator));
+
+    CompactionJob* raw = job.get();
+    job->group.run([raw] { raw->copy(); });
+    _bg_job = std::move(job);
+}
+
+// Elements that cannot be copied are compacted inline.
+template<typename T, class G, class A>
+void TVector<T, G, A>::start_background(std::false_type) noexcept {
+    run_compaction(false);
+}
+
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::poll_background() noexcept {
+    if (!_bg_job)
+        return;
+
+    int phase = _bg_job->phase.load(std::memory_order_acquire);
+
+    if (phase == CompactionJob::Copied) {
+        publish_background();
+    } else if (phase == CompactionJob::Stopped) {
+        abandon_background();
+        run_compaction(false);
+    }
+}
+
+// Swaps the copied buffer in. Frozen slots erased meanwhile become
+// tombstones at their new place and the slots appended after the
+// snapshot move behind the copied elements. The old buffer is released
+// on the pool.
+template<typename T, class G, class A>
+void TVector<T, G, A>::publish_background() noexcept {
+    std::unique_ptr<CompactionJob> job = std::move(_bg_job);
+    job->group.wait();
+
+    size_type index = job->count;
+    size_type deleted = job->erased.size();
+
+    for (size_type slot : job->erased) {
+        size_type moved = job->rank(slot);
+        job->data[moved].~T();
+        job->states.set(moved, Deleted);
+    }
+
+    for (size_type i = job->frozen; i < _used; i++, index++) {
+        State state = _states.get(i);
+
+        if (state == Busy)
+            relocate(job->data + index, _data + i);
+        else
+            deleted++;
+
+        job->states.set(index, state);
+    }
+
+    job->retired = _data;
+    _data = job->data;
+    job->data = nullptr;
+    _states = std::move(job->states);
+    _used = index;
+    _deleted = deleted;
+    _front = 0;
+    restart_compaction();
+
+    size_type tombstones = job->tombstones;
+    retire_background(std::move(job));
+    _compaction.compacted();
+
+    if (_compaction_hook)
+        _compaction_hook(TCompactionEvent{tombstones, size(), _capacity,
+            false});
+}
+
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::cancel_background() noexcept {
+    if (_bg_job)
+        abandon_background();
+}
+
+// Takes over the compaction settings of other, which is being moved into
+// this vector: the policy, the hook, the incremental step and the pool.
+// other is left with the defaults.
+template<typename T, class G, class A>
+void TVector<T, G, A>::adopt_compaction(TVector& other) noexcept {
+    _compaction = other._compaction;
+    other._compaction = TCompactionPolicy();
+    _compaction_hook = nullptr;
+    _compaction_hook.swap(other._compaction_hook);
+    _compaction_step = other._compaction_step;
+    other._compaction_step = 0;
+    adopt_background(other);
+}
+
+// Takes over the pool of other, which is being moved into this vector,
+// along with the buffer it still retires there. other is left detached.
+// Neither vector may have a copy running.
+template<typename T, class G, class A>
+void TVector<T, G, A>::adopt_background(TVector& other) noexcept {
+    _bg_retiring.reset();
+
+    if (_bg_pool != nullptr)
+        _bg_pool->detach();
+
+    _bg_pool = other._bg_pool;
+    _bg_retiring = std::move(other._bg_retiring);
+    other._bg_pool = nullptr;
+}
 
-template<typename T>
-TVector<T>::TVector() noexcept : _data(nullptr), _states(nullptr),
-_capacity(0), _used(0), _deleted(0) {}
+// Before a mutable reference to slot is handed out. The pool reads only
+// the frozen slots, so the copy goes on for the slots appended since.
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::unfreeze(size_type slot) noexcept {
+    if (_bg_job && slot < _bg_job->frozen)
+        cancel_background();
+}
 
-template<typename T>
-TVector<T>::TVector(size_type size) noexcept: _used(size), _deleted(0) {
-    _capacity = (size / _capacity_step + 1) * _capacity_step * (size > 0);
-    _data = new T[_capacity];
-    _states = new State[_capacity];
+// Stops the copy, waiting only for a copy already running to notice,
+// and destroys the elements erase and pop left alive for it.
+template<typename T, class G, class A>
+void TVector<T, G, A>::abandon_background() noexcept {
+    std::unique_ptr<CompactionJob> job = std::move(_bg_job);
+    int pending = CompactionJob::Pending;
+    job->cancel.store(true, std::memory_order_relaxed);
+
+    if (!job->phase.compare_exchange_strong(pending, CompactionJob::Stopped)) {
+        while (job->phase.load(std::memory_order_acquire) ==
+            CompactionJob::Copying) {
+            if (!_bg_pool->run_one())
+                std::this_thread::yield();
+        }
+    }
 
-    for (size_type i = 0; i < _used; i++) {
-        _data[i] = T();
-        _states[i] = Busy;
+    if (!std::is_trivially_destructible<T>::value) {
+        for (size_type slot : job->erased) {
+            _data[slot].~T();
+        }
     }
 
-    for (size_type i = _used; i < _capacity; i++) {
-        _states[i] = Empty;
+    if (job->phase.load(std::memory_order_acquire) == CompactionJob::Copied) {
+        job->retired = job->data;
+        job->data = nullptr;
+        job->frozen = job->count;
+        job->busy.clear();
     }
+
+    retire_background(std::move(job));
 }
 
-template<typename T>
-TVector<T>::TVector(size_type size, value_type elem): _used(size), _deleted(0) {
-    if (size == 0) {
-        throw std::runtime_error("TVector with value"
-                                 " can not be with zero size");
+// Hands the buffer the job retired, if any, to the pool to destroy and
+// free. The job is kept until that finished.
+template<typename T, class G, class A>
+void TVector<T, G, A>::retire_background(
+    std::unique_ptr<CompactionJob> job) noexcept {
+    _bg_retiring.reset();
+
+    if (job->retired != nullptr) {
+        CompactionJob* raw = job.get();
+
+        try {
+            job->group.run([raw] { raw->retire(); });
+        } catch (...) {
+            raw->retire();
+        }
     }
 
-    _capacity = (size / _capacity_step + 1) * _capacity_step * (size > 0);
-    _data = new T[_capacity];
-    _states = new State[_capacity];
+    _bg_retiring = std::move(job);
+}
+
+// Runs on the pool. Stops at the next word once cancel is set.
+template<typename T, class G, class A>
+void TVector<T, G, A>::CompactionJob::copy() noexcept {
+    int pending = Pending;
 
-    for (size_type i = 0; i < _used; i++) {
-        _data[i] = elem;
-        _states[i] = Busy;
+    if (!phase.compare_exchange_strong(pending, Copying)) {
+        release(data, 0);
+        data = nullptr;
+        finished.store(true, std::memory_order_release);
+        return;
     }
 
-    for (size_type i = _used; i < _capacity; i++) {
-        _states[i] = Empty;
+    size_t index = 0;
+    bool stopped = false;
+
+    try {
+        for (size_t word = 0; word < busy.size() && !stopped; word++) {
+            ranks[word] = index;
+            stopped = cancel.load(std::memory_order_relaxed);
+
+            for (uint64_t bits = busy[word]; bits != 0 && !stopped;
+                bits &= bits - 1) {
+                new (data + index) T(source[word * 64 + tv_ctz(bits)]);
+                index++;
+            }
+        }
+    } catch (...) {
+        stopped = true;
     }
-}
 
-template<typename T>
-TVector<T>::TVector(const TVector& other) noexcept : _used(other._used),
-_deleted(other._deleted), _capacity(other._capacity),
-_data(new T[other._capacity]), _states(new State[other._capacity]) {
-    for (int i = 0; i < _used; i++) {
-        _data[i] = other._data[i];
-        _states[i] = other._states[i];
+    if (stopped) {
+        release(data, index);
+        data = nullptr;
+        phase.store(Stopped, std::memory_order_release);
+        finished.store(true, std::memory_order_release);
+        return;
     }
 
-    for (int i = _used; i < _capacity; i++) {
-        _states[i] = Empty;
+    for (size_t i = 0; i < index; i++) {
+        states.write(i, Busy);
     }
-}
 
-template<typename T>
-TVector<T>::TVector(TVector&& other) noexcept :
-    _used(other._used), _deleted(other._deleted),
-_capacity(other._capacity) {
-    _states = other._states;
-    other._states = nullptr;
-    _data = other._data;
-    other._data = nullptr;
-    other._used = 0;
-    other._deleted = 0;
-    other._capacity = 0;
+    states.rebuild();
+    count = index;
+    phase.store(Copied, std::memory_order_release);
 }
 
-template<typename T>
-TVector<T>::TVector(pointer array, size_type size) : _used(size), _deleted(0) {
-    _capacity = (size / _capacity_step + 1) * _capacity_step * (size > 0);
-    _data = new T[_capacity];
-    _states = new State[_capacity];
+// Destroys what retired still holds, the snapshot's busy slots or the
+// first frozen slots when busy was cleared, and frees it.
+template<typename T, class G, class A>
+void TVector<T, G, A>::CompactionJob::retire() noexcept {
+    if (busy.empty()) {
+        release(retired, frozen);
+    } else {
+        if (!std::is_trivially_destructible<T>::value) {
+            for (size_t word = 0; word < busy.size(); word++) {
+                for (uint64_t bits = busy[word]; bits != 0;
+                    bits &= bits - 1) {
+                    retired[word * 64 + tv_ctz(bits)].~T();
+                }
+            }
+        }
 
-    for (size_type i = 0; i < _used; i++) {
-        _data[i] = array[i];
-        _states[i] = Busy;
+        release(retired, 0);
     }
 
-    for (size_type i = _used; i < _capacity; i++) {
-        _states[i] = Empty;
-    }
+    retired = nullptr;
+    finished.store(true, std::memory_order_release);
 }
 
-template<typename T>
-TVector<T>::TVector(std::initializer_list<value_type> init) noexcept
-    : _used(init.size()), _deleted(0) {
-    if (init.size() <= 15)
-        _capacity = _capacity_step * (init.size() > 0);
-    else
-        _capacity = (init.size() / _capacity_step + 1) *
-        _capacity_step * (init.size() > 0);
+template<typename T, class G, class A>
+inline size_t TVector<T, G, A>::CompactionJob::rank(size_t slot) const
+noexcept {
+    size_t word = slot / 64;
+    uint64_t below = busy[word] & ((uint64_t(1) << (slot % 64)) - 1);
 
-    _data = new T[_capacity];
-    _states = new State[_capacity];
-    size_t index = 0;
+    return ranks[word] + tv_popcount(below);
+}
 
-    for (const auto& elem : init) {
-        _data[index] = elem;
-        _states[index] = Busy;
-        index++;
-    }
+// Destroys the first constructed elements of buffer and frees it.
+template<typename T, class G, class A>
+void TVector<T, G, A>::CompactionJob::release(T* buffer,
+    size_t constructed) noexcept {
+    if (buffer == nullptr)
+        return;
 
-    for (; index < _capacity; index++) {
-        _data[index] = T();
-        _states[index] = Empty;
+    for (size_t i = 0; i < constructed; i++) {
+        buffer[i].~T();
     }
-}
 
-template<typename T>
-TVector<T>::~TVector() noexcept {
-    delete[] _data;
-    delete[] _states;
+    allocator_traits::deallocate(allocator, buffer, capacity);
 }
 
-template<typename T>
-inline typename TVector<T>::pointer TVector<T>::data() noexcept {
-    return _data;
+template<typename T, class G, class A>
+TVector<T, G, A>& TVector<T, G, A>::assign(const TVector& other) {
+    return *this = other;
 }
 
-template<typename T>
-inline typename TVector<T>::const_pointer TVector<T>::data() const noexcept {
-    return _data;
-}
+// Replaces the elements with [first, last). The buffer is kept when
+// they fit and reallocated once otherwise.
+template<typename T, class G, class A>
+template<class InputIt, class>
+void TVector<T, G, A>::assign(InputIt first, InputIt last) {
+    cancel_background();
+    destroy_busy();
+    _states.reset(_capacity);
+    _used = 0;
+    _deleted = 0;
+    _front = 0;
+    restart_compaction();
 
-template<typename T>
-inline typename TVector<T>::size_type TVector<T>::size() const noexcept {
-    return _used - _deleted;
+    insert_range(end(), first, last, tv_iterator_category<InputIt>());
 }
 
-template<typename T>
-inline typename TVector<T>::size_type TVector<T>::capacity() const noexcept {
-    return _capacity;
+template<typename T, class G, class A>
+void TVector<T, G, A>::clear() noexcept {
+    cancel_background();
+    destroy_busy();
+    deallocate(_data, _capacity);
+    _capacity = initial_capacity(0);
+    _deleted = 0;
+    _front = 0;
+    _used = 0;
+    restart_compaction();
+
+    _data = allocate(_capacity);
+    _states.reset(_capacity);
 }
 
-template<typename T>
-inline typename TVector<T>::reference TVector<T>::front() {
-    if (is_empty()) {
-        throw std::runtime_error("front() called on empty TVector");
-    }
+template<typename T, class G, class A>
+void TVector<T, G, A>::shrink_to_fit() {
+    cancel_background();
+    size_type old_capacity = _capacity;
+    _capacity = _used;
 
-    for (size_t i = 0; i < _used; i++) {
-        if (_states[i] == Busy)
-            return _data[i];
-    }
+    T* new_data = allocate(_capacity);
+    state_map new_states(_capacity, word_allocator(_allocator));
 
-    throw std::runtime_error("TVector internal state"
-                             " corrupted: no busy elements found");
-}
+    for (size_type i = _states.next_busy(0, _used); i < _used;
+        i = _states.next_busy(i, _used)) {
+        size_type run_end = _states.next_free(i, _used);
 
-template<typename T>
-inline typename TVector<T>::reference TVector<T>::back() {
-    if (is_empty()) {
-        throw std::runtime_error("back() called on empty TVector");
+        relocate_elements(new_data + i, _data + i, run_end - i,
+            trivially_copyable());
+        i = run_end;
     }
 
-    for (size_t i = _used; i > 0; i--) {
-        if (_states[i - 1] == Busy)
-            return _data[i - 1];
+    for (size_type i = 0; i < _capacity; i++) {
+        new_states.write(i, _states.get(i));
     }
 
-    throw std::runtime_error("TVector internal state"
-                             " corrupted: no busy elements found");
+    deallocate(_data, old_capacity);
+
+    _data = new_data;
+    _states = std::move(new_states);
+    _states.rebuild();
 }
 
-template<typename T>
-inline typename TVector<T>::Iterator TVector<T>::begin() noexcept {
-    if (size() == 0) {
-        return Iterator(&_data[0], *this);
-    }
+template<typename T, class G, class A>
+void TVector<T, G, A>::resize(size_type new_size) {
+    cancel_background();
+    reset_memory_for_delete();
+
+    if (new_size > _capacity) {
+        reset_memory(new_size);
+        for (size_type i = _used; i < new_size; i++) {
+            new (_data + i) T();
+            _states.write(i, Busy);
+        }
 
-    size_t begin_index = 0;
+        _used = new_size;
+        _states.rebuild();
+    } else if (new_size > _used) {
+        for (size_type i = _used; i < new_size; i++) {
+            new (_data + i) T();
+            _states.write(i, Busy);
+        }
 
-    for (size_t i = 0; i < _used; i++) {
-        if (_states[i] == Busy) {
-            begin_index = i;
-            break;
+        _used = new_size;
+        _states.rebuild();
+    } else {
+        for (size_type i = new_size; i < _used; i++) {
+            _data[i].~T();
+            _states.write(i, Empty);
         }
+
+        _used = new_size;
+        reset_memory_for_delete();
     }
+}
 
-    return Iterator(&_data[begin_index], *this);
+template<typename T, class G, class A>
+inline bool TVector<T, G, A>::is_empty() const noexcept {
+    return size() == 0;
 }
 
-template<typename T>
-inline typename TVector<T>::Iterator TVector<T>::end() noexcept {
-    if (size() == 0) {
-        return Iterator(&_data[0], *this);
-    }
+// No tombstones: elements occupy [data(), data() + size()) contiguously
+// and iterators take the pointer fast path.
+template<typename T, class G, class A>
+inline bool TVector<T, G, A>::is_dense() const noexcept {
+    return _deleted == 0;
+}
 
-    size_t end_index = _used;
+// Compacts the vector in place if it has tombstones and returns its
+// elements as one contiguous range. Capacity is kept.
+template<typename T, class G, class A>
+TDenseView<T> TVector<T, G, A>::dense_view() {
+    cancel_background();
+    if (_deleted > 0)
+        compact_in_place();
 
-    for (size_t i = _used; i > 0; i--) {
-        if (_states[i - 1] == Busy) {
-            end_index = i;
-            break;
-        }
-    }
+    return TDenseView<T>(_data + _front, _used - _front);
+}
 
-    return Iterator(&_data[end_index - 1] + 1, *this);
+template<typename T, class G, class A>
+TDenseView<const T> TVector<T, G, A>::dense_view() const {
+    if (_deleted > 0)
+        throw std::runtime_error("dense_view() on a const TVector"
+                                 " with tombstones");
+
+    return TDenseView<const T>(_data + _front, _used - _front);
 }
 
-template<typename T>
-inline typename TVector<T>::ConstIterator TVector<T>::begin() const noexcept {
-    if (size() == 0) {
-        return ConstIterator(&_data[0], *this);
-    }
+template<typename T, class G, class A>
+TVector<T, G, A>& TVector<T, G, A>::operator=(const TVector& other) noexcept {
+    if (this != &other) {
+        cancel_background();
+        destroy_busy();
+        deallocate(_data, _capacity);
 
-    size_t begin_index = 0;
+        _capacity = other._capacity;
+        _used = other._used;
+        _deleted = other._deleted;
+        _front = other._front;
+        _compacting = false;
+        restart_compaction();
+        _data = allocate(_capacity);
+        _states = other._states;
 
-    for (size_t i = 0; i < _used; i++) {
-        if (_states[i] == Busy) {
-            begin_index = i;
-            break;
+        for (size_type i = _states.next_busy(0, _used); i < _used;
+            i = _states.next_busy(i + 1, _used)) {
+            new (_data + i) T(other._data[i]);
         }
     }
 
-    return ConstIterator(&_data[begin_index], *this);
+    return *this;
 }
 
-template<typename T>
-inline typename TVector<T>::ConstIterator TVector<T>::end() const noexcept {
-    if (size() == 0) {
-        return ConstIterator(&_data[0], *this);
-    }
-
-    size_t end_index = _used;
-
-    for (size_t i = _used; i > 0; i--) {
-        if (_states[i - 1] == Busy) {
-            end_index = i;
-            break;
+template<typename T, class G, class A>
+TVector<T, G, A>& TVector<T, G, A>::operator=(TVector&& other) noexcept {
+    if (this != &other) {
+        cancel_background();
+        other.cancel_background();
+
+        if (!allocator_traits::propagate_on_container_move_assignment::value
+            && !(_allocator == other._allocator)) {
+            *this = other;
+            adopt_compaction(other);
+            return *this;
         }
+
+        destroy_busy();
+        deallocate(_data, _capacity);
+        _allocator = other._allocator;
+        _capacity = other._capacity;
+        _used = other._used;
+        _deleted = other._deleted;
+        _front = other._front;
+        _data = other._data;
+        other._data = nullptr;
+        _states = std::move(other._states);
+        other._capacity = 0;
+        other._used = 0;
+        other._deleted = 0;
+        other._front = 0;
+        _compacting = false;
+        restart_compaction();
+        adopt_compaction(other);
     }
 
-    return ConstIterator(&_data[end_index - 1] + 1, *this);
+    return *this;
 }
 
-template<typename T>
-void TVector<T>::push_back(const value_type& value) noexcept {
-    if (_states != nullptr && _states[_used - 1] == Deleted) {
-        _data[_used - 1] = value;
-        _states[_used - 1] = Busy;
-        _deleted--;
-        return;
-    }
+template<typename T, class G, class A>
+bool TVector<T, G, A>::operator==(const TVector& other) const noexcept {
+    if (size() != other.size())
+        return false;
 
-    if (is_full()) {
-        reset_memory(size() + 1);
+    for (size_type i = 0; i < size(); i++) {
+        if ((*this)[i] != other[i])
+            return false;
     }
 
-    _data[_used] = value;
-    _states[_used] = Busy;
-    _used++;
+    return true;
 }
 
-template<typename T>
-void TVector<T>::push_back(value_type&& value) noexcept {
-    if (_states != nullptr && _states[_used - 1] == Deleted) {
-        _data[_used - 1] = std::move(value);
-        _states[_used - 1] = Busy;
-        _deleted--;
-        return;
+template<typename T, class G, class A>
+bool TVector<T, G, A>::operator!=(const TVector& other) const noexcept {
+    return !(*this == other);
+}
+
+template<typename T, class G, class A>
+typename TVector<T, G, A>::reference
+TVector<T, G, A>::operator[](size_type index) {
+    if (index >= _used - _front) {
+        throw std::out_of_range("TVector operator[]: Index out of range.");
     }
 
-    if (is_full()) {
-        reset_memory(size() + 1);
+    if (_deleted == 0) {
+        unfreeze(_front + index);
+        return _data[_front + index];
     }
 
-    _data[_used] = std::move(value);
-    _states[_used] = Busy;
-    _used++;
+    if (index >= size()) {
+        throw std::out_of_range("TVector operator[]: Index out of range.");
+    }
+
+    size_type slot = _states.select(index);
+    unfreeze(slot);
+    return _data[slot];
 }
 
-template<typename T>
-void TVector<T>::push_front(const value_type& value) noexcept {
-    if (_states != nullptr && _states[0] == Deleted) {
-        _data[0] = value;
-        _states[0] = Busy;
-        _deleted--;
-        return;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::const_reference
+TVector<T, G, A>::operator[](size_type index) const {
+    if (index >= _used - _front) {
+        throw std::out_of_range("TVector operator[]: Index out of range.");
     }
 
-    if (is_full())
-        reset_memory(size() + 1);
+    if (_deleted == 0) {
+        return _data[_front + index];
+    }
 
-    for (size_t i = _used; i > 0; i--) {
-        _data[i] = _data[i - 1];
-        _states[i] = _states[i - 1];
+    if (index >= size()) {
+        throw std::out_of_range("TVector operator[]: Not found.");
     }
 
-    _data[0] = value;
-    _states[0] = Busy;
-    _used++;
+    return _data[_states.select(index)];
 }
 
-template<typename T>
-void TVector<T>::push_front(value_type&& value) noexcept {
-    if (_states != nullptr && _states[0] == Deleted) {
-        _data[0] = std::move(value);
-        _states[0] = Busy;
-        _deleted--;
+// Squeezes the tombstones and the front gap out. The growth policy
+// decides whether the buffer shrinks; when it keeps the capacity the
+// elements slide down in place and nothing is allocated.
+template<typename T, class G, class A>
+void TVector<T, G, A>::reset_memory_for_delete() noexcept {
+    size_type correct_size = size();
+    size_type new_capacity =
+        tv_shrink_capacity<G>(_capacity, correct_size, sizeof(T), 0);
+
+    if (new_capacity == _capacity) {
+        compact_in_place();
         return;
     }
 
-    if (is_full())
-        reset_memory(size() + 1);
+    T* new_data = allocate(new_capacity);
+    state_map new_states(new_capacity, word_allocator(_allocator));
 
-    for (size_t i = _used; i > 0; i--) {
-        _data[i] = _data[i - 1];
-        _states[i] = _states[i - 1];
-    }
+    compact_into(new_data, new_states);
 
-    _data[0] = std::move(value);
-    _states[0] = Busy;
-    _used++;
+    deallocate(_data, _capacity);
+    _capacity = new_capacity;
+    _deleted = 0;
+    _front = 0;
+    _used = correct_size;
+    _data = new_data;
+    _states = std::move(new_states);
+    _states.rebuild();
+    restart_compaction();
 }
 
-template<typename T>
-typename TVector<T>::Iterator TVector<T>::insert(Iterator position,
-    const value_type& value) noexcept {
-    if (!is_full()) {
-        size_t insert_index = position.index();
-
-        for (size_t i = _used; i > insert_index; i--) {
-            _data[i] = _data[i - 1];
-            _states[i] = _states[i - 1];
-        }
+// Called once an element became a tombstone.
+template<typename T, class G, class A>
+void TVector<T, G, A>::after_delete() noexcept {
+    if (_bg_pool != nullptr) {
+        poll_background();
 
-        _data[insert_index] = value;
-        _states[insert_index] = Busy;
-        _used++;
+        if (!_bg_job && _compaction.due(_deleted, _used - _front, sizeof(T)))
+            start_background(std::is_copy_constructible<T>());
 
-        return position;
+        return;
     }
 
-    Iterator new_position = reset_memory(size() + 1, position);
+    bool over = _compaction.due(_deleted, _used - _front, sizeof(T));
 
-    size_t insert_index = new_position.index();
+    if (_compaction_step == 0) {
+        if (over)
+            run_compaction(false);
 
-    for (size_t i = _used; i > insert_index; i--) {
-        _data[i] = _data[i - 1];
-        _states[i] = _states[i - 1];
+        return;
     }
 
-    _data[insert_index] = value;
-    _states[insert_index] = Busy;
-    _used++;
-
-    return new_position;
+    if (_compacting || over)
+        compact_step(_compaction_step);
 }
 
-template<typename T>
-typename TVector<T>::Iterator TVector<T>::insert(Iterator position,
-    size_type n, const value_type& value) noexcept {
-    if (_capacity - _used >= n) {
-        size_type insert_index = position.index();
+template<typename T, class G, class A>
+void TVector<T, G, A>::run_compaction(bool manual) {
+    size_type tombstones = _deleted;
+    reset_memory_for_delete();
+    _compaction.compacted();
 
-        for (size_type i = _used + n - 1; i >= insert_index + n; i--) {
-            _data[i] = _data[i - n];
-            _states[i] = _states[i - n];
-        }
+    if (_compaction_hook)
+        _compaction_hook(TCompactionEvent{tombstones, size(), _capacity,
+            manual});
+}
 
-        for (size_type i = insert_index; i < insert_index + n; i++) {
-            _data[i] = value;
-            _states[i] = Busy;
-            _used++;
-        }
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::tick_compaction() noexcept {
+    if (_compacting)
+        compact_step(_compaction_step);
+}
 
-        return position;
-    }
+// Keeps the compaction cursors valid when slot turns busy.
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::note_busy(size_type slot) noexcept {
+    if (slot < _compact_read)
+        _compact_read = slot;
+}
 
-    Iterator new_position = reset_memory(size() + n, position);
+// Cursors back to the first element after the slots were rearranged.
+// The free list is dropped with them.
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::restart_compaction() noexcept {
+    _compact_write = _front;
+    _compact_read = _front;
+    _free.clear();
+    _free_valid = false;
+}
 
-    size_t insert_index = new_position.index();
+// Records a new tombstone for insert_any. A list grown well past the
+// tombstone count is mostly stale entries and is collected anew, as is
+// one that could not grow.
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::note_free(size_type slot) noexcept {
+    if (!_free_valid)
+        return;
 
-    for (size_t i = _used + n - 1; i >= insert_index + n; i--) {
-        _data[i] = _data[i - n];
-        _states[i] = _states[i - n];
+    if (_free.size() > 2 * _deleted + 64) {
+        _free.clear();
+        _free_valid = false;
+        return;
     }
 
-    for (size_t i = insert_index; i < insert_index + n; i++) {
-        _data[i] = value;
-        _states[i] = Busy;
-        _used++;
+    try {
+        _free.push_back(slot);
+    } catch (...) {
+        _free.clear();
+        _free_valid = false;
     }
-
-    return new_position;
 }
 
-template<typename T>
-template<class ...Args>
-typename TVector<T>::Iterator TVector<T>::emplace(Iterator position,
-    Args && ...args) {
-    if (!is_full()) {
-        size_t insert_index = position.index();
+// The slot insert_any constructs into, already counted in used() and
+// no longer counted as a tombstone. The compaction step runs first so
+// it cannot move the new element off the returned slot.
+template<typename T, class G, class A>
+typename TVector<T, G, A>::size_type TVector<T, G, A>::claim_slot() noexcept {
+    tick_compaction();
 
-        for (size_t i = _used; i > insert_index; i--) {
-            _data[i] = _data[i - 1];
-            _states[i] = _states[i - 1];
-        }
+    if (_bg_job)
+        poll_background();
 
-        _data[insert_index] = T(args ...);
-        _states[insert_index] = Busy;
-        _used++;
+    size_type slot = free_slot();
 
-        return position;
+    if (slot < _used) {
+        _deleted--;
+        return slot;
     }
 
-    Iterator new_position = reset_memory(size() + 1, position);
-
-    size_t insert_index = new_position.index();
-
-    for (size_t i = _used; i > insert_index; i--) {
-        _data[i] = _data[i - 1];
-        _states[i] = _states[i - 1];
-    }
+    if (_bg_job && is_full())
+        cancel_background();
 
-    _data[insert_index] = T(args ...);
-    _states[insert_index] = Busy;
-    _used++;
+    if (is_full())
+        reset_memory(size() + 1);
 
-    return new_position;
+    return _used++;
 }
 
-template<typename T>
-typename TVector<T>::Iterator
-TVector<T>::insert(Iterator position, value_type&& value)
-noexcept {
-    if (!is_full()) {
-        size_t insert_index = position.index();
-
-        for (size_t i = _used; i > insert_index; i--) {
-            _data[i] = _data[i - 1];
-            _states[i] = _states[i - 1];
+// Pops the free list down to a tombstone that can be refilled, or
+// returns used() when there is none. Slots frozen by a background
+// compaction are skipped: the pool still copies from them.
+template<typename T, class G, class A>
+typename TVector<T, G, A>::size_type TVector<T, G, A>::free_slot() noexcept {
+    if (_deleted == 0)
+        return _used;
+
+    if (!_free_valid) {
+        // Without memory for the list the value is appended instead.
+        try {
+            for (size_type i = _states.next_free(_front, _used); i < _used;
+                i = _states.next_free(i + 1, _used)) {
+                if (_states.get(i) == Deleted)
+                    _free.push_back(i);
+            }
+        } catch (...) {
+            _free.clear();
+            return _used;
         }
 
-        _data[insert_index] = std::move(value);
-        _states[insert_index] = Busy;
-        _used++;
-
-        return position;
+        std::reverse(_free.begin(), _free.end());
+        _free_valid = true;
     }
 
-    Iterator new_position = reset_memory(size() + 1, position);
+    size_type frozen = _bg_job ? _bg_job->frozen : 0;
 
-    size_t insert_index = new_position.index();
+    while (!_free.empty()) {
+        size_type slot = _free.back();
+        _free.pop_back();
 
-    for (size_t i = _used; i > insert_index; i--) {
-        _data[i] = _data[i - 1];
-        _states[i] = _states[i - 1];
+        if (slot >= frozen && slot >= _front && slot < _used &&
+            _states.get(slot) == Deleted)
+            return slot;
     }
 
-    _data[insert_index] = std::move(value);
-    _states[insert_index] = Busy;
-    _used++;
+    return _used;
+}
 
-    return new_position;
+template<typename T, class G, class A>
+void TVector<T, G, A>::reset_memory(size_type new_size) noexcept {
+    size_type size_diff = new_size - size();
+    size_type new_capacity = grow_capacity(new_size);
+    T* new_data = allocate(new_capacity);
+    state_map new_states(new_capacity, word_allocator(_allocator));
+
+    compact_into(new_data, new_states);
+
+    deallocate(_data, _capacity);
+    _capacity = new_capacity;
+    _deleted = 0;
+    _front = 0;
+    _used = new_size - size_diff;
+    _data = new_data;
+    _states = std::move(new_states);
+    _states.rebuild();
+    restart_compaction();
 }
 
-template<typename T>
-void TVector<T>::pop_back() {
-    if (_states == nullptr || _data == nullptr)
-        throw std::runtime_error("Pop with empty vector");
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator
+TVector<T, G, A>::reset_memory(size_type new_size,
+    const Iterator& insert_it) noexcept {
+    size_type new_insert_index = _states.rank(insert_it.index());
+    reset_memory(new_size);
 
-    size_t remove_index = _used - 1;
+    return Iterator(&_data[new_insert_index], *this);
+}
 
-    for (size_t i = _used - 1; i > 0; i--) {
-        if (_states[i] == Busy) {
-            remove_index = i;
-            break;
+// Relocates the busy elements of slots [from, to) into new_data from
+// slot first on, in runs of adjacent busy slots, and returns how many
+// were moved.
+template<typename T, class G, class A>
+typename TVector<T, G, A>::size_type
+TVector<T, G, A>::compact_into(T* new_data, state_map& new_states,
+    size_type first, size_type from, size_type to) noexcept {
+    size_type index = first;
+    size_type end = to < _used ? to : _used;
+
+    for (size_type i = _states.next_busy(from, end); i < end;
+        i = _states.next_busy(i, end)) {
+        size_type run_end = _states.next_free(i, end);
+
+        relocate_elements(new_data + index, _data + i, run_end - i,
+            trivially_copyable());
+
+        for (; i < run_end; i++, index++) {
+            new_states.write(index, Busy);
         }
     }
 
-    _states[remove_index] = Deleted;
-    _deleted++;
+    return index - first;
+}
 
-    if (_deleted >= _used * _removal_coefficient) {
-        reset_memory_for_delete();
+// Opens n slots before slot for a bulk insert and returns the first of
+// them. With room left the elements from slot on shift right in place.
+// Otherwise they are relocated into a buffer sized for size() + n on
+// either side of the gap, so the tombstones go in the same pass. The
+// new slots are not published: fill_gap() writes them.
+template<typename T, class G, class A>
+typename TVector<T, G, A>::size_type
+TVector<T, G, A>::open_gap(size_type slot, size_type n) noexcept {
+    if (_capacity - _used >= n) {
+        shift_right(slot, n);
+        _used += n;
+        return slot;
     }
-}
 
-template<typename T>
-void TVector<T>::pop_front() {
-    if (_states == nullptr || _data == nullptr)
-        throw std::runtime_error("Pop with empty vector");
+    size_type new_capacity = grow_capacity(size() + n);
+    T* new_data = allocate(new_capacity);
+    state_map new_states(new_capacity, word_allocator(_allocator));
 
-    size_t remove_index = 0;
+    size_type head = compact_into(new_data, new_states, 0, 0, slot);
+    size_type tail = compact_into(new_data, new_states, head + n, slot);
 
-    for (size_t i = 0; i < _used; i++) {
-        if (_states[i] == Busy) {
-            remove_index = i;
-            break;
-        }
-    }
+    deallocate(_data, _capacity);
+    _capacity = new_capacity;
+    _deleted = 0;
+    _front = 0;
+    _used = head + n + tail;
+    _data = new_data;
+    _states = std::move(new_states);
+    restart_compaction();
 
-    _states[remove_index] = Deleted;
-    _deleted++;
+    return head;
+}
 
-    if (_deleted >= _used * _removal_coefficient) {
-        reset_memory_for_delete();
+// A single pass range can not be counted up front, so it is gathered
+// first and then moved in.
+template<typename T, class G, class A>
+template<class InputIt>
+typename TVector<T, G, A>::Iterator
+TVector<T, G, A>::insert_range(Iterator position, InputIt first,
+    InputIt last, std::input_iterator_tag) {
+    TVector<T, TGrowth2x, A> buffer(_allocator);
+
+    for (; first != last; ++first) {
+        buffer.push_back(*first);
     }
-}
 
-template<typename T>
-typename TVector<T>::Iterator TVector<T>::erase(Iterator position) {
-    if (_states == nullptr || _data == nullptr)
-        throw std::runtime_error("Erase with empty vector");
+    return insert_range(position, std::make_move_iterator(buffer.data()),
+        std::make_move_iterator(buffer.data() + buffer.size()),
+        std::forward_iterator_tag());
+}
 
-    size_t deleted_index = position.index();
-    _states[deleted_index] = Deleted;
-    _deleted++;
+template<typename T, class G, class A>
+template<class ForwardIt>
+typename TVector<T, G, A>::Iterator
+TVector<T, G, A>::insert_range(Iterator position, ForwardIt first,
+    ForwardIt last, std::forward_iterator_tag) {
+    size_type n = static_cast<size_type>(std::distance(first, last));
+    size_type slot = open_gap(position.index(), n);
 
-    if (_deleted >= _used * _removal_coefficient) {
-        reset_memory_for_delete();
-    }
+    using copyable_pointer = std::integral_constant<bool,
+        trivially_copyable::value && (std::is_same<ForwardIt, T*>::value ||
+        std::is_same<ForwardIt, const T*>::value)>;
+    fill_gap(slot, first, n, copyable_pointer());
 
-    return position;
+    return Iterator(_data + slot, *this);
 }
 
-template<typename T>
-void TVector<T>::clear() noexcept {
-    delete[] _data;
-    delete[] _states;
-    _capacity = _capacity_step;
-    _deleted = 0;
-    _used = 0;
-
-    _data = new T[_capacity];
-    _states = new State[_capacity];
+// Constructs the n elements of the gap at slot from first. If one
+// throws, the slots left unfilled become tombstones.
+template<typename T, class G, class A>
+template<class ForwardIt>
+void TVector<T, G, A>::fill_gap(size_type slot, ForwardIt first,
+    size_type n, std::false_type) {
+    size_type i = slot;
+
+    try {
+        for (; i < slot + n; ++i, ++first) {
+            new (_data + i) T(*first);
+            _states.write(i, Busy);
+        }
+    } catch (...) {
+        for (; i < slot + n; i++) {
+            _states.write(i, Deleted);
+            _deleted++;
+        }
 
-    for (int i = 0; i < _capacity; i++) {
-        _data[i] = T();
-        _states[i] = Empty;
+        _states.rebuild();
+        throw;
     }
-}
 
-template<typename T>
-void TVector<T>::shrink_to_fit() {
-    _capacity = _used;
+    _states.rebuild();
+}
 
-    T* new_data = new T[_capacity];
-    State* new_states = new State[_capacity];
+template<typename T, class G, class A>
+void TVector<T, G, A>::fill_gap(size_type slot, const T* first,
+    size_type n, std::true_type) noexcept {
+    if (n > 0)
+        std::memcpy(static_cast<void*>(_data + slot), first, n * sizeof(T));
 
-    for (int i = 0; i < _capacity; i++) {
-        new_data[i] = _data[i];
-        new_states[i] = _states[i];
+    for (size_type i = slot; i < slot + n; i++) {
+        _states.write(i, Busy);
     }
 
-    delete[] _data;
-    delete[] _states;
-
-    _data = new_data;
-    _states = new_states;
+    _states.rebuild();
 }
 
-template<typename T>
-void TVector<T>::resize(size_type new_size) {
-    reset_memory_for_delete();
-
-    if (new_size > _capacity) {
-        reset_memory(new_size);
-        for (size_type i = _used; i < new_size; i++) {
-            _states[i] = Busy;
-        }
+// Slot push_front can fill without moving anything: the tombstone right
+// before the first element, else the last slot of the front gap. npos
+// when the first element sits in slot 0.
+template<typename T, class G, class A>
+typename TVector<T, G, A>::size_type
+TVector<T, G, A>::front_slot() const noexcept {
+    size_type first = is_empty() ? _used : _states.next_busy(_front, _used);
 
-        _used = new_size;
-    } else if (new_size > _used) {
-        for (size_type i = _used; i < new_size; i++) {
-            _states[i] = Busy;
-        }
+    if (first > _front)
+        return first - 1;
 
-        _used = new_size;
-    } else {
-        _used = new_size;
-        reset_memory_for_delete();
-    }
+    return _front > 0 ? _front - 1 : state_map::npos;
 }
 
-template<typename T>
-inline bool TVector<T>::is_empty() const noexcept {
-    return (_used - _deleted) == 0;
-}
+// Opens a front gap of at least a quarter of size(). When the free slots
+// at the back are more than size() / 2, half of them are moved to the
+// front by shifting the elements in place. Otherwise the vector grows by
+// at least half and the new free slots are split between both ends, so
+// push_front stays amortized O(1) under every growth policy.
+template<typename T, class G, class A>
+void TVector<T, G, A>::make_front_room() noexcept {
+    size_type count = size();
+    size_type free_back = _capacity - _used;
 
-template<typename T>
-TVector<T>& TVector<T>::operator=(const TVector& other) noexcept {
-    if (this != &other) {
-        delete[] _data;
-        delete[] _states;
+    if (free_back > count / 2) {
+        size_type gap = (free_back + 1) / 2;
 
-        _capacity = other._capacity;
-        _used = other._used;
-        _deleted = other._deleted;
-        _data = new T[_capacity];
-        _states = new State[_capacity];
+        shift_right(0, gap);
 
-        for (size_t i = 0; i < _used; i++) {
-            _data[i] = other._data[i];
-            _states[i] = other._states[i];
+        for (size_type i = 0; i < gap; i++) {
+            _states.write(i, Empty);
         }
 
-        for (size_t i = _used; i < _capacity; i++) {
-            _states[i] = Empty;
-        }
+        _used += gap;
+        _front = gap;
+        _states.rebuild();
+        restart_compaction();
+        return;
     }
 
-    return *this;
-}
+    size_type new_capacity = grow_capacity(count + 1 + count / 2);
+    size_type gap = (new_capacity - count + 1) / 2;
+    T* new_data = allocate(new_capacity);
+    state_map new_states(new_capacity, word_allocator(_allocator));
 
-template<typename T>
-TVector<T>& TVector<T>::operator=(TVector&& other) noexcept {
-    if (this != &other) {
-        delete[] _data;
-        delete[] _states;
-        _capacity = other._capacity;
-        _used = other._used;
-        _deleted = other._deleted;
-        _data = other._data;
-        other._data = nullptr;
-        _states = other._states;
-        other._states = nullptr;
-        other._capacity = 0;
-        other._used = 0;
-        other._deleted = 0;
-    }
+    compact_into(new_data, new_states, gap);
 
-    return *this;
+    deallocate(_data, _capacity);
+    _capacity = new_capacity;
+    _deleted = 0;
+    _front = gap;
+    _used = gap + count;
+    _data = new_data;
+    _states = std::move(new_states);
+    _states.rebuild();
+    restart_compaction();
 }
 
-template<typename T>
-bool TVector<T>::operator==(const TVector<value_type>& other) const noexcept {
-    if (size() != other.size())
-        return false;
+// Opens n slots at from by moving [from, _used) n slots to the right.
+// Indexes are published by the caller with _states.rebuild().
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::shift_right(size_type from, size_type n)
+noexcept {
+    if (n == 0 || from >= _used)
+        return;
 
-    for (size_type i = 0; i < size(); i++) {
-        if ((*this)[i] != other[i])
-            return false;
+    note_busy(from);
+    relocate_right(from, n, trivially_copyable());
+
+    for (size_type i = _used + n - 1; i >= from + n; i--) {
+        _states.write(i, _states.get(i - n));
     }
+}
 
-    return true;
+// Storage is raw: only busy slots hold live objects, Empty and Deleted
+// slots are never constructed.
+template<typename T, class G, class A>
+inline T* TVector<T, G, A>::allocate(size_type count) {
+    if (count == 0)
+        return nullptr;
+
+    return allocator_traits::allocate(_allocator, count);
 }
 
-template<typename T>
-bool TVector<T>::operator!=(const TVector<value_type>& other) const noexcept {
-    return !(*this == other);
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::deallocate(T* data, size_type count) noexcept {
+    if (data != nullptr)
+        allocator_traits::deallocate(_allocator, data, count);
 }
 
-template<typename T>
-typename TVector<T>::reference TVector<T>::operator[](size_type index) {
-    if (index >= _used) {
-        throw std::out_of_range("TVector operator[]: Index out of range.");
-    }
+template<typename T, class G, class A>
+void TVector<T, G, A>::destroy_busy() noexcept {
+    if (std::is_trivially_destructible<T>::value)
+        return;
 
-    if (_deleted == 0) {
-        return _data[index];
+    for (size_type i = _states.next_busy(0, _used); i < _used;
+        i = _states.next_busy(i + 1, _used)) {
+        _data[i].~T();
     }
+}
 
-    size_type current_index = 0;
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::relocate(T* dest, T* src) noexcept {
+    new (dest) T(std::move(*src));
+    src->~T();
+}
 
-    for (size_type i = 0; i < _used; i++) {
-        if (_states[i] == Busy) {
-            if (current_index == index)
-                return _data[i];
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::relocate_elements(T* dest, T* src,
+    size_type count, std::true_type) noexcept {
+    if (count > 0)
+        std::memcpy(static_cast<void*>(dest), src, count * sizeof(T));
+}
 
-            current_index++;
-        }
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::relocate_elements(T* dest, T* src,
+    size_type count, std::false_type) noexcept {
+    for (size_type i = 0; i < count; i++) {
+        relocate(dest + i, src + i);
     }
-
-    throw std::out_of_range("TVector operator[]: Index out of range.");
 }
 
-template<typename T>
-typename TVector<T>::const_reference
-TVector<T>::operator[](size_type index) const {
-    if (index >= _used) {
-        throw std::out_of_range("TVector operator[]: Index out of range.");
-    }
+// Tombstones are copied along with the objects, their bytes are never read.
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::relocate_right(size_type from, size_type n,
+    std::true_type) noexcept {
+    std::memmove(static_cast<void*>(_data + from + n), _data + from,
+        (_used - from) * sizeof(T));
+}
 
-    if (_deleted == 0) {
-        return _data[index];
+// Walks backwards, so every destination is either past _used or already
+// vacated by the previous step.
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::relocate_right(size_type from, size_type n,
+    std::false_type) noexcept {
+    for (size_type i = _states.prev_busy(_used);
+        i != state_map::npos && i >= from; i = _states.prev_busy(i)) {
+        relocate(_data + i + n, _data + i);
     }
+}
 
-    size_type current_index = 0;
-
-    for (size_type i = 0; i < _used; i++) {
-        if (_states[i] == Busy) {
-            if (current_index == index)
-                return _data[i];
-
-            current_index++;
-        }
-    }
+// Left shifts overlap their source, so only forward copies are safe.
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::relocate_left(T* dest, T* src,
+    size_type count, std::true_type) noexcept {
+    if (count > 0)
+        std::memmove(static_cast<void*>(dest), src, count * sizeof(T));
+}
 
-    throw std::out_of_range("TVector operator[]: Not found.");
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::relocate_left(T* dest, T* src,
+    size_type count, std::false_type) noexcept {
+    relocate_elements(dest, src, count, std::false_type());
 }
 
-template<typename T>
-void TVector<T>::reset_memory_for_delete() noexcept {
-    size_type correct_size = size();
-    size_type new_capacity =
-        (correct_size / _capacity_step + 1) * _capacity_step;
-    T* new_data = new T[new_capacity];
-    State* new_states = new State[new_capacity];
+// Slides the busy runs left over the tombstones inside the same buffer,
+// keeping their order. Nothing is allocated and capacity is kept.
+template<typename T, class G, class A>
+void TVector<T, G, A>::compact_in_place() noexcept {
     size_type index = 0;
 
-    for (size_type i = 0; i < _used; i++) {
-        if (_states[i] == Busy) {
-            new_data[index] = _data[i];
-            new_states[index] = Busy;
-            index++;
-        }
+    for (size_type i = _states.next_busy(0, _used); i < _used;
+        i = _states.next_busy(i, _used)) {
+        size_type run_end = _states.next_free(i, _used);
+
+        if (index != i)
+            relocate_left(_data + index, _data + i, run_end - i,
+                trivially_copyable());
+
+        index += run_end - i;
+        i = run_end;
     }
 
-    for (size_type i = index; i < new_capacity; i++) {
-        new_data[i] = T();
-        new_states[i] = Empty;
+    for (size_type i = 0; i < _used; i++) {
+        _states.write(i, i < index ? Busy : Empty);
     }
 
-    _capacity = new_capacity;
+    _used = index;
     _deleted = 0;
-    _used = correct_size;
-    delete[] _data;
-    delete[] _states;
-    _data = new_data;
-    _states = new_states;
+    _front = 0;
+    _states.rebuild();
+    restart_compaction();
 }
 
-template<typename T>
-void TVector<T>::reset_memory(size_type new_size) noexcept {
-    size_type size_diff = new_size - size();
-    size_type new_capacity = (new_size / _capacity_step + 1) * _capacity_step;
-    T* new_data = new T[new_capacity];
-    State* new_states = new State[new_capacity];
-    size_type index = 0;
-
-    for (size_type i = 0; i < _used; i++) {
-        if (_states[i] == Busy) {
-            new_data[index] = _data[i];
-            new_states[index] = Busy;
-            index++;
-        }
-    }
-
-    for (size_type i = index; i < new_capacity; i++) {
-        new_data[i] = T();
-        new_states[i] = Empty;
-    }
+template<typename T, class G, class A>
+inline bool TVector<T, G, A>::is_full() const noexcept {
+    return _used == _capacity;
+}
 
-    _capacity = new_capacity;
-    _deleted = 0;
-    _used = new_size - size_diff;
-    delete[] _data;
-    delete[] _states;
-    _data = new_data;
-    _states = new_states;
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::size_type
+TVector<T, G, A>::grow_capacity(size_type required) const noexcept {
+    return G::capacity_for(_capacity, required, sizeof(T));
 }
 
-template<typename T>
-typename TVector<T>::Iterator TVector<T>::reset_memory(size_type new_size,
-    const Iterator& insert_it) noexcept {
-    size_type new_insert_index = insert_it.index();
-    reset_memory(new_size);
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::size_type
+TVector<T, G, A>::initial_capacity(size_type required) noexcept {
+    return G::capacity_for(0, required, sizeof(T));
+}
 
-    return Iterator(&_data[new_insert_index], *this);
+template<typename T, class G, class A>
+inline void TVector<T, G, A>::swap_elem(size_type first_index,
+    size_type second_index)
+noexcept {
+    cancel_background();
+    bool first_busy = _states.busy(first_index);
+    bool second_busy = _states.busy(second_index);
+
+    if (first_busy && second_busy)
+        std::swap(_data[first_index], _data[second_index]);
+    else if (first_busy)
+        relocate(_data + second_index, _data + first_index);
+    else if (second_busy)
+        relocate(_data + first_index, _data + second_index);
+
+    State temp_state = _states.get(first_index);
+    _states.write(first_index, _states.get(second_index));
+    _states.write(second_index, temp_state);
+    restart_compaction();
 }
 
-template<typename T>
-inline bool TVector<T>::is_full() const noexcept {
-    return _used == _capacity;
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::size_type
+TVector<T, G, A>::begin_index() const
+noexcept {
+    return is_empty() ? _front : _states.next_busy(_front, _used);
 }
 
-template<typename T>
-inline void TVector<T>::swap_elem(size_type first_index, size_type second_index)
+// One past the last busy slot, so trailing tombstones stay outside
+// of [begin(), end()). A run of trailing tombstones (a queue fed by
+// push_front and drained by pop_back) is skipped with select().
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::size_type TVector<T, G, A>::end_index() const
 noexcept {
-    T temp_elem = _data[first_index];
-    _data[first_index] = _data[second_index];
-    _data[second_index] = temp_elem;
+    if (is_empty())
+        return _front;
 
-    State temp_state = _states[first_index];
-    _states[first_index] = _states[second_index];
-    _states[second_index] = temp_state;
+    if (_states.busy(_used - 1))
+        return _used;
+
+    return _states.select(size() - 1) + 1;
 }
 
-template<typename T>
-std::ostream& operator<<(std::ostream& stream, const TVector<T>& out) noexcept {
+// Slot reached by moving num busy elements away from index, or npos when
+// that leaves [begin(), end()]. Tombstones are skipped through rank/select.
+template<typename T, class G, class A>
+typename TVector<T, G, A>::size_type
+TVector<T, G, A>::offset_index(size_type index,
+    difference_type num) const noexcept {
+    if (num == 0)
+        return index;
+
+    size_type end = end_index();
+    difference_type rank = static_cast<difference_type>(
+        index < end ? _states.rank(index) : size());
+
+    if (num > 0 && index < end && !_states.busy(index))
+        rank--;
+
+    difference_type target = rank + num;
+
+    if (target < 0 || target > static_cast<difference_type>(size()))
+        return state_map::npos;
+
+    if (target == static_cast<difference_type>(size()))
+        return end_index();
+
+    return _states.select(static_cast<size_type>(target));
+}
+
+template<typename T, class G, class A>
+std::ostream& operator<<(std::ostream& stream, const TVector<T, G, A>& out)
+noexcept {
     stream << "size(" << out._used << ") capacity(" <<
         out._capacity << ") deleted(" << out._deleted << ") vector: [ ";
 
@@ -982,19 +3356,24 @@ std::ostream& operator<<(std::ostream& stream, const TVector<T>& out) noexcept {
     return stream;
 }
 
-template<typename U>
-void shuffle(TVector<U>& vec) noexcept {
+template<typename U, class G, class A>
+void shuffle(TVector<U, G, A>& vec) noexcept {
+    if (vec._used == vec._front)
+        return;
+
     std::srand(std::time(0));
 
-    for (size_t i = vec._used - 1; i > 0; --i) {
-        size_t j = std::rand() % (i + 1);
+    for (size_t i = vec._used - 1; i > vec._front; --i) {
+        size_t j = vec._front + std::rand() % (i - vec._front + 1);
         vec.swap_elem(i, j);
     }
+
+    vec._states.rebuild();
 }
 
-template<typename U>
-void quick_sort(TVector<U>& vec, size_t low, size_t high, bool(*comp)(U, U))
-noexcept {
+template<typename U, class G, class A>
+void quick_sort(TVector<U, G, A>& vec, size_t low, size_t high,
+    bool(*comp)(U, U)) noexcept {
     if (low < high) {
         size_t pivot_index = partition(vec, low, high, comp);
 
@@ -1008,119 +3387,426 @@ noexcept {
     }
 }
 
-template<typename U>
-size_t partition(TVector<U>& vec, size_t low, size_t high, bool(*comp)(U, U))
-noexcept {
+template<typename U, class G, class A>
+size_t partition(TVector<U, G, A>& vec, size_t low, size_t high,
+    bool(*comp)(U, U)) noexcept {
     size_t pivot_index = low + (high - low) / 2;
     U pivot = vec._data[pivot_index];
     vec.swap_elem(pivot_index, high);
 
     size_t i = low - 1;
 
-    for (size_t j = low; j < high; j++) {
-        if (comp(vec._data[j], pivot)) {
-            i++;
-            vec.swap_elem(i, j);
+    for (size_t j = low; j < high; j++) {
+        if (comp(vec._data[j], pivot)) {
+            i++;
+            vec.swap_elem(i, j);
+        }
+    }
+
+    vec.swap_elem(i + 1, high);
+
+    return i + 1;
+}
+
+// Stable ascending LSD radix sort by the arithmetic key(element), for
+// records sorted by one numeric field. The scratch buffer comes from the
+// vector's allocator. If key throws, the elements are left in their order.
+template<typename U, class G, class A, class Key>
+void tv_radix_sort(TVector<U, G, A>& vec, Key key) {
+    TDenseView<U> view = vec.dense_view();
+
+    if (view.size() < 2)
+        return;
+
+    A allocator = vec.get_allocator();
+    U* buffer = std::allocator_traits<A>::allocate(allocator, view.size());
+
+    try {
+        tv_lsd_radix_sort(view.begin(), view.end(), buffer, key);
+    } catch (...) {
+        std::allocator_traits<A>::deallocate(allocator, buffer, view.size());
+        throw;
+    }
+
+    std::allocator_traits<A>::deallocate(allocator, buffer, view.size());
+}
+
+template<typename U, class G, class A>
+void tv_radix_sort(TVector<U, G, A>& vec) {
+    tv_radix_sort(vec, TRadixIdentity());
+}
+
+template<typename U, class G, class A, class Compare>
+void tv_sort_dense(TVector<U, G, A>& vec, Compare comp, std::true_type) {
+    if (vec.size() >= tv_radix_sort_threshold) {
+        tv_radix_sort(vec);
+        return;
+    }
+
+    TDenseView<U> view = vec.dense_view();
+    tv_pdqsort(view.begin(), view.end(), comp);
+}
+
+template<typename U, class G, class A, class Compare>
+void tv_sort_dense(TVector<U, G, A>& vec, Compare comp, std::false_type) {
+    TDenseView<U> view = vec.dense_view();
+    tv_pdqsort(view.begin(), view.end(), comp);
+}
+
+// Sorts the elements with pattern-defeating quicksort. Tombstones are
+// compacted away first, so only busy elements are compared and moved.
+// Arithmetic elements in default ascending order take the radix sort.
+template<typename U, class G, class A, class Compare>
+void tv_sort(TVector<U, G, A>& vec, Compare comp) {
+    tv_sort_dense(vec, comp, TRadixSortable<U, Compare>());
+}
+
+template<typename U, class G, class A>
+void tv_sort(TVector<U, G, A>& vec) {
+    tv_sort(vec, std::less<U>());
+}
+
+// Pool of one worker per hardware thread besides the caller, shared by
+// the sorts and reductions called without a pool. Started by the first
+// call that needs it and joined at exit.
+inline TThreadPool& tv_default_pool() {
+    static TThreadPool pool(std::thread::hardware_concurrency() - 1);
+    return pool;
+}
+
+// Sorts like tv_sort on a work-stealing pool. comp is shared by every
+// thread and must be safe to call concurrently; the order of equal
+// elements may differ from tv_sort.
+template<typename U, class G, class A, class Compare>
+void tv_parallel_sort(TVector<U, G, A>& vec, Compare comp,
+    TThreadPool& pool) {
+    if (vec.size() < 2 * static_cast<size_t>(tv_parallel_sort_grain)) {
+        tv_sort(vec, comp);
+        return;
+    }
+
+    TDenseView<U> view = vec.dense_view();
+    tv_parallel_pdqsort(view.begin(), view.end(), comp, pool);
+}
+
+// threads counts the calling thread. 0 means one per hardware thread and
+// uses tv_default_pool(); other counts start a pool for this call.
+template<typename U, class G, class A, class Compare>
+void tv_parallel_sort(TVector<U, G, A>& vec, Compare comp,
+    size_t threads) {
+    bool shared = threads == 0;
+
+    if (shared)
+        threads = std::thread::hardware_concurrency();
+
+    if (threads <= 1 ||
+        vec.size() < 2 * static_cast<size_t>(tv_parallel_sort_grain)) {
+        tv_sort(vec, comp);
+        return;
+    }
+
+    if (shared) {
+        tv_parallel_sort(vec, comp, tv_default_pool());
+        return;
+    }
+
+    TThreadPool pool(threads - 1);
+    tv_parallel_sort(vec, comp, pool);
+}
+
+template<typename U, class G, class A, class Compare>
+void tv_parallel_sort(TVector<U, G, A>& vec, Compare comp) {
+    tv_parallel_sort(vec, comp, static_cast<size_t>(0));
+}
+
+// Stable sort: equal elements keep their order. Merge sort with a
+// buffer of size() / 2 elements from the vector's allocator.
+template<typename U, class G, class A, class Compare>
+void tv_stable_sort(TVector<U, G, A>& vec, Compare comp) {
+    TDenseView<U> view = vec.dense_view();
+    size_t buffer_size = view.size() / 2;
+
+    if (buffer_size == 0)
+        return;
+
+    A allocator = vec.get_allocator();
+    U* buffer = std::allocator_traits<A>::allocate(allocator, buffer_size);
+
+    try {
+        tv_merge_sort(view.begin(), view.end(), buffer, comp);
+    } catch (...) {
+        std::allocator_traits<A>::deallocate(allocator, buffer, buffer_size);
+        throw;
+    }
+
+    std::allocator_traits<A>::deallocate(allocator, buffer, buffer_size);
+}
+
+template<typename U, class G, class A>
+void tv_stable_sort(TVector<U, G, A>& vec) {
+    tv_stable_sort(vec, std::less<U>());
+}
+
+// Puts the element a full sort would put at index nth there, with no
+// greater element before it and no smaller one after it. O(n) expected.
+template<typename U, class G, class A, class Compare>
+void tv_nth_element(TVector<U, G, A>& vec, size_t nth, Compare comp) {
+    if (nth >= vec.size())
+        throw std::out_of_range("tv_nth_element: Index out of range.");
+
+    TDenseView<U> view = vec.dense_view();
+    tv_select(view.begin(), view.begin() + nth, view.end(), comp);
+}
+
+template<typename U, class G, class A>
+void tv_nth_element(TVector<U, G, A>& vec, size_t nth) {
+    tv_nth_element(vec, nth, std::less<U>());
+}
+
+// Sorts the first count elements of the full order into [0, count), the
+// rest stay unordered: selection plus a sort of the head, O(n + k log k).
+template<typename U, class G, class A, class Compare>
+void tv_partial_sort(TVector<U, G, A>& vec, size_t count, Compare comp) {
+    TDenseView<U> view = vec.dense_view();
+    U* middle = view.begin() + (count < view.size() ? count : view.size());
+
+    if (middle != view.end())
+        tv_select(view.begin(), middle, view.end(), comp);
+
+    tv_pdqsort(view.begin(), middle, comp);
+}
+
+template<typename U, class G, class A>
+void tv_partial_sort(TVector<U, G, A>& vec, size_t count) {
+    tv_partial_sort(vec, count, std::less<U>());
+}
+
+// Returns copies of the first k elements in comp order, sorted; pass
+// std::greater for the k largest. One scan over the busy slots with a
+// heap of k elements, the vector itself is neither compacted nor changed.
+template<typename U, class G, class A, class Compare>
+TVector<U, G, A> tv_top_k(const TVector<U, G, A>& vec, size_t k,
+    Compare comp) {
+    TVector<U, G, A> result(vec.get_allocator());
+    k = k < vec.size() ? k : vec.size();
+
+    if (k == 0)
+        return result;
+
+    auto it = vec.begin();
+
+    for (size_t i = 0; i < k; i++, ++it) {
+        result.push_back(*it);
+    }
+
+    TDenseView<U> heap = result.dense_view();
+    std::make_heap(heap.begin(), heap.end(), comp);
+
+    for (; it != vec.end(); ++it) {
+        if (comp(*it, heap[0])) {
+            std::pop_heap(heap.begin(), heap.end(), comp);
+            heap[k - 1] = *it;
+            std::push_heap(heap.begin(), heap.end(), comp);
         }
     }
 
-    vec.swap_elem(i + 1, high);
+    std::sort_heap(heap.begin(), heap.end(), comp);
 
-    return i + 1;
+    return result;
 }
 
-template<typename U>
-inline void tv_sort(TVector<U>& vec, bool(*comp)(U, U)) noexcept {
-    quick_sort(vec, 0, vec._used - 1, comp);
+template<typename U, class G, class A>
+TVector<U, G, A> tv_top_k(const TVector<U, G, A>& vec, size_t k) {
+    return tv_top_k(vec, k, std::less<U>());
 }
 
-template<typename U>
-int* search_all(TVector<U>& vec, bool(*check)(U)) noexcept {
-    int* search_result = new int[vec.size()];
-    int deleted_count = 0;
-    int index = 0;
-
-    for (int i = 0; i < vec._used; i++) {
-        if (vec._states[i] == Busy) {
-            if (check(vec._data[i])) {
-                search_result[index] = i - deleted_count;
-                index++;
-            }
-        } else {
-            deleted_count++;
+// Logical index of the first element that matches check, TStateMap::npos
+// if none does. The busy words are scanned 64 slots at a time: empty
+// words are skipped and busy slots are counted with popcount.
+template<typename U, class G, class A, class Predicate>
+size_t tv_find_first(const TVector<U, G, A>& vec, const Predicate& check) {
+    const U* data = vec.data();
+    const uint64_t* busy = vec.states().busy_words();
+    size_t used = vec.used();
+    size_t logical = 0;
+
+    for (size_t base = 0; base < used; base += 64) {
+        uint64_t word = busy[base / 64];
+
+        if (word == 0)
+            continue;
+
+        size_t count = used - base < 64 ? used - base : 64;
+        uint64_t matches = tv_match_busy(data + base, count, word, check);
+
+        if (matches != 0) {
+            uint64_t before = (matches & (~matches + 1)) - 1;
+            return logical + tv_popcount(word & before);
         }
+
+        logical += tv_popcount(word);
     }
 
-    for (int i = index; i < vec.size(); i++) {
-        search_result[i] = -1;
+    return TStateMap::npos;
+}
+
+// Logical index of the last element that matches check, TStateMap::npos
+// if none does.
+template<typename U, class G, class A, class Predicate>
+size_t tv_find_last(const TVector<U, G, A>& vec, const Predicate& check) {
+    const U* data = vec.data();
+    const uint64_t* busy = vec.states().busy_words();
+    size_t used = vec.used();
+    size_t after = 0;
+
+    for (size_t block = (used + 63) / 64; block-- > 0;) {
+        uint64_t word = busy[block];
+
+        if (word == 0)
+            continue;
+
+        size_t base = block * 64;
+        size_t count = used - base < 64 ? used - base : 64;
+        uint64_t matches = tv_match_busy(data + base, count, word, check);
+
+        if (matches != 0) {
+            unsigned last = tv_msb(matches);
+            after += tv_popcount(word >> last >> 1);
+            return vec.size() - 1 - after;
+        }
+
+        after += tv_popcount(word);
     }
 
-    return search_result;
+    return TStateMap::npos;
 }
 
-template<typename U>
-int search_begin(TVector<U>& vec, bool(*check)(U)) noexcept {
-    int deleted_count = 0;
-
-    for (int i = 0; i < vec._used; i++) {
-        if (vec._states[i] == Busy) {
-            if (check(vec._data[i]))
-                return i - deleted_count;
-        } else {
-            deleted_count++;
+// Calls visit(logical_index) for every element that matches check, in
+// order.
+template<typename U, class G, class A, class Predicate, class Visitor>
+void tv_for_each_match(const TVector<U, G, A>& vec, const Predicate& check,
+    Visitor&& visit) {
+    const U* data = vec.data();
+    const uint64_t* busy = vec.states().busy_words();
+    size_t used = vec.used();
+    size_t logical = 0;
+
+    for (size_t base = 0; base < used; base += 64) {
+        uint64_t word = busy[base / 64];
+
+        if (word == 0)
+            continue;
+
+        size_t count = used - base < 64 ? used - base : 64;
+        uint64_t matches = tv_match_busy(data + base, count, word, check);
+
+        while (matches != 0) {
+            unsigned bit = tv_ctz(matches);
+            matches &= matches - 1;
+            visit(logical + tv_popcount(word & ((uint64_t(1) << bit) - 1)));
         }
+
+        logical += tv_popcount(word);
     }
+}
+
+// Logical indices of every element that matches check, in order. The
+// result holds exactly the matches: it grows geometrically while the
+// indices are collected and is trimmed in place once at the end.
+template<typename U, class G, class A, class Predicate>
+TVector<size_t, TGrowth2x> search_all(const TVector<U, G, A>& vec,
+    const Predicate& check) {
+    TVector<size_t, TGrowth2x> matches;
+
+    tv_for_each_match(vec, check, [&](size_t logical_index) {
+        matches.push_back(logical_index);
+    });
 
-    return -1;
+    if (matches.capacity() != matches.size())
+        matches.shrink_to_fit();
+
+    return matches;
 }
 
-template<typename U>
-int search_end(TVector<U>& vec, bool(*check)(U)) noexcept {
-    int deleted_count = 0;
+// Streaming form of search_all: visit(logical_index) is called for every
+// match, nothing is allocated.
+template<typename U, class G, class A, class Predicate, class Visitor>
+void search_each(const TVector<U, G, A>& vec, const Predicate& check,
+    Visitor&& visit) {
+    tv_for_each_match(vec, check, std::forward<Visitor>(visit));
+}
 
-    for (int i = vec._used - 1; i > 0; i--) {
-        if (vec._states[i] == Busy) {
-            if (check(vec._data[i]))
-                return i - (vec._deleted - deleted_count);
-        }
+// Number of elements that match check, counted from the match words.
+template<typename U, class G, class A, class Predicate>
+size_t search_count(const TVector<U, G, A>& vec, const Predicate& check) {
+    const U* data = vec.data();
+    const uint64_t* busy = vec.states().busy_words();
+    size_t used = vec.used();
+    size_t count = 0;
+
+    for (size_t base = 0; base < used; base += 64) {
+        uint64_t word = busy[base / 64];
+
+        if (word == 0)
+            continue;
+
+        size_t length = used - base < 64 ? used - base : 64;
+        count += tv_popcount(tv_match_busy(data + base, length, word, check));
     }
 
-    return -1;
+    return count;
+}
+
+// Logical index of the first (search_begin) or last (search_end) element
+// that matches check, TStateMap::npos if none does.
+template<typename U, class G, class A, class Predicate>
+size_t search_begin(TVector<U, G, A>& vec, const Predicate& check) {
+    return tv_find_first(vec, check);
+}
+
+template<typename U, class G, class A, class Predicate>
+size_t search_end(TVector<U, G, A>& vec, const Predicate& check) {
+    return tv_find_last(vec, check);
 }
+
 #pragma endregion TVectorRealization
 
 #pragma region IteratorsRealization
-template<typename T>
-TVector<T>::Iterator::Iterator(T* ptr, TVector<T>& parent) noexcept
-    : _ptr(ptr), _parent(parent) {}
+template<typename T, class G, class A>
+TVector<T, G, A>::Iterator::Iterator(T* ptr, TVector<T, G, A>& parent) noexcept
+    : _ptr(ptr), _parent(&parent) {}
 
-template<typename T>
-TVector<T>::Iterator::Iterator(const Iterator& other) noexcept
+template<typename T, class G, class A>
+TVector<T, G, A>::Iterator::Iterator(const Iterator& other) noexcept
     : _ptr(other._ptr), _parent(other._parent) {}
 
-template <typename T>
-inline typename TVector<T>::Iterator::reference
-TVector<T>::Iterator::operator*() {
+template <typename T, class G, class A>
+inline typename TVector<T, G, A>::Iterator::reference
+TVector<T, G, A>::Iterator::operator*() {
     if (_ptr == nullptr) {
         throw std::out_of_range("Iterator operator*: Nullptr.");
     }
 
-    if (_ptr < _parent._data || _ptr >= _parent._data + _parent._used) {
+    if (_ptr < _parent->_data || _ptr >= _parent->_data + _parent->_used) {
         throw std::out_of_range("Iterator operator*: Index out of range.");
     }
 
+    _parent->unfreeze(static_cast<size_type>(_ptr - _parent->_data));
     return *_ptr;
 }
 
-template<typename T>
-inline typename TVector<T>::Iterator::pointer
-TVector<T>::Iterator::operator->() noexcept {
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::Iterator::pointer
+TVector<T, G, A>::Iterator::operator->() noexcept {
+    if (_ptr != nullptr)
+        _parent->unfreeze(static_cast<size_type>(_ptr - _parent->_data));
+
     return _ptr;
 }
 
-template<typename T>
-inline typename TVector<T>::Iterator&
-TVector<T>::Iterator::operator=(const Iterator& other) noexcept {
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::Iterator&
+TVector<T, G, A>::Iterator::operator=(const Iterator& other) noexcept {
     if (this != &other) {
         _ptr = other._ptr;
         _parent = other._parent;
@@ -1129,22 +3815,30 @@ TVector<T>::Iterator::operator=(const Iterator& other) noexcept {
     return *this;
 }
 
-template<typename T>
-typename TVector<T>::Iterator& TVector<T>::Iterator::operator++() noexcept {
-    ptrdiff_t current_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator& TVector<T, G, A>::Iterator::operator++()
+noexcept {
+    if (_parent->_deleted == 0) {
+        if (_ptr < _parent->_data + _parent->_used)
+            ++_ptr;
 
-    for (ptrdiff_t i = current_index + 1; i <= _parent._used; i++) {
-        if (_parent._states[i] != Deleted) {
-            _ptr = &_parent._data[i];
-            break;
-        }
+        return *this;
     }
 
+    size_type next = _parent->_states.next_busy(index() + 1, _parent->_used);
+    size_type end = _parent->end_index();
+
+    if (next < _parent->_used)
+        _ptr = _parent->_data + next;
+    else if (static_cast<size_type>(index()) < end)
+        _ptr = _parent->_data + end;
+
     return *this;
 }
 
-template<typename T>
-inline typename TVector<T>::Iterator TVector<T>::Iterator::operator++(int)
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::Iterator
+TVector<T, G, A>::Iterator::operator++(int)
 noexcept {
     Iterator temp = *this;
     ++(*this);
@@ -1152,444 +3846,916 @@ noexcept {
     return temp;
 }
 
-template<typename T>
-typename TVector<T>::Iterator& TVector<T>::Iterator::operator--() noexcept {
-    ptrdiff_t current_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator& TVector<T, G, A>::Iterator::operator--()
+noexcept {
+    if (_parent->_deleted == 0) {
+        if (_ptr > _parent->_data + _parent->_front)
+            --_ptr;
 
-    for (ptrdiff_t i = current_index - 1; i >= 0; i--) {
-        if (_parent._states[i] != Deleted) {
-            _ptr = &_parent._data[i];
-            break;
-        }
+        return *this;
     }
 
+    size_type prev = _parent->_states.prev_busy(index());
+
+    if (prev != state_map::npos)
+        _ptr = _parent->_data + prev;
+
     return *this;
 }
 
-template<typename T>
-inline typename TVector<T>::Iterator TVector<T>::Iterator::operator--(int)
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::Iterator
+TVector<T, G, A>::Iterator::operator--(int)
 noexcept {
     Iterator temp = *this;
     --(*this);
     return temp;
 }
 
-template<typename T>
-typename TVector<T>::Iterator TVector<T>::Iterator::operator+(int num) const {
-    int new_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator
+TVector<T, G, A>::Iterator::operator+(int num)
+const {
+    int new_index = _ptr - _parent->_data;
 
-    if (new_index + num > _parent._used || new_index + num < 0) {
+    if (new_index + num > _parent->_used || new_index + num <
+        static_cast<int>(_parent->_front)) {
         throw std::out_of_range("Iterator operator+: Index out of range.");
     }
 
-    while (new_index < _parent._used && num > 0) {
-        new_index++;
+    size_type target = _parent->_deleted == 0 ? new_index + num :
+        _parent->offset_index(new_index, num);
 
-        if (_parent._states[new_index] != Deleted) {
-            num--;
-        }
+    if (target == state_map::npos) {
+        throw std::out_of_range("Iterator operator+: Index out of range.");
     }
 
-    return Iterator(&_parent._data[new_index], _parent);
+    return Iterator(&_parent->_data[target], *_parent);
 }
 
-template<typename T>
-typename TVector<T>::Iterator TVector<T>::Iterator::operator-(int num) const {
-    int new_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator
+TVector<T, G, A>::Iterator::operator-(int num)
+const {
+    int new_index = _ptr - _parent->_data;
 
-    if (new_index - num > _parent._used || new_index - num < 0) {
+    if (new_index - num > _parent->_used || new_index - num <
+        static_cast<int>(_parent->_front)) {
         throw std::out_of_range("Iterator operator-: Index out of range.");
     }
 
-    while (new_index > 0 && num > 0) {
-        new_index--;
+    size_type target = _parent->_deleted == 0 ? new_index - num :
+        _parent->offset_index(new_index, -num);
 
-        if (_parent._states[new_index] != Deleted) {
-            num--;
-        }
+    if (target == state_map::npos) {
+        throw std::out_of_range("Iterator operator-: Index out of range.");
     }
 
-    return Iterator(&_parent._data[new_index], _parent);
+    return Iterator(&_parent->_data[target], *_parent);
 }
 
-template<typename T>
-typename TVector<T>::Iterator& TVector<T>::Iterator::operator+=(int num) {
-    int new_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator&
+TVector<T, G, A>::Iterator::operator+=(int num) {
+    int new_index = _ptr - _parent->_data;
 
-    if (new_index + num > _parent._used || new_index + num < 0) {
+    if (new_index + num > _parent->_used || new_index + num <
+        static_cast<int>(_parent->_front)) {
         throw std::out_of_range("Iterator operator+: Index out of range.");
     }
 
-    while (new_index < _parent._used && num > 0) {
-        new_index++;
+    size_type target = _parent->_deleted == 0 ? new_index + num :
+        _parent->offset_index(new_index, num);
 
-        if (_parent._states[new_index] != Deleted) {
-            num--;
-        }
+    if (target == state_map::npos) {
+        throw std::out_of_range("Iterator operator+: Index out of range.");
     }
 
-    _ptr = &_parent._data[new_index];
+    _ptr = &_parent->_data[target];
 
     return *this;
 }
 
-template<typename T>
-typename TVector<T>::Iterator& TVector<T>::Iterator::operator-=(int num) {
-    int new_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator&
+TVector<T, G, A>::Iterator::operator-=(int num) {
+    int new_index = _ptr - _parent->_data;
 
-    if (new_index - num > _parent._used || new_index - num < 0) {
+    if (new_index - num > _parent->_used || new_index - num <
+        static_cast<int>(_parent->_front)) {
         throw std::out_of_range("Iterator operator-: Index out of range.");
     }
 
-    while (new_index >= 0 && num > 0) {
-        new_index--;
+    size_type target = _parent->_deleted == 0 ? new_index - num :
+        _parent->offset_index(new_index, -num);
 
-        if (_parent._states[new_index] != Deleted) {
-            num--;
-        }
+    if (target == state_map::npos) {
+        throw std::out_of_range("Iterator operator-: Index out of range.");
     }
 
-    _ptr = &_parent._data[new_index];
+    _ptr = &_parent->_data[target];
 
     return *this;
 }
 
-template<typename T>
-inline bool TVector<T>::Iterator::operator!=(const Iterator& other)
+template<typename T, class G, class A>
+inline bool TVector<T, G, A>::Iterator::operator!=(const Iterator& other)
 const noexcept {
     return _ptr != other._ptr || _parent != other._parent;
 }
 
-template<typename T>
-inline bool TVector<T>::Iterator::operator==(const Iterator& other)
+template<typename T, class G, class A>
+inline bool TVector<T, G, A>::Iterator::operator==(const Iterator& other)
 const noexcept {
     return _ptr == other._ptr && _parent == other._parent;
 }
 
-template<typename T>
-typename TVector<T>::Iterator::difference_type
-TVector<T>::Iterator::operator-(const Iterator& other) const {
-    if (&_parent != &other._parent)
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator::difference_type
+TVector<T, G, A>::Iterator::operator-(const Iterator& other) const {
+    if (_parent != other._parent)
         throw std::runtime_error("Iterator operator-: Different parents");
 
-    int reverse = _ptr < other._ptr ? -1 : 1;
-    Iterator left = _ptr < other._ptr ? *this : other;
-    Iterator right = _ptr > other._ptr ? *this : other;
-
-    ptrdiff_t distance = 0;
-    T* current = left._ptr;
-
-    while (current != right._ptr) {
-        if (_parent._states[current - _parent._data] != Deleted) {
-            distance++;
-        }
+    if (_parent->_deleted == 0)
+        return _ptr - other._ptr;
 
-        current++;
-    }
+    size_type used = _parent->_used;
+    size_type left = static_cast<size_type>(other.index());
+    size_type right = static_cast<size_type>(index());
 
-    return distance * reverse;
+    return static_cast<difference_type>(
+        _parent->_states.rank(right < used ? right : used)) -
+        static_cast<difference_type>(
+        _parent->_states.rank(left < used ? left : used));
 }
 
-template<typename T>
-inline typename TVector<T>::Iterator::difference_type
-TVector<T>::Iterator::index() const noexcept {
-    return _ptr - _parent._data;
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::Iterator::difference_type
+TVector<T, G, A>::Iterator::index() const noexcept {
+    return _ptr - _parent->_data;
 }
 
-template<typename T>
-bool TVector<T>::Iterator::operator<(const Iterator& other) const noexcept {
+template<typename T, class G, class A>
+bool TVector<T, G, A>::Iterator::operator<(const Iterator& other) const
+noexcept {
     return _ptr < other._ptr;
 }
 
-template<typename T>
-bool TVector<T>::Iterator::operator>(const Iterator& other) const noexcept {
+template<typename T, class G, class A>
+bool TVector<T, G, A>::Iterator::operator>(const Iterator& other) const
+noexcept {
     return _ptr > other._ptr;
 }
 
-template<typename T>
-bool TVector<T>::Iterator::operator<=(const Iterator& other) const noexcept {
+template<typename T, class G, class A>
+bool TVector<T, G, A>::Iterator::operator<=(const Iterator& other) const
+noexcept {
     return _ptr <= other._ptr;
 }
 
-template<typename T>
-bool TVector<T>::Iterator::operator>=(const Iterator& other) const noexcept {
+template<typename T, class G, class A>
+bool TVector<T, G, A>::Iterator::operator>=(const Iterator& other) const
+noexcept {
     return _ptr >= other._ptr;
 }
 
-template<typename T>
-typename TVector<T>::Iterator::reference
-TVector<T>::Iterator::operator[](difference_type n) {
+template<typename T, class G, class A>
+typename TVector<T, G, A>::Iterator::reference
+TVector<T, G, A>::Iterator::operator[](difference_type n) {
     if (n < 0) {
         throw std::out_of_range("Negative index not allowed");
     }
 
-    Iterator tmp = *this;
-    difference_type count = 0;
+    if (_parent->_deleted == 0) {
+        if (static_cast<size_type>(index() + n) >= _parent->_used)
+            throw std::runtime_error("Element not found");
 
-    while (tmp != _parent.end()) {
-        if (_parent._states[tmp.index()] == Busy) {
-            if (count == n) {
-                return *tmp;
-            }
-            count++;
-        }
-        ++tmp;
+        _parent->unfreeze(static_cast<size_type>(index() + n));
+        return _ptr[n];
+    }
+
+    size_type used = _parent->_used;
+    size_type current = static_cast<size_type>(index());
+    size_type target = _parent->_states.rank(current < used ? current : used) +
+        static_cast<size_type>(n);
+
+    if (target >= _parent->size()) {
+        throw std::runtime_error("Element not found");
     }
 
-    throw std::runtime_error("Element not found");
+    size_type slot = _parent->_states.select(target);
+    _parent->unfreeze(slot);
+    return _parent->_data[slot];
 }
 #pragma endregion
 
 #pragma region ConstIteratorRealisation
 
-template<typename T>
-TVector<T>::ConstIterator::ConstIterator(const T* ptr,
-    const TVector<T>& parent)noexcept
-    : _ptr(ptr), _parent(parent) {}
+template<typename T, class G, class A>
+TVector<T, G, A>::ConstIterator::ConstIterator(const T* ptr,
+    const TVector<T, G, A>& parent)noexcept
+    : _ptr(ptr), _parent(&parent) {}
 
-template<typename T>
-TVector<T>::ConstIterator::ConstIterator(const ConstIterator& other) noexcept
+template<typename T, class G, class A>
+TVector<T, G, A>::ConstIterator::ConstIterator(const ConstIterator& other)
+noexcept
     : _ptr(other._ptr), _parent(other._parent) {}
 
-template <typename T>
-inline typename TVector<T>::ConstIterator::reference
-TVector<T>::ConstIterator::operator*() {
+template <typename T, class G, class A>
+inline typename TVector<T, G, A>::ConstIterator::reference
+TVector<T, G, A>::ConstIterator::operator*() {
     if (_ptr == nullptr) {
         throw std::out_of_range("ConstIterator operator*: Nullptr.");
     }
 
-    if (_ptr < _parent._data || _ptr >= _parent._data + _parent._used) {
+    if (_ptr < _parent->_data || _ptr >= _parent->_data + _parent->_used) {
         throw std::out_of_range("ConstIterator operator*: Index out of range.");
     }
 
     return *_ptr;
 }
 
-template<typename T>
-inline typename TVector<T>::ConstIterator::pointer
-TVector<T>::ConstIterator::operator->() noexcept {
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::ConstIterator::pointer
+TVector<T, G, A>::ConstIterator::operator->() noexcept {
     return _ptr;
 }
 
-template<typename T>
-typename TVector<T>::ConstIterator&
-    TVector<T>::ConstIterator::operator++() noexcept {
-    difference_type current_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::ConstIterator&
+    TVector<T, G, A>::ConstIterator::operator++() noexcept {
+    if (_parent->_deleted == 0) {
+        if (_ptr < _parent->_data + _parent->_used)
+            ++_ptr;
 
-    for (difference_type i = current_index + 1; i <= _parent._used; i++) {
-        if (_parent._states[i] != Deleted) {
-            _ptr = &_parent._data[i];
-            break;
-        }
+        return *this;
     }
 
+    size_type next = _parent->_states.next_busy(index() + 1, _parent->_used);
+    size_type end = _parent->end_index();
+
+    if (next < _parent->_used)
+        _ptr = _parent->_data + next;
+    else if (static_cast<size_type>(index()) < end)
+        _ptr = _parent->_data + end;
+
     return *this;
 }
 
-template<typename T>
-inline typename TVector<T>::ConstIterator
-TVector<T>::ConstIterator::operator++(int) noexcept {
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::ConstIterator
+TVector<T, G, A>::ConstIterator::operator++(int) noexcept {
     ConstIterator temp = *this;
     ++(*this);
 
     return temp;
 }
 
-template<typename T>
-typename TVector<T>::ConstIterator&
-    TVector<T>::ConstIterator::operator--() noexcept {
-    difference_type current_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::ConstIterator&
+    TVector<T, G, A>::ConstIterator::operator--() noexcept {
+    if (_parent->_deleted == 0) {
+        if (_ptr > _parent->_data + _parent->_front)
+            --_ptr;
 
-    for (difference_type i = current_index - 1; i >= 0; i--) {
-        if (_parent._states[i] != Deleted) {
-            _ptr = &_parent._data[i];
-            break;
-        }
+        return *this;
     }
 
+    size_type prev = _parent->_states.prev_busy(index());
+
+    if (prev != state_map::npos)
+        _ptr = _parent->_data + prev;
+
     return *this;
 }
 
-template<typename T>
-inline typename TVector<T>::ConstIterator
-TVector<T>::ConstIterator::operator--(int) noexcept {
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::ConstIterator
+TVector<T, G, A>::ConstIterator::operator--(int) noexcept {
     ConstIterator temp = *this;
     --(*this);
     return temp;
 }
 
-template<typename T>
-typename TVector<T>::ConstIterator
-TVector<T>::ConstIterator::operator+(int num) const {
-    int new_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::ConstIterator
+TVector<T, G, A>::ConstIterator::operator+(int num) const {
+    int new_index = _ptr - _parent->_data;
 
-    if (new_index + num > _parent._used || new_index + num < 0) {
+    if (new_index + num > _parent->_used || new_index + num <
+        static_cast<int>(_parent->_front)) {
         throw std::out_of_range("ConstIterator operator+: Index out of range.");
     }
 
-    while (new_index < _parent._used && num > 0) {
-        new_index++;
+    size_type target = _parent->_deleted == 0 ? new_index + num :
+        _parent->offset_index(new_index, num);
 
-        if (_parent._states[new_index] != Deleted) {
-            num--;
-        }
+    if (target == state_map::npos) {
+        throw std::out_of_range("ConstIterator operator+: Index out of range.");
     }
 
-    return ConstIterator(&_parent._data[new_index], _parent);
+    return ConstIterator(&_parent->_data[target], *_parent);
 }
 
-template<typename T>
-typename TVector<T>::ConstIterator
-TVector<T>::ConstIterator::operator-(int num) const {
-    int new_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::ConstIterator
+TVector<T, G, A>::ConstIterator::operator-(int num) const {
+    int new_index = _ptr - _parent->_data;
 
-    if (new_index - num > _parent._used || new_index - num < 0) {
+    if (new_index - num > _parent->_used || new_index - num <
+        static_cast<int>(_parent->_front)) {
         throw std::out_of_range("ConstIterator operator-: Index out of range.");
     }
 
-    while (new_index > 0 && num > 0) {
-        new_index--;
+    size_type target = _parent->_deleted == 0 ? new_index - num :
+        _parent->offset_index(new_index, -num);
 
-        if (_parent._states[new_index] != Deleted) {
-            num--;
-        }
+    if (target == state_map::npos) {
+        throw std::out_of_range("ConstIterator operator-: Index out of range.");
     }
 
-    return ConstIterator(&_parent._data[new_index], _parent);
+    return ConstIterator(&_parent->_data[target], *_parent);
 }
 
-template<typename T>
-typename TVector<T>::ConstIterator&
-    TVector<T>::ConstIterator::operator+=(int num) {
-    int new_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::ConstIterator&
+    TVector<T, G, A>::ConstIterator::operator+=(int num) {
+    int new_index = _ptr - _parent->_data;
 
-    if (new_index + num > _parent._used || new_index + num < 0) {
+    if (new_index + num > _parent->_used || new_index + num <
+        static_cast<int>(_parent->_front)) {
         throw std::out_of_range("ConstIterator operator+: Index out of range.");
     }
 
-    while (new_index < _parent._used && num > 0) {
-        new_index++;
+    size_type target = _parent->_deleted == 0 ? new_index + num :
+        _parent->offset_index(new_index, num);
 
-        if (_parent._states[new_index] != Deleted) {
-            num--;
-        }
+    if (target == state_map::npos) {
+        throw std::out_of_range("ConstIterator operator+: Index out of range.");
     }
 
-    _ptr = &_parent._data[new_index];
+    _ptr = &_parent->_data[target];
 
     return *this;
 }
 
-template<typename T>
-typename TVector<T>::ConstIterator&
-    TVector<T>::ConstIterator::operator-=(int num) {
-    int new_index = _ptr - _parent._data;
+template<typename T, class G, class A>
+typename TVector<T, G, A>::ConstIterator&
+    TVector<T, G, A>::ConstIterator::operator-=(int num) {
+    int new_index = _ptr - _parent->_data;
 
-    if (new_index - num > _parent._used || new_index - num < 0) {
+    if (new_index - num > _parent->_used || new_index - num <
+        static_cast<int>(_parent->_front)) {
         throw std::out_of_range("ConstIterator operator-: Index out of range.");
     }
 
-    while (new_index >= 0 && num > 0) {
-        new_index--;
+    size_type target = _parent->_deleted == 0 ? new_index - num :
+        _parent->offset_index(new_index, -num);
 
-        if (_parent._states[new_index] != Deleted) {
-            num--;
-        }
+    if (target == state_map::npos) {
+        throw std::out_of_range("ConstIterator operator-: Index out of range.");
     }
 
-    _ptr = &_parent._data[new_index];
+    _ptr = &_parent->_data[target];
 
     return *this;
 }
 
-template<typename T>
-inline bool TVector<T>::ConstIterator::operator!=(const ConstIterator& other)
-const noexcept {
+template<typename T, class G, class A>
+inline bool TVector<T, G, A>::ConstIterator::operator!=(
+    const ConstIterator& other) const noexcept {
     return _ptr != other._ptr || _parent != other._parent;
 }
 
-template<typename T>
-inline bool TVector<T>::ConstIterator::operator==(const ConstIterator& other)
-const noexcept {
+template<typename T, class G, class A>
+inline bool TVector<T, G, A>::ConstIterator::operator==(
+    const ConstIterator& other) const noexcept {
     return _ptr == other._ptr && _parent == other._parent;
 }
 
-template<typename T>
-typename TVector<T>::ConstIterator::difference_type
-TVector<T>::ConstIterator::operator-(const ConstIterator& other) const {
-    if (&_parent != &other._parent)
+template<typename T, class G, class A>
+typename TVector<T, G, A>::ConstIterator::difference_type
+TVector<T, G, A>::ConstIterator::operator-(const ConstIterator& other) const {
+    if (_parent != other._parent)
         throw std::runtime_error("ConstIterator operator-: Different parents");
 
-    int reverse = _ptr < other._ptr ? -1 : 1;
-    ConstIterator left = _ptr < other._ptr ? *this : other;
-    ConstIterator right = _ptr > other._ptr ? *this : other;
-
-    difference_type distance = 0;
-    pointer current = left._ptr;
-
-    while (current != right._ptr) {
-        if (_parent._states[current - _parent._data] != Deleted) {
-            distance++;
-        }
+    if (_parent->_deleted == 0)
+        return _ptr - other._ptr;
 
-        current++;
-    }
+    size_type used = _parent->_used;
+    size_type left = static_cast<size_type>(other.index());
+    size_type right = static_cast<size_type>(index());
 
-    return distance * reverse;
+    return static_cast<difference_type>(
+        _parent->_states.rank(right < used ? right : used)) -
+        static_cast<difference_type>(
+        _parent->_states.rank(left < used ? left : used));
 }
 
-template<typename T>
-inline typename TVector<T>::ConstIterator::difference_type
-TVector<T>::ConstIterator::index() const noexcept {
-    return _ptr - _parent._data;
+template<typename T, class G, class A>
+inline typename TVector<T, G, A>::ConstIterator::difference_type
+TVector<T, G, A>::ConstIterator::index() const noexcept {
+    return _ptr - _parent->_data;
 }
 
-template<typename T>
-bool TVector<T>::ConstIterator::operator<(const ConstIterator& other)
+template<typename T, class G, class A>
+bool TVector<T, G, A>::ConstIterator::operator<(const ConstIterator& other)
 const noexcept {
     return _ptr < other._ptr;
 }
 
-template<typename T>
-bool TVector<T>::ConstIterator::operator>(const ConstIterator& other)
+template<typename T, class G, class A>
+bool TVector<T, G, A>::ConstIterator::operator>(const ConstIterator& other)
 const noexcept {
     return _ptr > other._ptr;
 }
 
-template<typename T>
-bool TVector<T>::ConstIterator::operator<=(const ConstIterator& other)
+template<typename T, class G, class A>
+bool TVector<T, G, A>::ConstIterator::operator<=(const ConstIterator& other)
 const noexcept {
     return _ptr <= other._ptr;
 }
 
-template<typename T>
-bool TVector<T>::ConstIterator::operator>=(const ConstIterator& other)
+template<typename T, class G, class A>
+bool TVector<T, G, A>::ConstIterator::operator>=(const ConstIterator& other)
 const noexcept {
     return _ptr >= other._ptr;
 }
 
-template<typename T>
-typename TVector<T>::ConstIterator::reference
-TVector<T>::ConstIterator::operator[](difference_type n) {
+template<typename T, class G, class A>
+typename TVector<T, G, A>::ConstIterator::reference
+TVector<T, G, A>::ConstIterator::operator[](difference_type n) {
     if (n < 0) {
         throw std::out_of_range("Negative index not allowed");
     }
 
-    ConstIterator tmp = *this;
-    difference_type count = 0;
+    if (_parent->_deleted == 0) {
+        if (static_cast<size_type>(index() + n) >= _parent->_used)
+            throw std::runtime_error("Element not found");
+
+        return _ptr[n];
+    }
+
+    size_type used = _parent->_used;
+    size_type current = static_cast<size_type>(index());
+    size_type target = _parent->_states.rank(current < used ? current : used) +
+        static_cast<size_type>(n);
+
+    if (target >= _parent->size()) {
+        throw std::runtime_error("Element not found");
+    }
+
+    return _parent->_data[_parent->_states.select(target)];
+}
+
+#pragma endregion ConstIteratorRealisation
 
-    while (tmp != _parent.end()) {
-        if (_parent._states[tmp.index()] == Busy) {
-            if (count == n) {
-                return *tmp;
+#pragma region ParallelReductions
+
+// Reductions split the slots [0, used()) into chunks of
+// tv_parallel_reduce_grain slots (a multiple of 64, so a chunk covers
+// whole busy words) and combine the chunk results in chunk order. The
+// chunks depend only on used(), so a result is the same for any number
+// of threads, floating-point sums included.
+constexpr size_t tv_parallel_reduce_grain = 65536;
+
+// Calls visit(slot) for every busy slot in [first, last), first is a
+// multiple of 64. Full words take a plain loop, others are walked bit by
+// bit.
+template<class Visitor>
+void tv_visit_busy(const uint64_t* busy, size_t first, size_t last,
+    Visitor& visit) {
+    for (size_t base = first; base < last; base += 64) {
+        uint64_t word = busy[base / 64];
+
+        if (word == ~uint64_t(0)) {
+            for (size_t slot = base; slot < base + 64; slot++) {
+                visit(slot);
             }
-            count++;
+
+            continue;
+        }
+
+        while (word != 0) {
+            visit(base + tv_ctz(word));
+            word &= word - 1;
+        }
+    }
+}
+
+// Runs chunk(index, first, last) for every chunk of [0, used), on the
+// pool when there is one, in chunk order on the calling thread otherwise.
+template<class Chunk>
+void tv_run_chunks(size_t used, TThreadPool* pool, const Chunk& chunk) {
+    size_t count = (used + tv_parallel_reduce_grain - 1) /
+        tv_parallel_reduce_grain;
+
+    auto run = [&](size_t index) {
+        size_t first = index * tv_parallel_reduce_grain;
+        size_t last = used - first < tv_parallel_reduce_grain ? used :
+            first + tv_parallel_reduce_grain;
+        chunk(index, first, last);
+    };
+
+    if (pool == nullptr || count < 2) {
+        for (size_t index = 0; index < count; index++) {
+            run(index);
+        }
+    } else {
+        TTaskGroup group(*pool);
+
+        for (size_t index = 0; index < count; index++) {
+            group.run([&run, index] { run(index); });
         }
 
-        ++tmp;
+        group.wait();
+    }
+}
+
+// Runs chunk(first, last, partial) for every chunk of [0, used) and folds
+// the partials into init with combine in chunk order. A chunk returns
+// false when it produced no partial.
+template<typename R, class Chunk, class Combine>
+R tv_reduce_chunks(size_t used, TThreadPool* pool, R init,
+    const Chunk& chunk, const Combine& combine) {
+    size_t count = (used + tv_parallel_reduce_grain - 1) /
+        tv_parallel_reduce_grain;
+    std::vector<R> partials(count, init);
+    std::unique_ptr<bool[]> filled(new bool[count]());
+
+    tv_run_chunks(used, pool, [&](size_t index, size_t first, size_t last) {
+        filled[index] = chunk(first, last, partials[index]);
+    });
+
+    for (size_t index = 0; index < count; index++) {
+        if (filled[index])
+            init = combine(init, partials[index]);
     }
 
-    throw std::runtime_error("Element not found");
+    return init;
 }
 
-#pragma endregion ConstIteratorRealisation
+// Calls body(pool) with the default pool, or with nullptr when the vector
+// fits in two chunks or the machine has one thread.
+template<class Body>
+auto tv_with_default_pool(size_t used, const Body& body)
+    -> decltype(body(nullptr)) {
+    if (std::thread::hardware_concurrency() <= 1 ||
+        used < 2 * tv_parallel_reduce_grain)
+        return body(nullptr);
+
+    return body(&tv_default_pool());
+}
+
+// Transform of the plain reductions (tv_reduce, tv_sum): the element
+// itself.
+struct TReduceIdentity {
+    template<typename T>
+    const T& operator()(const T& value) const noexcept {
+        return value;
+    }
+};
+
+template<typename U, class G, class A, class Predicate>
+size_t tv_count_if(const TVector<U, G, A>& vec, const Predicate& check,
+    TThreadPool* pool) {
+    const U* data = vec.data();
+    const uint64_t* busy = vec.states().busy_words();
+    size_t used = vec.used();
+
+    return tv_reduce_chunks(used, pool, static_cast<size_t>(0),
+        [&](size_t first, size_t last, size_t& partial) {
+        for (size_t base = first; base < last; base += 64) {
+            uint64_t word = busy[base / 64];
+
+            if (word != 0) {
+                size_t count = last - base < 64 ? last - base : 64;
+                partial += tv_popcount(
+                    tv_match_busy(data + base, count, word, check));
+            }
+        }
+
+        return true;
+    }, std::plus<size_t>());
+}
+
+// Number of elements that match check. A TSearchPredicate on arithmetic
+// elements is matched by the SIMD kernels.
+template<typename U, class G, class A, class Predicate>
+size_t tv_count_if(const TVector<U, G, A>& vec, const Predicate& check,
+    TThreadPool& pool) {
+    return tv_count_if(vec, check, &pool);
+}
+
+template<typename U, class G, class A, class Predicate>
+size_t tv_count_if(const TVector<U, G, A>& vec, const Predicate& check) {
+    return tv_with_default_pool(vec.used(), [&](TThreadPool* pool) {
+        return tv_count_if(vec, check, pool);
+    });
+}
+
+template<typename U, class G, class A, class Predicate>
+bool tv_any_of(const TVector<U, G, A>& vec, const Predicate& check,
+    TThreadPool* pool) {
+    const U* data = vec.data();
+    const uint64_t* busy = vec.states().busy_words();
+    std::atomic<bool> found(false);
+
+    // Chunks stop at the first word checked after a match was found.
+    tv_run_chunks(vec.used(), pool, [&](size_t, size_t first, size_t last) {
+        for (size_t base = first; base < last; base += 64) {
+            if (found.load(std::memory_order_relaxed))
+                return;
+
+            uint64_t word = busy[base / 64];
+            size_t count = last - base < 64 ? last - base : 64;
+
+            if (word != 0 &&
+                tv_match_busy(data + base, count, word, check) != 0) {
+                found.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+    });
+
+    return found.load();
+}
+
+template<typename U, class G, class A, class Predicate>
+bool tv_any_of(const TVector<U, G, A>& vec, const Predicate& check,
+    TThreadPool& pool) {
+    return tv_any_of(vec, check, &pool);
+}
+
+template<typename U, class G, class A, class Predicate>
+bool tv_any_of(const TVector<U, G, A>& vec, const Predicate& check) {
+    return tv_with_default_pool(vec.used(), [&](TThreadPool* pool) {
+        return tv_any_of(vec, check, pool);
+    });
+}
+
+// Slot of the first element no other element is less than by comp,
+// TStateMap::npos for an empty vector.
+template<typename U, class G, class A, class Compare>
+size_t tv_min_slot(const TVector<U, G, A>& vec, const Compare& comp,
+    TThreadPool* pool) {
+    const U* data = vec.data();
+    const uint64_t* busy = vec.states().busy_words();
+
+    return tv_reduce_chunks(vec.used(), pool, TStateMap::npos,
+        [&](size_t first, size_t last, size_t& best) {
+        best = TStateMap::npos;
+        auto visit = [&](size_t slot) {
+            if (best == TStateMap::npos || comp(data[slot], data[best]))
+                best = slot;
+        };
+
+        tv_visit_busy(busy, first, last, visit);
+        return best != TStateMap::npos;
+    }, [&](size_t best, size_t slot) {
+        return best == TStateMap::npos || comp(data[slot], data[best]) ?
+            slot : best;
+    });
+}
+
+// comp with its arguments swapped: the minimum by it is the first
+// maximum by comp, as with std::max_element.
+template<class Compare>
+struct TReversedCompare {
+    const Compare& comp;
+
+    template<typename T>
+    bool operator()(const T& left, const T& right) const {
+        return comp(right, left);
+    }
+};
+
+template<typename U, class G, class A, class Compare>
+U tv_min(const TVector<U, G, A>& vec, Compare comp, TThreadPool* pool) {
+    if (vec.is_empty())
+        throw std::out_of_range("tv_min: Vector is empty.");
+
+    return vec.data()[tv_min_slot(vec, comp, pool)];
+}
+
+template<typename U, class G, class A, class Compare>
+U tv_max(const TVector<U, G, A>& vec, Compare comp, TThreadPool* pool) {
+    if (vec.is_empty())
+        throw std::out_of_range("tv_max: Vector is empty.");
+
+    return vec.data()[tv_min_slot(vec, TReversedCompare<Compare>{comp},
+        pool)];
+}
+
+// Smallest and largest element by comp (std::less by default). Throw
+// std::out_of_range on an empty vector.
+template<typename U, class G, class A, class Compare>
+U tv_min(const TVector<U, G, A>& vec, Compare comp, TThreadPool& pool) {
+    return tv_min(vec, comp, &pool);
+}
+
+template<typename U, class G, class A, class Compare>
+U tv_min(const TVector<U, G, A>& vec, Compare comp) {
+    return tv_with_default_pool(vec.used(), [&](TThreadPool* pool) {
+        return tv_min(vec, comp, pool);
+    });
+}
+
+template<typename U, class G, class A>
+U tv_min(const TVector<U, G, A>& vec, TThreadPool& pool) {
+    return tv_min(vec, std::less<U>(), &pool);
+}
+
+template<typename U, class G, class A>
+U tv_min(const TVector<U, G, A>& vec) {
+    return tv_min(vec, std::less<U>());
+}
+
+template<typename U, class G, class A, class Compare>
+U tv_max(const TVector<U, G, A>& vec, Compare comp, TThreadPool& pool) {
+    return tv_max(vec, comp, &pool);
+}
+
+template<typename U, class G, class A, class Compare>
+U tv_max(const TVector<U, G, A>& vec, Compare comp) {
+    return tv_with_default_pool(vec.used(), [&](TThreadPool* pool) {
+        return tv_max(vec, comp, pool);
+    });
+}
+
+template<typename U, class G, class A>
+U tv_max(const TVector<U, G, A>& vec, TThreadPool& pool) {
+    return tv_max(vec, std::less<U>(), &pool);
+}
+
+template<typename U, class G, class A>
+U tv_max(const TVector<U, G, A>& vec) {
+    return tv_max(vec, std::less<U>());
+}
+
+template<typename U, class G, class A, typename T, class Reduce,
+    class Transform>
+T tv_transform_reduce(const TVector<U, G, A>& vec, T init,
+    const Reduce& reduce, const Transform& transform, TThreadPool* pool) {
+    const U* data = vec.data();
+    const uint64_t* busy = vec.states().busy_words();
+
+    return tv_reduce_chunks(vec.used(), pool, std::move(init),
+        [&](size_t first, size_t last, T& partial) {
+        size_t base = first;
+
+        while (base < last && busy[base / 64] == 0) {
+            base += 64;
+        }
+
+        if (base >= last)
+            return false;
+
+        // Seeded once from the first element, the rest of its word and
+        // the following words are folded without a branch per element.
+        uint64_t word = busy[base / 64];
+        T local = transform(data[base + tv_ctz(word)]);
+        auto visit = [&](size_t slot) {
+            local = reduce(std::move(local), transform(data[slot]));
+        };
+
+        for (word &= word - 1; word != 0; word &= word - 1) {
+            visit(base + tv_ctz(word));
+        }
+
+        tv_visit_busy(busy, base + 64, last, visit);
+        partial = std::move(local);
+        return true;
+    }, reduce);
+}
+
+// reduce(init, transform(x)...) over the elements. Each chunk is folded
+// left to right starting from its first element, the chunk results are
+// then folded into init in order, so reduce must be associative.
+template<typename U, class G, class A, typename T, class Reduce,
+    class Transform>
+T tv_transform_reduce(const TVector<U, G, A>& vec, T init,
+    Reduce reduce, Transform transform, TThreadPool& pool) {
+    return tv_transform_reduce(vec, std::move(init), reduce, transform,
+        &pool);
+}
+
+template<typename U, class G, class A, typename T, class Reduce,
+    class Transform>
+T tv_transform_reduce(const TVector<U, G, A>& vec, T init,
+    Reduce reduce, Transform transform) {
+    return tv_with_default_pool(vec.used(), [&](TThreadPool* pool) {
+        return tv_transform_reduce(vec, init, reduce, transform, pool);
+    });
+}
+
+template<typename U, class G, class A, typename T, class Reduce>
+T tv_reduce(const TVector<U, G, A>& vec, T init, Reduce reduce,
+    TThreadPool& pool) {
+    return tv_transform_reduce(vec, std::move(init), reduce,
+        TReduceIdentity(), &pool);
+}
+
+template<typename U, class G, class A, typename T, class Reduce>
+T tv_reduce(const TVector<U, G, A>& vec, T init, Reduce reduce) {
+    return tv_transform_reduce(vec, std::move(init), reduce,
+        TReduceIdentity());
+}
+
+// Summation order of tv_sum:
+//  Chunked      - chunk sums added in chunk order, parallel and the same
+//                 for any number of threads;
+//  Sequential   - one left to right pass on the calling thread, equal to
+//                 a plain loop;
+//  Compensated  - Chunked with Neumaier compensation inside the chunks and
+//                 between them, for floating-point elements.
+enum class TSumMode { Chunked, Sequential, Compensated };
+
+template<typename U>
+struct TCompensatedSum {
+    U sum;
+    U compensation;
+
+    TCompensatedSum operator+(const U& value) const {
+        U total = sum + value;
+        U lost = (sum < 0 ? -sum : sum) >= (value < 0 ? -value : value) ?
+            (sum - total) + value : (value - total) + sum;
+
+        return TCompensatedSum{ total, compensation + lost };
+    }
+
+    TCompensatedSum operator+(const TCompensatedSum& other) const {
+        TCompensatedSum result = *this + other.sum;
+        result.compensation += other.compensation;
+        return result;
+    }
+};
+
+template<typename U, class G, class A>
+U tv_sum_compensated(const TVector<U, G, A>& vec, TThreadPool* pool,
+    std::true_type) {
+    TCompensatedSum<U> total = tv_transform_reduce(vec,
+        TCompensatedSum<U>{ U(), U() },
+        [](const TCompensatedSum<U>& left, const TCompensatedSum<U>& right) {
+        return left + right;
+    }, [](const U& value) { return TCompensatedSum<U>{ value, U() }; },
+        pool);
+
+    return total.sum + total.compensation;
+}
+
+template<typename U, class G, class A>
+U tv_sum_compensated(const TVector<U, G, A>& vec, TThreadPool* pool,
+    std::false_type) {
+    return tv_transform_reduce(vec, U(), std::plus<U>(), TReduceIdentity(),
+        pool);
+}
+
+template<typename U, class G, class A>
+U tv_sum(const TVector<U, G, A>& vec, TSumMode mode, TThreadPool* pool) {
+    if (mode == TSumMode::Compensated) {
+        return tv_sum_compensated(vec, pool,
+            std::is_floating_point<U>());
+    }
+
+    if (mode == TSumMode::Chunked) {
+        return tv_transform_reduce(vec, U(), std::plus<U>(),
+            TReduceIdentity(), pool);
+    }
+
+    const U* data = vec.data();
+    U total = U();
+    auto visit = [&](size_t slot) { total = total + data[slot]; };
+
+    tv_visit_busy(vec.states().busy_words(), 0, vec.used(), visit);
+    return total;
+}
+
+// Sum of the elements, Chunked unless another TSumMode is given.
+template<typename U, class G, class A>
+U tv_sum(const TVector<U, G, A>& vec, TSumMode mode, TThreadPool& pool) {
+    return tv_sum(vec, mode, &pool);
+}
+
+template<typename U, class G, class A>
+U tv_sum(const TVector<U, G, A>& vec, TSumMode mode) {
+    if (mode == TSumMode::Sequential)
+        return tv_sum(vec, mode, nullptr);
+
+    return tv_with_default_pool(vec.used(), [&](TThreadPool* pool) {
+        return tv_sum(vec, mode, pool);
+    });
+}
+
+template<typename U, class G, class A>
+U tv_sum(const TVector<U, G, A>& vec, TThreadPool& pool) {
+    return tv_sum(vec, TSumMode::Chunked, &pool);
+}
+
+template<typename U, class G, class A>
+U tv_sum(const TVector<U, G, A>& vec) {
+    return tv_sum(vec, TSumMode::Chunked);
+}
+
+#pragma endregion ParallelReductions
@@ -4,11 +4,20 @@
 #include <iostream>
 #include <stdexcept>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <iterator>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <utility>
 
 #include "TVector.h"
+#include "TAllocators.h"
+#include "TRingBuffer.h"
+#include "TSlotMap.h"
 
 void set_color(int text_color, int bg_color) {
     HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -870,6 +879,24 @@ bool tvector_iterator_assign() {
 
     return TestSystem::check_exp(expected_result, actual_result);
 }
+bool tvector_iterator_assign_across_vectors() {
+    TVector<int> first = { 1, 2, 3 };
+    TVector<int> second = { 7, 8 };
+    TVector<int>::Iterator it = first.begin();
+    const TVector<int>& view = first;
+    TVector<int>::ConstIterator const_it = view.begin();
+
+    it = second.begin();
+    const_it = static_cast<const TVector<int>&>(second).begin();
+
+    return TestSystem::check_exp(static_cast<size_t>(3), first.size()) &&
+        TestSystem::check_exp(1, first[0]) &&
+        TestSystem::check_exp(3, first[2]) &&
+        TestSystem::check_exp(static_cast<size_t>(2), second.size()) &&
+        TestSystem::check_exp(7, *it) &&
+        TestSystem::check_exp(7, *const_it) &&
+        TestSystem::check_exp(true, it + 2 == second.end());
+}
 bool tvector_iterator_left_increment() {
     TVector<int> vec = { 1, 2, 3, 4, 5, 6, 7, 8,
         9, 10, 11, 12, 13, 14, 15, 16 };
@@ -1220,8 +1247,8 @@ bool tvector_search_begin() {
     TVector<int> vec = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
 
     vec.pop_front();
-    int actual_result = search_begin(vec, find_chet);
-    int expected_result = 0;
+    size_t actual_result = search_begin(vec, find_chet);
+    size_t expected_result = 0;
 
     return TestSystem::check_exp(expected_result, actual_result);
 }
@@ -1230,8 +1257,8 @@ bool tvector_search_end() {
 
     vec.pop_front();
     vec.pop_back();
-    int actual_result = search_end(vec, find_chet);
-    int expected_result = 6;
+    size_t actual_result = search_end(vec, find_chet);
+    size_t expected_result = 6;
 
     return TestSystem::check_exp(expected_result, actual_result);
 }
@@ -1244,58 +1271,18 @@ bool tvector_search_all() {
     bool actual_result = true;
     bool expected_result = true;
 
-    int* searched_result = search_all(vec, find_chet);
-    int* need_result = new int[4] {0, 2, 4, 6};
+    TVector<size_t, TGrowth2x> searched_result = search_all(vec, find_chet);
+    size_t need_result[4] = {0, 2, 4, 6};
 
     for (int i = 0; i < 4; i++) {
         if (searched_result[i] != need_result[i])
             actual_result = false;
     }
 
-    return TestSystem::check_exp(expected_result, actual_result);
-}
-
-bool sort_check(uint64_t a, uint64_t b) {
-    return a < b;
+    return TestSystem::check_exp(expected_result, actual_result) &&
+        TestSystem::check_exp(static_cast<size_t>(4), searched_result.size());
 }
 
-bool tvector_sort() {
-    TVector<uint64_t> expected_result(100000000);
-    std::cout << "vectors memory" << std::endl;
-    TVector<uint64_t> actual_result(100000000);
-    uint64_t a = 10;
-
-    for (uint64_t i = 0; i < 100000000; i++) {
-        expected_result[i] = i;
-
-        if (i == a) {
-            std::cout << i << std::endl;
-            a *= 10;
-        }
-    }
-
-    a = 10;
-
-    for (uint64_t i = 0; i < 100000000; i++) {
-        actual_result[100000000 - 1 - i] = i;
-
-        if (i == a) {
-            std::cout << i << std::endl;
-            a *= 10;
-        }
-    }
-    std::cout << "vectors created" << std::endl;
-
-    auto start = std::chrono::high_resolution_clock::now();
-    tv_sort(actual_result, sort_check);
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration =
-        std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-    std::cout << "Sort waste " << duration.count()
-    << " milliseconds." << std::endl;
-
-    return TestSystem::check_exp(expected_result, actual_result);
-}
 #pragma endregion
 
 #pragma region AdditionalTVectorTests
@@ -1806,20 +1793,20 @@ bool search_predicate_all_match(int x) { return x >= 0; }
 
 bool tvector_search_no_matches() {
     TVector<int> vec = {1, 2, 3, 4, 5};
-    int result_begin = search_begin(vec, search_predicate_none_match);
-    int result_end = search_end(vec, search_predicate_none_match);
+    size_t result_begin = search_begin(vec, search_predicate_none_match);
+    size_t result_end = search_end(vec, search_predicate_none_match);
 
-    return TestSystem::check_exp(-1, result_begin) &&
-           TestSystem::check_exp(-1, result_end);
+    return TestSystem::check_exp(TStateMap::npos, result_begin) &&
+           TestSystem::check_exp(TStateMap::npos, result_end);
 }
 
 bool tvector_search_all_match() {
     TVector<int> vec = {1, 2, 3, 4, 5};
-    int result_begin = search_begin(vec, search_predicate_all_match);
-    int result_end = search_end(vec, search_predicate_all_match);
+    size_t result_begin = search_begin(vec, search_predicate_all_match);
+    size_t result_end = search_end(vec, search_predicate_all_match);
 
-    return TestSystem::check_exp(0, result_begin) &&
-           TestSystem::check_exp(4, result_end);
+    return TestSystem::check_exp(static_cast<size_t>(0), result_begin) &&
+           TestSystem::check_exp(static_cast<size_t>(4), result_end);
 }
 
 // Test sorting with edge cases
@@ -2000,190 +1987,3208 @@ bool tvector_const_iterator_after_modification() {
 
 #pragma endregion
 
-int main() {
-    TestSystem::print_init_info();
-    TestSystem::start_test(tvector_default_init, "default_init");
-    TestSystem::start_test(tvector_size_init, "size_init");
-    TestSystem::start_test(tvector_copy_init, "copy_init");
-    TestSystem::start_test(tvector_move_init, "move_init");
-    TestSystem::start_test(tvector_array_init, "array_init");
-    TestSystem::start_test(tvector_initialize_list_init,
-        "initialize_list_init");
+#pragma region GrowthPolicyTests
 
-    TestSystem::start_test(tvector_operator_copy_assign,
-        "operator_copy_assign");
-    TestSystem::start_test(tvector_operator_move_assign,
-        "operator_move_assign");
-    TestSystem::start_test(tvector_operator_equality, "operator_equality");
-    TestSystem::start_test(tvector_operator_inequality, "operator_inequality");
-    TestSystem::start_test(tvector_operator_index_access,
-        "operator_index_access");
-    TestSystem::start_test(tvector_operator_index_access_exception,
-        "operator_index_access_exception");
-    TestSystem::start_test(tvector_const_operator_index_access,
-        "const_operator_index_access");
-    TestSystem::start_test(tvector_const_operator_index_access_exception,
-        "const_operator_index_access_exception");
+bool tvector_linear_growth_step() {
+    TVector<int, TLinearGrowth<10>> vec(25);
+    vec.push_back(1);
+    vec.push_back(2);
+    vec.push_back(3);
+    vec.push_back(4);
+    vec.push_back(5);
+    vec.push_back(6);
 
-    TestSystem::start_test(tvector_data, "get_data");
-    TestSystem::start_test(tvector_const_data, "get_const_data");
-    TestSystem::start_test(tvector_size, "get_size");
-    TestSystem::start_test(tvector_capacity, "get_capacity");
-    TestSystem::start_test(tvector_front, "get_front");
-    TestSystem::start_test(tvector_back, "get_back");
-    TestSystem::start_test(tvector_begin, "begin");
-    TestSystem::start_test(tvector_end, "end");
+    return TestSystem::check_exp(static_cast<size_t>(31), vec.size()) &&
+        TestSystem::check_exp(static_cast<size_t>(40), vec.capacity());
+}
 
-    TestSystem::start_test(tvector_iterator_init, "iterator_init");
-    TestSystem::start_test(tvector_iterator_dereference_operator,
-        "iterator_dereference_operator");
-    TestSystem::start_test(tvector_iterator_dereference_operator_empty,
-        "iterator_dereference_operator_empty");
-    TestSystem::start_test(tvector_iterator_dereference_operator_out_of_range,
-        "iterator_dereference_operator_out_of_range");
-    TestSystem::start_test(tvector_iterator_arrow_operator, "iterator_arrow");
-    TestSystem::start_test(tvector_iterator_assign, "iterator_assign");
-    TestSystem::start_test(tvector_iterator_right_increment,
-        "iterator_right_increment");
-    TestSystem::start_test(tvector_iterator_left_increment,
-        "iterator_left_increment");
-    TestSystem::start_test(tvector_iterator_right_decrement,
-        "iterator_right_decrement");
-    TestSystem::start_test(tvector_iterator_left_decrement,
-        "iterator_left_decrement");
-    TestSystem::start_test(tvector_iterator_add, "iterator_add");
-    TestSystem::start_test(tvector_iterator_add_out_off_range_exception,
-        "insert_add_out_off_range_exception");
-    TestSystem::start_test(tvector_iterator_sub, "iterator_sub");
-    TestSystem::start_test(tvector_iterator_sub_out_off_range_exception,
-        "insert_sub_out_off_range_exception");
-    TestSystem::start_test(tvector_iterator_add_assign, "iterator_add_assign");
-    TestSystem::start_test(tvector_iterator_add_assign_out_off_range_exception,
-        "iterator_add_assign_out_off_range_exception");
-    TestSystem::start_test(tvector_iterator_sub_assign, "iterator_sub_assign");
-    TestSystem::start_test(tvector_iterator_sub_assign_out_off_range_exception,
-        "iterator_sub_assign_out_off_range_exception");
-    TestSystem::start_test(tvector_iterator_operator_equality,
-        "iterator_operator_equality");
-    TestSystem::start_test(tvector_iterator_operator_inequality,
-        "iterator_operator_inequality");
-    TestSystem::start_test(tvector_iterator_operator_iterator_difference,
-        "iterator_operator_iterator_difference");
+bool tvector_geometric_growth() {
+    TVector<int, TGrowth2x> vec;
+    size_t reallocations = 0;
+    size_t prev_capacity = vec.capacity();
 
-    TestSystem::start_test(tvector_push_back_copy, "push_back_copy");
-    TestSystem::start_test(tvector_push_back_move, "push_back_move");
-    TestSystem::start_test(tvector_push_front_copy, "push_back_copy");
-    TestSystem::start_test(tvector_push_front_move, "push_back_move");
-    TestSystem::start_test(tvector_insert_elems_copy, "insert_elems_copy");
-    TestSystem::start_test(tvector_insert_copy, "insert_copy");
-    TestSystem::start_test(tvector_insert_move, "insert_move");
-    TestSystem::start_test(tvector_emplace, "emplace");
-    TestSystem::start_test(tvector_pop_back, "pop_back");
-    TestSystem::start_test(tvector_pop_front, "pop_front");
-    TestSystem::start_test(tvector_erase, "erase");
+    for (int i = 0; i < 100000; i++) {
+        vec.push_back(i);
 
-    TestSystem::start_test(tvector_clear, "clear");
-    TestSystem::start_test(tvector_shrink_to_fit, "shrink_to_fit");
-    TestSystem::start_test(tvector_resize_1, "resize_1");
-    TestSystem::start_test(tvector_resize_2, "resize_2");
-    TestSystem::start_test(tvector_resize_3, "resize_3");
-    TestSystem::start_test(tvector_shuffle, "shuffle");
-    TestSystem::start_test(tvector_search_begin, "search_begin");
-    TestSystem::start_test(tvector_search_end, "search_end");
-    TestSystem::start_test(tvector_search_all, "search_all");
+        if (vec.capacity() != prev_capacity) {
+            prev_capacity = vec.capacity();
+            reallocations++;
+        }
+    }
 
-    TestSystem::start_test(tvector_test, "test");
+    return TestSystem::check_exp(static_cast<size_t>(100000), vec.size()) &&
+        TestSystem::check_exp(true, reallocations <= 14) &&
+        TestSystem::check_exp(0, vec[0]) &&
+        TestSystem::check_exp(99999, vec[99999]);
+}
 
-    // TestSystem::start_test(tvector_sort, "sort");
-    TestSystem::start_test(tvector_push_back_copy, "push_back_copy");
-    TestSystem::start_test(tvector_pop_back, "pop_back");
-    TestSystem::start_test(tvector_erase_empty, "erase_empty");
-    // TestSystem::start_test(tvector_pop_back_large_vector,
-    // "pop_back_large_vector");
-    TestSystem::print_final_info();
+bool tvector_geometric_growth_1_5x() {
+    TVector<int, TGrowth1_5x> vec(16, 1);
+    vec.push_back(2);
 
-    std::cout << "Block of AI generated Tests" << std::endl;
-    TestSystem::start_test(tvector_size_value_init_zero,
-        "size_value_init_zero");
-    TestSystem::start_test(tvector_size_value_init_large,
-        "size_value_init_large");
-    TestSystem::start_test(tvector_self_assignment,
-        "self_assignment");
-    TestSystem::start_test(tvector_assignment_different_sizes,
-        "assignment_different_sizes");
-    TestSystem::start_test(tvector_front_exception, "front_exception");
-    TestSystem::start_test(tvector_back_exception, "back_exception");
-    TestSystem::start_test(tvector_front_back_after_operations,
-        "front_back_after_operations");
-    TestSystem::start_test(tvector_is_empty_true, "is_empty_true");
-    TestSystem::start_test(tvector_is_empty_false, "is_empty_false");
-    TestSystem::start_test(tvector_is_empty_after_clear,
-        "is_empty_after_clear");
-    TestSystem::start_test(tvector_is_empty_after_all_erased,
-        "is_empty_after_all_erased");
-    TestSystem::start_test(tvector_iterator_begin_end_empty,
-        "iterator_begin_end_empty");
-    TestSystem::start_test(tvector_iterator_arithmetic_edge_cases,
-     "iterator_arithmetic_edge_cases");
-    TestSystem::start_test(tvector_iterator_skip_deleted,
-     "iterator_skip_deleted");
-    TestSystem::start_test(tvector_memory_management_stress,
-     "memory_management_stress");
-    TestSystem::start_test(tvector_copy_with_deleted_elements,
-     "copy_with_deleted_elements");
-    TestSystem::start_test(tvector_move_from_empty, "move_from_empty");
-    TestSystem::start_test(tvector_initializer_list_duplicates,
-     "initializer_list_duplicates");
-    TestSystem::start_test(tvector_push_to_full_capacity,
-     "push_to_full_capacity");
-    TestSystem::start_test(tvector_multiple_insertions, "multiple_insertions");
-    TestSystem::start_test(tvector_emplace_construction,
-     "emplace_construction");
-    TestSystem::start_test(tvector_shrink_to_fit_empty, "shrink_to_fit_empty");
-    TestSystem::start_test(tvector_shrink_to_fit_after_deletions,
-     "shrink_to_fit_after_deletions");
-    TestSystem::start_test(tvector_resize_to_zero, "resize_to_zero");
-    TestSystem::start_test(tvector_resize_same_size, "resize_same_size");
-    TestSystem::start_test(tvector_index_access_with_deletions,
-     "index_access_with_deletions");
-    TestSystem::start_test(tvector_const_operations, "const_operations");
-    TestSystem::start_test(tvector_iterator_comparisons,
-     "iterator_comparisons");
-    TestSystem::start_test(tvector_iterator_index_operator,
-     "iterator_index_operator");
-    TestSystem::start_test(tvector_iterator_index_operator_exception,
-     "iterator_index_operator_exception");
-    TestSystem::start_test(tvector_large_operations, "large_operations");
-    TestSystem::start_test(tvector_exception_safety, "exception_safety");
-    TestSystem::start_test(tvector_capacity_management, "capacity_management");
-    TestSystem::start_test(tvector_equality_after_operations,
-     "equality_after_operations");
-    TestSystem::start_test(tvector_search_no_matches, "search_no_matches");
-    TestSystem::start_test(tvector_search_all_match, "search_all_match");
-    TestSystem::start_test(tvector_sort_already_sorted, "sort_already_sorted");
-    TestSystem::start_test(tvector_sort_reverse_order, "sort_reverse_order");
-    TestSystem::start_test(tvector_sort_with_deletions, "sort_with_deletions");
-    TestSystem::start_test(tvector_shuffle_preserves_elements,
-     "shuffle_preserves_elements");
-    TestSystem::start_test(tvector_performance_push_back,
-        "performance_push_back");
+    return TestSystem::check_exp(static_cast<size_t>(24), vec.capacity()) &&
+        TestSystem::check_exp(2, vec.back());
+}
 
-    TestSystem::start_test(tvector_const_iterator_begin,
-     "const_iterator_begin");
-    TestSystem::start_test(tvector_const_iterator_end,
-     "const_iterator_end");
-    TestSystem::start_test(tvector_const_iterator_dereference,
-     "tvector_const_iterator_dereference");
-    TestSystem::start_test(tvector_const_iterator_increment,
-     "tvector_const_iterator_increment");
-    TestSystem::start_test(tvector_const_iterator_decrement,
-     "tvector_const_iterator_decrement");
-    TestSystem::start_test(tvector_const_iterator_comparison,
-     "tvector_const_iterator_comparison");
-    TestSystem::start_test(tvector_const_iterator_range_based_for,
-     "tvector_const_iterator_range_based_for");
-    TestSystem::start_test(tvector_const_iterator_after_modification,
-     "tvector_const_iterator_after_modification");
+bool tvector_page_growth() {
+    TVector<int, TPageGrowth<>> vec;
+
+    for (int i = 0; i < 5000; i++) {
+        vec.push_back(i);
+    }
+
+    return TestSystem::check_exp(static_cast<size_t>(0),
+            vec.capacity() * sizeof(int) % 4096) &&
+        TestSystem::check_exp(4999, vec.back());
+}
+
+#pragma endregion
+
+#pragma region BusyIndexTests
+
+bool tvector_index_access_after_many_erases() {
+    TVector<int> vec;
+    int expected[2000];
+    size_t expected_size = 0;
+
+    for (int i = 0; i < 2000; i++) {
+        vec.push_back(i);
+    }
+
+    for (int i = 0; i < 2000; i++) {
+        if (i % 13 != 5)
+            expected[expected_size++] = i;
+    }
+
+    for (int i = 1999; i >= 0; i--) {
+        if (i % 13 == 5)
+            vec.erase(vec.begin() + i);
+    }
+
+    bool all_correct = vec.size() == expected_size;
+
+    for (size_t i = 0; all_correct && i < expected_size; i++) {
+        all_correct = vec[i] == expected[i];
+    }
+
+    return TestSystem::check_exp(true, all_correct);
+}
+
+bool tvector_index_access_through_pops_and_compaction() {
+    TVector<int> vec;
+
+    for (int i = 0; i < 1000; i++) {
+        vec.push_back(i);
+    }
+
+    bool all_correct = true;
+
+    for (int round = 0; round < 300; round++) {
+        vec.pop_front();
+        vec.pop_back();
+
+        const TVector<int>& const_vec = vec;
+        size_t last = vec.size() - 1;
+
+        all_correct = all_correct && vec[0] == round + 1 &&
+            const_vec[last] == 998 - round &&
+            vec[last / 2] == static_cast<int>(round + 1 + last / 2);
+    }
+
+    return TestSystem::check_exp(true, all_correct) &&
+        TestSystem::check_exp(static_cast<size_t>(400), vec.size());
+}
+
+#pragma endregion
+
+// Allocator that throws std::bad_alloc once budget allocations were made
+// (a negative budget never runs out) and counts the live allocations.
+struct AllocationBudget {
+    static int budget;
+    static int live;
+};
+
+int AllocationBudget::budget = -1;
+int AllocationBudget::live = 0;
+
+template<typename T>
+struct BudgetAllocator {
+    using value_type = T;
+
+    BudgetAllocator() noexcept = default;
+    template<typename U>
+    BudgetAllocator(const BudgetAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count) {
+        if (AllocationBudget::budget == 0)
+            throw std::bad_alloc();
+
+        if (AllocationBudget::budget > 0)
+            AllocationBudget::budget--;
+
+        T* memory = std::allocator<T>().allocate(count);
+        AllocationBudget::live++;
+        return memory;
+    }
+
+    void deallocate(T* memory, size_t count) noexcept {
+        std::allocator<T>().deallocate(memory, count);
+        AllocationBudget::live--;
+    }
+
+    template<typename U>
+    bool operator==(const BudgetAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const BudgetAllocator<U>&) const noexcept {
+        return false;
+    }
+};
+
+#pragma region StateMapTests
+
+bool tvector_states_view() {
+    TVector<int> vec;
+
+    for (int i = 0; i < 20; i++) {
+        vec.push_back(i);
+    }
+
+    vec.erase(vec.begin() + 2);
+    TStatesView states = vec.states();
+
+    return TestSystem::check_exp(vec.capacity(), states.size()) &&
+        TestSystem::check_exp(true, states[0] == Busy) &&
+        TestSystem::check_exp(true, states[2] == Deleted) &&
+        TestSystem::check_exp(true, states[19] == Busy) &&
+        TestSystem::check_exp(true, states[20] == Empty);
+}
+
+bool find_multiple_of_50(int a) {
+    return a % 50 == 0;
+}
+
+bool tvector_scans_across_word_boundaries() {
+    TVector<int> vec;
+
+    for (int i = 0; i < 300; i++) {
+        vec.push_back(i);
+    }
+
+    for (int i = 0; i < 40; i++) {
+        vec.pop_front();
+    }
+
+    for (int i = 0; i < 3; i++) {
+        vec.pop_back();
+    }
+
+    int sum = 0;
+    int count = 0;
+
+    for (auto it = vec.begin(); it != vec.end(); ++it) {
+        sum += *it;
+        count++;
+    }
+
+    return TestSystem::check_exp(257, count) &&
+        TestSystem::check_exp((40 + 296) * 257 / 2, sum) &&
+        TestSystem::check_exp(40, vec.front()) &&
+        TestSystem::check_exp(296, vec.back()) &&
+        TestSystem::check_exp(static_cast<size_t>(10),
+        search_begin(vec, find_multiple_of_50)) &&
+        TestSystem::check_exp(static_cast<size_t>(210),
+        search_end(vec, find_multiple_of_50)) &&
+        TestSystem::check_exp(257, static_cast<int>(vec.end() - vec.begin()));
+}
+
+bool tvector_state_map_reset_fails_cleanly() {
+    using Map = TBasicStateMap<BudgetAllocator<uint64_t>>;
+    AllocationBudget::live = 0;
+    int throws = 0;
+    bool kept = true;
+
+    // A map of 100 slots holds three arrays; growing it takes three new
+    // ones, so budgets 0 to 2 fail the reset at each allocation in turn.
+    for (int budget = 0; budget <= 3; budget++) {
+        AllocationBudget::budget = -1;
+
+        {
+            Map map(100);
+            map.set(5, Busy);
+            map.set(70, Deleted);
+            AllocationBudget::budget = budget;
+
+            try {
+                map.reset(1000);
+            } catch (const std::bad_alloc&) {
+                throws++;
+                kept = kept && map.get(5) == Busy &&
+                    map.get(70) == Deleted && map.rank(100) == 1;
+            }
+
+            AllocationBudget::budget = -1;
+            map.reset(100);
+            map.set(99, Busy);
+            kept = kept && map.busy(99) && map.rank(100) == 1;
+        }
+
+        kept = kept && AllocationBudget::live == 0;
+    }
+
+    return TestSystem::check_exp(3, throws) &&
+        TestSystem::check_exp(true, kept);
+}
+
+#pragma endregion
+
+#pragma region RelocationTests
+
+bool tvector_relocates_strings() {
+    TVector<std::string> vec;
+
+    for (int i = 0; i < 40; i++) {
+        vec.push_back("string long enough to live on the heap #" +
+            std::to_string(i));
+    }
+
+    vec.push_front("front");
+    vec.insert(vec.begin() + 10, "middle");
+    vec.erase(vec.begin() + 20);
+    vec.pop_back();
+
+    for (int i = 0; i < 10; i++) {
+        vec.pop_front();
+    }
+
+    vec.shrink_to_fit();
+
+    return TestSystem::check_exp(static_cast<size_t>(30), vec.size()) &&
+        TestSystem::check_exp(std::string("middle"), vec[0]) &&
+        TestSystem::check_exp(
+            std::string("string long enough to live on the heap #9"), vec[1]) &&
+        TestSystem::check_exp(
+            std::string("string long enough to live on the heap #38"),
+            vec.back());
+}
+
+struct Pod64 {
+    int64_t fields[8];
+};
+
+bool tvector_relocates_trivially_copyable_records() {
+    TVector<Pod64> vec;
+
+    for (int64_t i = 0; i < 50; i++) {
+        Pod64 record = {{i, i + 1, i + 2, i + 3, i + 4, i + 5, i + 6, i + 7}};
+        vec.push_front(record);
+    }
+
+    Pod64 marker = {{-1, -1, -1, -1, -1, -1, -1, -1}};
+    vec.insert(vec.begin() + 25, 3, marker);
+
+    return TestSystem::check_exp(static_cast<size_t>(53), vec.size()) &&
+        TestSystem::check_exp(static_cast<int64_t>(56), vec[0].fields[7]) &&
+        TestSystem::check_exp(static_cast<int64_t>(-1), vec[27].fields[0]) &&
+        TestSystem::check_exp(static_cast<int64_t>(24), vec[28].fields[0]) &&
+        TestSystem::check_exp(static_cast<int64_t>(7), vec.back().fields[7]);
+}
+
+bool tvector_insert_into_full_vector_with_tombstones() {
+    TVector<int> vec;
+
+    for (int i = 0; i < 15; i++) {
+        vec.push_back(i);
+    }
+
+    vec.pop_front();
+    vec.insert(vec.begin() + 5, 100);
+
+    return TestSystem::check_exp(static_cast<size_t>(15), vec.size()) &&
+        TestSystem::check_exp(5, vec[4]) &&
+        TestSystem::check_exp(100, vec[5]) &&
+        TestSystem::check_exp(6, vec[6]);
+}
+
+#pragma endregion
+
+#pragma region RawStorageTests
+
+// Counts live instances, so slots without an element must hold no object.
+struct LiveCounter {
+    static int alive;
+    int value;
+
+    explicit LiveCounter(int v) : value(v) { alive++; }
+    LiveCounter(const LiveCounter& other) : value(other.value) { alive++; }
+    LiveCounter& operator=(const LiveCounter&) = default;
+    ~LiveCounter() { alive--; }
+};
+
+int LiveCounter::alive = 0;
+
+// Throws when copied from a value of -1.
+struct ThrowingCopy {
+    static int alive;
+    int value;
+
+    explicit ThrowingCopy(int v) : value(v) { alive++; }
+    ThrowingCopy(const ThrowingCopy& other) : value(other.value) {
+        if (value == -1)
+            throw std::runtime_error("copy of -1");
+
+        alive++;
+    }
+    ~ThrowingCopy() { alive--; }
+};
+
+int ThrowingCopy::alive = 0;
+
+bool tvector_spare_slots_hold_no_objects() {
+    LiveCounter::alive = 0;
+    bool result = true;
+
+    {
+        TVector<LiveCounter> vec;
+
+        for (int i = 0; i < 20; i++) {
+            vec.push_back(LiveCounter(i));
+        }
+
+        result = TestSystem::check_exp(20, LiveCounter::alive) &&
+            TestSystem::check_exp(static_cast<size_t>(30), vec.capacity());
+
+        vec.pop_front();
+        vec.erase(vec.begin() + 5);
+        result = result && TestSystem::check_exp(18, LiveCounter::alive);
+
+        vec.push_front(LiveCounter(-1));
+        vec.insert(vec.begin() + 3, LiveCounter(-2));
+        result = result && TestSystem::check_exp(20, LiveCounter::alive) &&
+            TestSystem::check_exp(-2, vec[3].value);
+
+        TVector<LiveCounter> copy(vec);
+        result = result && TestSystem::check_exp(40, LiveCounter::alive);
+
+        copy.clear();
+        result = result && TestSystem::check_exp(20, LiveCounter::alive);
+    }
+
+    return result && TestSystem::check_exp(0, LiveCounter::alive);
+}
+
+bool tvector_resize_constructs_and_destroys() {
+    TVector<std::string> vec = {"a", "b", "c", "d"};
+
+    vec.resize(20);
+    vec[19] = "tail";
+    vec.resize(2);
+
+    return TestSystem::check_exp(static_cast<size_t>(2), vec.size()) &&
+        TestSystem::check_exp(std::string("b"), vec.back());
+}
+
+bool string_less(std::string a, std::string b) {
+    return a < b;
+}
+
+bool tvector_sort_and_shuffle_skip_tombstones() {
+    TVector<std::string> vec;
+
+    for (int i = 0; i < 30; i++) {
+        vec.push_back(std::to_string(100 + (i * 7) % 30));
+    }
+
+    vec.pop_front();
+    vec.erase(vec.begin() + 10);
+    shuffle(vec);
+    tv_sort(vec, string_less);
+
+    bool sorted = true;
+
+    for (size_t i = 1; i < vec.size(); i++) {
+        sorted = sorted && vec[i - 1] < vec[i];
+    }
+
+    return TestSystem::check_exp(static_cast<size_t>(28), vec.size()) &&
+        TestSystem::check_exp(true, sorted);
+}
+
+#pragma endregion
+
+#pragma region AllocatorTests
+
+bool tvector_arena_allocator() {
+    TArena arena(4096);
+    bool result = true;
+
+    {
+        TVector<int, TGrowth2x, TArenaAllocator<int>> vec{
+            TArenaAllocator<int>(arena)};
+
+        for (int i = 0; i < 1000; i++) {
+            vec.push_back(i);
+        }
+
+        vec.erase(vec.begin() + 10);
+
+        TVector<int, TGrowth2x, TArenaAllocator<int>> copy(vec);
+
+        result = TestSystem::check_exp(static_cast<size_t>(999), copy.size()) &&
+            TestSystem::check_exp(11, copy[10]) &&
+            TestSystem::check_exp(&arena, copy.get_allocator().arena()) &&
+            TestSystem::check_exp(true, arena.reserved() > 0);
+    }
+
+    arena.release();
+
+    return result &&
+        TestSystem::check_exp(static_cast<size_t>(0), arena.reserved());
+}
+
+bool tvector_arena_allocator_filled_constructors() {
+    TArena arena(4096);
+    TArenaAllocator<int> allocator(arena);
+    int source[] = {4, 5, 6, 7};
+    TVector<int, TGrowth2x, TArenaAllocator<int>> listed({1, 2, 3}, allocator);
+    TVector<int, TGrowth2x, TArenaAllocator<int>> filled(50, 9, allocator);
+    TVector<int, TGrowth2x, TArenaAllocator<int>> sized(20, allocator);
+    TVector<int, TGrowth2x, TArenaAllocator<int>> copied(source, 4, allocator);
+    filled.push_back(10);
+
+    return TestSystem::check_exp(static_cast<size_t>(3), listed.size()) &&
+        TestSystem::check_exp(3, listed.back()) &&
+        TestSystem::check_exp(static_cast<size_t>(51), filled.size()) &&
+        TestSystem::check_exp(9, filled[49]) &&
+        TestSystem::check_exp(10, filled.back()) &&
+        TestSystem::check_exp(0, sized[19]) &&
+        TestSystem::check_exp(7, copied.back()) &&
+        TestSystem::check_exp(&arena, filled.get_allocator().arena()) &&
+        TestSystem::check_exp(true, arena.reserved() > 0);
+}
+
+bool tvector_pool_allocator_recycles_buffers() {
+    TBufferPool pool;
+    const int* first_buffer = nullptr;
+    const int* second_buffer = nullptr;
+
+    {
+        TVector<int, TGrowth2x, TPoolAllocator<int>> vec{
+            TPoolAllocator<int>(pool)};
+
+        for (int i = 0; i < 100; i++) {
+            vec.push_back(i);
+        }
+
+        first_buffer = vec.data();
+    }
+
+    size_t cached = pool.cached();
+
+    {
+        TVector<int, TGrowth2x, TPoolAllocator<int>> vec{
+            TPoolAllocator<int>(pool)};
+
+        for (int i = 0; i < 100; i++) {
+            vec.push_back(i);
+        }
+
+        second_buffer = vec.data();
+    }
+
+    return TestSystem::check_exp(true, cached > 0) &&
+        TestSystem::check_exp(first_buffer, second_buffer);
+}
+
+bool tvector_huge_page_allocator() {
+    TVector<int64_t, TGrowth2x, THugePageAllocator<int64_t>> vec;
+    int64_t sum = 0;
+
+    for (int64_t i = 0; i < 600000; i++) {
+        vec.push_back(i);
+    }
+
+    vec.pop_front();
+
+    for (auto it = vec.begin(); it != vec.end(); ++it) {
+        sum += *it;
+    }
+
+    return TestSystem::check_exp(static_cast<size_t>(599999), vec.size()) &&
+        TestSystem::check_exp(static_cast<int64_t>(599999) * 600000 / 2, sum);
+}
+
+bool tvector_allocators_reject_overflowing_counts() {
+    TArena arena;
+    TBufferPool pool;
+    TArenaAllocator<int64_t> from_arena(arena);
+    TPoolAllocator<int64_t> from_pool(pool);
+    THugePageAllocator<int64_t> huge;
+    size_t count = static_cast<size_t>(-1) / 4;
+    int thrown = 0;
+
+    try {
+        from_arena.allocate(count);
+    } catch (const std::bad_array_new_length&) {
+        thrown++;
+    }
+
+    try {
+        from_pool.allocate(count);
+    } catch (const std::bad_array_new_length&) {
+        thrown++;
+    }
+
+    try {
+        huge.allocate(count);
+    } catch (const std::bad_array_new_length&) {
+        thrown++;
+    }
+
+    return TestSystem::check_exp(3, thrown) &&
+        TestSystem::check_exp(static_cast<size_t>(0), pool.cached());
+}
+
+#pragma endregion
+
+#pragma region IteratorIdentityTests
+
+bool tvector_iterators_of_equal_vectors_differ() {
+    TVector<int> vec = {1, 2, 3};
+    TVector<int> copy(vec);
+    const TVector<int>& const_vec = vec;
+    const TVector<int>& const_copy = copy;
+
+    return TestSystem::check_exp(true, vec == copy) &&
+        TestSystem::check_exp(true, vec.end() != copy.end()) &&
+        TestSystem::check_exp(false, vec.end() == copy.end()) &&
+        TestSystem::check_exp(true, vec.end() == vec.end()) &&
+        TestSystem::check_exp(true, const_vec.end() != const_copy.end()) &&
+        TestSystem::check_exp(true, const_vec.begin() == const_vec.begin());
+}
+
+#pragma endregion
+
+#pragma region DenseViewTests
+
+bool tvector_dense_iterator_arithmetic() {
+    TVector<int> vec;
+
+    for (int i = 0; i < 40; i++) {
+        vec.push_back(i);
+    }
+
+    auto it = vec.begin() + 10;
+    auto back = vec.end() - 1;
+    it += 5;
+    it -= 2;
+    --back;
+
+    return TestSystem::check_exp(true, vec.is_dense()) &&
+        TestSystem::check_exp(13, *it) &&
+        TestSystem::check_exp(20, it[7]) &&
+        TestSystem::check_exp(38, *back) &&
+        TestSystem::check_exp(25, static_cast<int>(back - it)) &&
+        TestSystem::check_exp(40, static_cast<int>(vec.end() - vec.begin()));
+}
+
+bool tvector_dense_view_compacts_on_demand() {
+    TVector<int> vec;
+
+    for (int i = 0; i < 30; i++) {
+        vec.push_back(30 - i);
+    }
+
+    vec.erase(vec.begin() + 3);
+    bool dense_before = vec.is_dense();
+    TDenseView<int> view = vec.dense_view();
+    std::sort(view.begin(), view.end());
+
+    return TestSystem::check_exp(false, dense_before) &&
+        TestSystem::check_exp(true, vec.is_dense()) &&
+        TestSystem::check_exp(static_cast<size_t>(29), view.size()) &&
+        TestSystem::check_exp(vec.data(), view.data()) &&
+        TestSystem::check_exp(1, vec[0]) &&
+        TestSystem::check_exp(30, vec[28]) &&
+        TestSystem::check_exp(true, std::is_sorted(vec.begin(), vec.end()));
+}
+
+bool tvector_const_dense_view_needs_dense_vector() {
+    TVector<int> vec;
+    const TVector<int>& const_vec = vec;
+    int sum = 0;
+
+    for (int i = 1; i <= 20; i++) {
+        vec.push_back(i);
+    }
+
+    for (int value : const_vec.dense_view()) {
+        sum += value;
+    }
+
+    vec.pop_front();
+
+    try {
+        const_vec.dense_view();
+    }
+    catch (const std::runtime_error&) {
+        return TestSystem::check_exp(210, sum);
+    }
+
+    return false;
+}
+
+#pragma endregion
+
+#pragma region SortEngineTests
+
+// Inputs that push plain quicksort to quadratic time or deep recursion.
+bool tvector_sort_adversarial_patterns() {
+    const int n = 20000;
+    bool result = true;
+
+    for (int pattern = 0; pattern < 6; pattern++) {
+        TVector<int> vec;
+        uint32_t seed = 12345;
+
+        for (int i = 0; i < n; i++) {
+            seed = seed * 1664525u + 1013904223u;
+
+            switch (pattern) {
+            case 0: vec.push_back(i); break;
+            case 1: vec.push_back(n - i); break;
+            case 2: vec.push_back(i < n / 2 ? i : n - i); break;
+            case 3: vec.push_back(static_cast<int>(seed % 4)); break;
+            case 4: vec.push_back(i % 2 == 0 ? i : n - i); break;
+            default: vec.push_back(static_cast<int>(seed >> 8)); break;
+            }
+        }
+
+        tv_sort(vec);
+        result = result &&
+            TestSystem::check_exp(true, std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    return result;
+}
+
+bool tvector_sort_with_callable_comparator() {
+    TVector<std::string> vec;
+
+    for (int i = 0; i < 500; i++) {
+        vec.push_back(std::to_string((i * 37) % 500));
+    }
+
+    for (int i = 0; i < 50; i++) {
+        vec.pop_front();
+    }
+
+    tv_sort(vec, [](const std::string& a, const std::string& b) {
+        return a.size() != b.size() ? a.size() > b.size() : a < b;
+    });
+
+    return TestSystem::check_exp(static_cast<size_t>(450), vec.size()) &&
+        TestSystem::check_exp(true, vec.is_dense()) &&
+        TestSystem::check_exp(std::string("100"), vec.front()) &&
+        TestSystem::check_exp(std::string("9"), vec.back());
+}
+
+bool tvector_sort_matches_std_sort() {
+    TVector<double> vec;
+    TVector<double> expected;
+    uint64_t seed = 88172645463325252ull;
+
+    for (int i = 0; i < 100000; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        vec.push_back(static_cast<double>(seed % 1000003) / 7.0);
+    }
+
+    expected = vec;
+    TDenseView<double> view = expected.dense_view();
+    std::sort(view.begin(), view.end(), std::greater<double>());
+    tv_sort(vec, std::greater<double>());
+
+    return TestSystem::check_exp(expected, vec);
+}
+
+#pragma endregion
+
+#pragma region RadixSortTests
+
+bool tvector_radix_sort_signed_and_floating() {
+    TVector<int64_t> integers;
+    TVector<double> doubles;
+    uint64_t seed = 88172645463325252ull;
+
+    for (int i = 0; i < 5000; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        integers.push_back(static_cast<int64_t>(seed));
+        doubles.push_back(static_cast<double>(static_cast<int32_t>(seed))
+            / 3.0);
+    }
+
+    doubles.push_back(-0.0);
+    doubles.push_back(1e300);
+    doubles.push_back(-1e300);
+
+    tv_sort(integers);
+    tv_sort(doubles, std::less<double>());
+
+    return TestSystem::check_exp(true,
+        std::is_sorted(integers.begin(), integers.end())) &&
+        TestSystem::check_exp(true,
+        std::is_sorted(doubles.begin(), doubles.end())) &&
+        TestSystem::check_exp(-1e300, doubles.front()) &&
+        TestSystem::check_exp(1e300, doubles.back());
+}
+
+struct Record {
+    int16_t priority;
+    int order;
+};
+
+int16_t record_priority(const Record& record) {
+    return record.priority;
+}
+
+// LSD radix sort keeps equal keys in their original order.
+bool tvector_radix_sort_by_key_is_stable() {
+    TVector<Record> vec;
+    bool ordered = true;
+
+    for (int i = 0; i < 3000; i++) {
+        Record record = { static_cast<int16_t>((i * 7919) % 61 - 30), i };
+        vec.push_back(record);
+    }
+
+    tv_radix_sort(vec, record_priority);
+
+    for (size_t i = 1; i < vec.size(); i++) {
+        const Record& prev = vec[i - 1];
+        const Record& next = vec[i];
+
+        if (prev.priority > next.priority ||
+            (prev.priority == next.priority && prev.order > next.order))
+            ordered = false;
+    }
+
+    return TestSystem::check_exp(static_cast<size_t>(3000), vec.size()) &&
+        TestSystem::check_exp(true, ordered) &&
+        TestSystem::check_exp(static_cast<int16_t>(-30), vec.front().priority);
+}
+
+bool tvector_radix_sort_with_tombstones() {
+    TVector<uint32_t> vec;
+    TVector<uint32_t> expected;
+
+    for (uint32_t i = 0; i < 2000; i++) {
+        vec.push_back(2000 - i);
+    }
+
+    for (int i = 0; i < 100; i++) {
+        vec.pop_front();
+    }
+
+    for (uint32_t i = 1; i <= 1900; i++) {
+        expected.push_back(i);
+    }
+
+    tv_radix_sort(vec);
+
+    return TestSystem::check_exp(expected, vec) &&
+        TestSystem::check_exp(true, vec.is_dense());
+}
+
+struct ThrowingKey {
+    int* calls;
+    int throw_at;
+
+    int32_t operator()(int32_t value) const {
+        if (++*calls == throw_at)
+            throw std::runtime_error("key");
+
+        return value;
+    }
+};
+
+// A key that may throw is called once per element, before any element
+// moves, so a throw leaves the vector as it was and frees the buffer.
+bool tvector_radix_sort_throwing_key() {
+    TVector<int32_t, TGrowth2x, BudgetAllocator<int32_t>> vec;
+    TVector<int32_t, TGrowth2x, BudgetAllocator<int32_t>> expected;
+    int calls = 0;
+
+    for (int32_t i = 0; i < 1000; i++) {
+        vec.push_back((i * 7919) % 1000 - 500);
+    }
+
+    expected = vec;
+    int live = AllocationBudget::live;
+    bool thrown = false;
+
+    try {
+        tv_radix_sort(vec, ThrowingKey{ &calls, 700 });
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+
+    bool kept = vec == expected;
+    int live_after = AllocationBudget::live;
+    calls = 0;
+    tv_radix_sort(vec, ThrowingKey{ &calls, -1 });
+
+    return TestSystem::check_exp(true, thrown) &&
+        TestSystem::check_exp(true, kept) &&
+        TestSystem::check_exp(live, live_after) &&
+        TestSystem::check_exp(1000, calls) &&
+        TestSystem::check_exp(true, std::is_sorted(vec.begin(), vec.end())) &&
+        TestSystem::check_exp(-500, vec.front());
+}
+
+#pragma endregion
+
+#pragma region ParallelSortTests
+
+bool uint64_greater(uint64_t a, uint64_t b) {
+    return a > b;
+}
+
+bool tvector_parallel_sort_matches_serial() {
+    TVector<uint64_t, TGrowth2x> serial;
+    uint64_t seed = 88172645463325252ull;
+
+    for (int i = 0; i < 100000; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        serial.push_back(i % 3 == 0 ? seed % 50 : seed);
+    }
+
+    TVector<uint64_t, TGrowth2x> parallel(serial);
+    TVector<uint64_t, TGrowth2x> descending(serial);
+    TVector<uint64_t, TGrowth2x> serial_descending(serial);
+
+    tv_sort(serial);
+    tv_parallel_sort(parallel, std::less<uint64_t>(), 4);
+    tv_sort(serial_descending, uint64_greater);
+    tv_parallel_sort(descending, uint64_greater, 3);
+
+    return TestSystem::check_exp(serial, parallel) &&
+        TestSystem::check_exp(serial_descending, descending);
+}
+
+bool tvector_parallel_sort_on_shared_pool() {
+    TThreadPool pool(3);
+    bool result = true;
+
+    for (int round = 0; round < 3; round++) {
+        TVector<std::string, TGrowth2x> vec;
+
+        for (int i = 0; i < 60000; i++) {
+            vec.push_back(std::to_string((i * 7919 + round) % 20000));
+        }
+
+        for (int i = 0; i < 1000; i++) {
+            vec.pop_front();
+        }
+
+        TVector<std::string, TGrowth2x> expected(vec);
+        tv_sort(expected, string_less);
+        tv_parallel_sort(vec, string_less, pool);
+
+        result = result && TestSystem::check_exp(expected, vec);
+    }
+
+    return result;
+}
+
+// Without a thread count the sorts share tv_default_pool() call after call.
+bool tvector_parallel_sort_on_default_pool() {
+    bool result = true;
+
+    for (int round = 0; round < 3; round++) {
+        TVector<int, TGrowth2x> vec;
+
+        for (int i = 0; i < 50000; i++) {
+            vec.push_back((i * 7919 + round) % 30011);
+        }
+
+        TVector<int, TGrowth2x> expected(vec);
+        tv_sort(expected);
+
+        if (round == 0)
+            tv_parallel_sort(vec, std::less<int>());
+        else
+            tv_parallel_sort(vec, std::less<int>(), 0);
+
+        result = result && TestSystem::check_exp(expected, vec);
+    }
+
+    return result;
+}
+
+bool tvector_parallel_sort_rethrows() {
+    TVector<int, TGrowth2x> vec;
+    std::atomic<int> calls(0);
+
+    for (int i = 0; i < 200000; i++) {
+        vec.push_back((i * 7919) % 100003);
+    }
+
+    try {
+        tv_parallel_sort(vec, [&calls](int a, int b) {
+            if (++calls == 500000)
+                throw std::runtime_error("comparator");
+            return a < b;
+        }, 4);
+    } catch (const std::runtime_error&) {
+        return TestSystem::check_exp(static_cast<size_t>(200000),
+            vec.size());
+    }
+
+    return false;
+}
+
+bool tvector_thread_pool_runs_queued_tasks_on_shutdown() {
+    std::atomic<int> ran(0);
+
+    {
+        TThreadPool pool(2);
+
+        // Every tenth task queues one more while the pool shuts down.
+        for (int i = 0; i < 1000; i++) {
+            pool.submit([&ran, &pool, i] {
+                ran++;
+
+                if (i % 10 == 0)
+                    pool.submit([&ran] { ran++; });
+            });
+        }
+    }
+
+    return TestSystem::check_exp(1100, ran.load());
+}
+
+#pragma endregion
+
+#pragma region SelectionSortTests
+
+bool record_priority_less(const Record& first, const Record& second) {
+    return first.priority < second.priority;
+}
+
+bool tvector_stable_sort_keeps_equal_order() {
+    TVector<Record, TGrowth2x> vec;
+    bool ordered = true;
+
+    for (int i = 0; i < 5000; i++) {
+        Record record = { static_cast<int16_t>((i * 7919) % 37), i };
+        vec.push_back(record);
+    }
+
+    for (int i = 0; i < 500; i++) {
+        vec.pop_front();
+    }
+
+    size_t capacity = vec.capacity();
+    tv_stable_sort(vec, record_priority_less);
+
+    for (size_t i = 1; i < vec.size(); i++) {
+        const Record& prev = vec[i - 1];
+        const Record& next = vec[i];
+
+        if (prev.priority > next.priority ||
+            (prev.priority == next.priority && prev.order > next.order))
+            ordered = false;
+    }
+
+    return TestSystem::check_exp(static_cast<size_t>(4500), vec.size()) &&
+        TestSystem::check_exp(true, ordered) &&
+        TestSystem::check_exp(capacity, vec.capacity());
+}
+
+bool tvector_nth_element_and_partial_sort() {
+    TVector<int, TGrowth2x> vec;
+    uint32_t seed = 12345;
+
+    for (int i = 0; i < 20000; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        vec.push_back(static_cast<int>(seed % 5000));
+    }
+
+    for (int i = 0; i < 1000; i++) {
+        vec.pop_back();
+    }
+
+    TVector<int, TGrowth2x> sorted(vec);
+    tv_sort(sorted);
+
+    TVector<int, TGrowth2x> selected(vec);
+    tv_nth_element(selected, 7000);
+    bool partitioned = true;
+
+    for (size_t i = 0; i < selected.size(); i++) {
+        if ((i < 7000 && selected[i] > selected[7000]) ||
+            (i > 7000 && selected[i] < selected[7000]))
+            partitioned = false;
+    }
+
+    tv_partial_sort(vec, 100, std::greater<int>());
+    bool head_sorted = true;
+
+    for (size_t i = 0; i < 100; i++) {
+        if (vec[i] != sorted[sorted.size() - 1 - i])
+            head_sorted = false;
+    }
+
+    return TestSystem::check_exp(sorted[7000], selected[7000]) &&
+        TestSystem::check_exp(true, partitioned) &&
+        TestSystem::check_exp(true, head_sorted) &&
+        TestSystem::check_exp(static_cast<size_t>(19000), vec.size());
+}
+
+bool tvector_top_k_leaves_vector_untouched() {
+    TVector<std::string> vec;
+
+    for (int i = 0; i < 300; i++) {
+        vec.push_back(std::to_string(1000 + (i * 37) % 300));
+    }
+
+    for (int i = 0; i < 20; i++) {
+        vec.pop_front();
+    }
+
+    TVector<std::string> copy(vec);
+    TVector<std::string> smallest = tv_top_k(vec, 3);
+    TVector<std::string> largest = tv_top_k(vec, 2,
+        std::greater<std::string>());
+    TVector<std::string> all = tv_top_k(vec, 1000);
+
+    return TestSystem::check_exp(copy, vec) &&
+        TestSystem::check_exp(false, vec.is_dense()) &&
+        TestSystem::check_exp(static_cast<size_t>(3), smallest.size()) &&
+        TestSystem::check_exp(std::string("1001"), smallest[0]) &&
+        TestSystem::check_exp(std::string("1003"), smallest[2]) &&
+        TestSystem::check_exp(std::string("1299"), largest[0]) &&
+        TestSystem::check_exp(std::string("1298"), largest[1]) &&
+        TestSystem::check_exp(static_cast<size_t>(280), all.size());
+}
+
+#pragma endregion
+
+#pragma region SimdSearchTests
+
+template<typename T>
+bool kernels_match_scalar(T low, T high) {
+    T data[64];
+    uint64_t seed = 88172645463325252ull;
+    bool result = true;
+
+    for (int i = 0; i < 64; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        data[i] = i % 4 == 0 ? low : (seed % 2 == 0 ? high : static_cast<T>(
+            low + static_cast<T>(seed % 7)));
+    }
+
+    TSearchPredicate<T> checks[] = { tv_equal_to(low), tv_less_than(high),
+        tv_greater_than(low), tv_in_range(low, high) };
+
+    for (int level = 0; level <= static_cast<int>(tv_simd_level()); level++) {
+        for (const TSearchPredicate<T>& check : checks) {
+            for (size_t count = 1; count <= 64; count += 7) {
+                uint64_t expected = tv_match_word_scalar(data, count, check);
+                uint64_t actual = tv_match_word(
+                    static_cast<TSimdLevel>(level), data, count, check);
+                result = result && expected == actual;
+            }
+        }
+    }
+
+    return result;
+}
+
+bool tvector_simd_kernels_match_scalar() {
+    return TestSystem::check_exp(true, kernels_match_scalar<int32_t>(-5, 3)) &&
+        TestSystem::check_exp(true,
+        kernels_match_scalar<uint32_t>(3000000000u, 4000000000u)) &&
+        TestSystem::check_exp(true,
+        kernels_match_scalar<int64_t>(-(int64_t(1) << 40), 7)) &&
+        TestSystem::check_exp(true,
+        kernels_match_scalar<uint64_t>(uint64_t(1) << 63, ~uint64_t(0))) &&
+        TestSystem::check_exp(true, kernels_match_scalar<float>(-1.5f, 2.0f)) &&
+        TestSystem::check_exp(true, kernels_match_scalar<double>(0.25, 9.0));
+}
+
+bool find_three(int value) {
+    return value == 3;
+}
+
+bool tvector_search_with_predicate_skips_tombstones() {
+    TVector<int, TGrowth2x> vec;
+
+    for (int i = 0; i < 1000; i++) {
+        vec.push_back(i % 10);
+    }
+
+    for (int i = 0; i < 5; i++) {
+        vec.pop_front();
+    }
+
+    for (int i = 0; i < 100; i++) {
+        vec.erase(vec.begin() + 100);
+    }
+
+    TVector<size_t, TGrowth2x> expected = search_all(vec, find_three);
+    TVector<size_t, TGrowth2x> actual = search_all(vec, tv_equal_to(3));
+
+    return TestSystem::check_exp(true, expected == actual) &&
+        TestSystem::check_exp(search_begin(vec, find_three),
+        search_begin(vec, tv_equal_to(3))) &&
+        TestSystem::check_exp(search_end(vec, find_three),
+        search_end(vec, tv_equal_to(3))) &&
+        TestSystem::check_exp(TStateMap::npos,
+        search_begin(vec, tv_greater_than(9))) &&
+        TestSystem::check_exp(static_cast<size_t>(0),
+        search_begin(vec, tv_in_range(5, 6))) &&
+        TestSystem::check_exp(vec.size() - 6,
+        search_end(vec, tv_less_than(5)));
+}
+
+bool tvector_search_predicate_on_non_arithmetic() {
+    TVector<std::string> vec;
+
+    for (int i = 0; i < 200; i++) {
+        vec.push_back(std::to_string(i % 20));
+    }
+
+    for (int i = 0; i < 30; i++) {
+        vec.pop_front();
+    }
+
+    return TestSystem::check_exp(static_cast<size_t>(7),
+        search_begin(vec, tv_equal_to(std::string("17")))) &&
+        TestSystem::check_exp(static_cast<size_t>(167),
+        search_end(vec, tv_equal_to(std::string("17")))) &&
+        TestSystem::check_exp(static_cast<size_t>(0), search_begin(vec,
+        [](const std::string& value) { return value.size() == 2; }));
+}
+
+#pragma endregion
+
+#pragma region SearchResultTests
+
+bool tvector_search_all_is_compact() {
+    TVector<int, TGrowth2x> vec;
+
+    for (int i = 0; i < 10000; i++) {
+        vec.push_back(i);
+    }
+
+    TVector<size_t, TGrowth2x> three = search_all(vec, tv_in_range(4000, 4002));
+    TVector<size_t, TGrowth2x> none = search_all(vec, tv_greater_than(10000));
+    TVector<size_t, TGrowth2x> many = search_all(vec, tv_less_than(1000));
+
+    return TestSystem::check_exp(static_cast<size_t>(3), three.size()) &&
+        TestSystem::check_exp(static_cast<size_t>(3), three.capacity()) &&
+        TestSystem::check_exp(static_cast<size_t>(1000), many.capacity()) &&
+        TestSystem::check_exp(static_cast<size_t>(999), many.back()) &&
+        TestSystem::check_exp(static_cast<size_t>(4001), three[1]) &&
+        TestSystem::check_exp(true, none.is_empty()) &&
+        TestSystem::check_exp(static_cast<size_t>(0), none.capacity());
+}
+
+bool tvector_search_each_streams_matches_in_order() {
+    TVector<int> vec = { 5, 1, 5, 2, 5, 3, 5 };
+    vec.erase(vec.begin() + 2);
+    vec.pop_front();
+
+    size_t visited[4] = { 0, 0, 0, 0 };
+    size_t count = 0;
+
+    search_each(vec, tv_equal_to(5), [&](size_t index) {
+        visited[count++] = index;
+    });
+
+    return TestSystem::check_exp(static_cast<size_t>(2), count) &&
+        TestSystem::check_exp(static_cast<size_t>(2), visited[0]) &&
+        TestSystem::check_exp(static_cast<size_t>(4), visited[1]);
+}
+
+bool tvector_search_count_matches_search_all() {
+    TVector<int, TGrowth2x> vec;
+
+    for (int i = 0; i < 3000; i++) {
+        vec.push_back(i % 7);
+    }
+
+    for (int i = 0; i < 300; i++) {
+        vec.erase(vec.begin() + 9 * i);
+    }
+
+    return TestSystem::check_exp(search_all(vec, find_three).size(),
+        search_count(vec, find_three)) &&
+        TestSystem::check_exp(search_all(vec, tv_less_than(2)).size(),
+        search_count(vec, tv_less_than(2)));
+}
+
+#pragma endregion
+
+#pragma region ParallelReductionTests
+
+bool tvector_reductions_skip_tombstones() {
+    TVector<int64_t, TGrowth2x> vec;
+    int64_t sum = 0;
+    int64_t even = 0;
+    int64_t squares = 0;
+
+    for (int64_t i = 0; i < 300000; i++) {
+        vec.push_back(i % 1000 - 500);
+    }
+
+    for (int i = 0; i < 1000; i++) {
+        vec.erase(vec.begin() + 250 * i);
+    }
+
+    vec.pop_front();
+    vec.pop_back();
+
+    for (int64_t value : vec) {
+        sum += value;
+        even += value % 2 == 0;
+        squares += value * value;
+    }
+
+    TThreadPool pool(3);
+    auto is_even = [](int64_t value) { return value % 2 == 0; };
+
+    return TestSystem::check_exp(sum, tv_sum(vec, pool)) &&
+        TestSystem::check_exp(static_cast<size_t>(even),
+        tv_count_if(vec, is_even, pool)) &&
+        TestSystem::check_exp(search_count(vec, tv_less_than<int64_t>(0)),
+        tv_count_if(vec, tv_less_than<int64_t>(0), pool)) &&
+        TestSystem::check_exp(true, tv_any_of(vec,
+        tv_equal_to<int64_t>(499), pool)) &&
+        TestSystem::check_exp(false, tv_any_of(vec,
+        tv_greater_than<int64_t>(499), pool)) &&
+        TestSystem::check_exp(static_cast<int64_t>(-500), tv_min(vec, pool)) &&
+        TestSystem::check_exp(static_cast<int64_t>(499), tv_max(vec)) &&
+        TestSystem::check_exp(sum, tv_reduce(vec, static_cast<int64_t>(0),
+        std::plus<int64_t>(), pool)) &&
+        TestSystem::check_exp(squares, tv_transform_reduce(vec,
+        static_cast<int64_t>(0), std::plus<int64_t>(),
+        [](int64_t value) { return value * value; }, pool));
+}
+
+bool tvector_float_sum_is_deterministic() {
+    TVector<float, TGrowth2x> vec;
+    uint64_t seed = 88172645463325252ull;
+
+    for (int i = 0; i < 400000; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        vec.push_back(static_cast<float>(seed % 100000) / 7.0f);
+    }
+
+    float sequential = 0.0f;
+    double exact = 0.0;
+
+    for (float value : vec) {
+        sequential += value;
+        exact += value;
+    }
+
+    TThreadPool one(1);
+    TThreadPool four(4);
+    float chunked = tv_sum(vec, one);
+    float compensated = tv_sum(vec, TSumMode::Compensated, four);
+    double compensated_error = compensated > exact ? compensated - exact :
+        exact - compensated;
+    double sequential_error = sequential > exact ? sequential - exact :
+        exact - sequential;
+
+    return TestSystem::check_exp(chunked, tv_sum(vec, four)) &&
+        TestSystem::check_exp(chunked, tv_sum(vec)) &&
+        TestSystem::check_exp(compensated,
+        tv_sum(vec, TSumMode::Compensated, one)) &&
+        TestSystem::check_exp(sequential,
+        tv_sum(vec, TSumMode::Sequential)) &&
+        TestSystem::check_exp(true, compensated_error <= sequential_error);
+}
+
+bool tvector_reduce_seeds_chunks_past_empty_words() {
+    TVector<int64_t, TGrowth2x> vec;
+    const int64_t count = 3 * 65536;
+
+    for (int64_t i = 0; i < count; i++) {
+        vec.push_back(i);
+    }
+
+    // The second chunk starts with three empty words and a partial one,
+    // the third with one busy slot in its last word only.
+    for (int i = 0; i < 200; i++) {
+        vec.erase(vec.begin() + 65536);
+    }
+
+    while (vec.size() > 65536 + (65536 - 200) + 1) {
+        vec.erase(vec.begin() + (65536 - 200));
+    }
+
+    int64_t sum = 0;
+
+    for (int64_t value : vec) {
+        sum += value;
+    }
+
+    TThreadPool pool(2);
+    auto last = [](int64_t, int64_t right) { return right; };
+    auto one = [](int64_t) { return static_cast<int64_t>(1); };
+
+    return TestSystem::check_exp(sum, tv_sum(vec, pool)) &&
+        TestSystem::check_exp(sum, tv_sum(vec)) &&
+        TestSystem::check_exp(static_cast<int64_t>(vec.size()),
+        tv_transform_reduce(vec, static_cast<int64_t>(0),
+        std::plus<int64_t>(), one, pool)) &&
+        TestSystem::check_exp(count - 1, tv_reduce(vec,
+        static_cast<int64_t>(-1), last, pool)) &&
+        TestSystem::check_exp(&tv_default_pool(), &tv_default_pool());
+}
+
+bool tvector_reductions_on_empty_vector() {
+    TVector<int> vec = { 1, 2 };
+    vec.pop_back();
+    vec.pop_back();
+
+    bool min_threw = false;
+
+    try {
+        tv_min(vec);
+    } catch (const std::out_of_range&) {
+        min_threw = true;
+    }
+
+    return TestSystem::check_exp(true, min_threw) &&
+        TestSystem::check_exp(static_cast<size_t>(0),
+        tv_count_if(vec, tv_equal_to(1))) &&
+        TestSystem::check_exp(false, tv_any_of(vec, tv_equal_to(1))) &&
+        TestSystem::check_exp(0, tv_sum(vec)) &&
+        TestSystem::check_exp(7, tv_reduce(vec, 7, std::plus<int>()));
+}
+
+#pragma endregion
+
+#pragma region FrontGapTests
+
+bool tvector_push_front_builds_reversed_vector() {
+    TVector<int> vec;
+    const int count = 100000;
+
+    for (int i = 0; i < count; i++) {
+        vec.push_front(i);
+    }
+
+    bool ordered = true;
+    int expected = count - 1;
+
+    for (int value : vec) {
+        ordered = ordered && value == expected--;
+    }
+
+    TDenseView<int> view = vec.dense_view();
+
+    return TestSystem::check_exp(true, ordered) &&
+        TestSystem::check_exp(static_cast<size_t>(count), vec.size()) &&
+        TestSystem::check_exp(count - 1, vec.front()) &&
+        TestSystem::check_exp(0, vec.back()) &&
+        TestSystem::check_exp(count - 501, vec[500]) &&
+        TestSystem::check_exp(static_cast<size_t>(count), view.size()) &&
+        TestSystem::check_exp(count - 1, view[0]) &&
+        TestSystem::check_exp(true, vec.capacity() < 3 * count);
+}
+
+bool tvector_front_gap_work_queue() {
+    TVector<std::string> vec;
+    bool fifo = true;
+    int next_out = 0;
+
+    for (int round = 0; round < 2000; round++) {
+        vec.push_front(std::to_string(2 * round));
+        vec.push_front(std::to_string(2 * round + 1));
+
+        fifo = fifo && vec.back() == std::to_string(next_out++);
+        vec.pop_back();
+    }
+
+    size_t queued = vec.size();
+
+    for (int i = 0; i < 100; i++) {
+        vec.pop_front();
+        vec.push_front("again");
+    }
+
+    return TestSystem::check_exp(true, fifo) &&
+        TestSystem::check_exp(static_cast<size_t>(2000), queued) &&
+        TestSystem::check_exp(queued, vec.size()) &&
+        TestSystem::check_exp(std::string("again"), vec[0]) &&
+        TestSystem::check_exp(std::string("3998"), vec[1]) &&
+        TestSystem::check_exp(true, vec.capacity() < 4 * queued);
+}
+
+bool tvector_iterators_with_front_gap() {
+    TVector<int, TGrowth2x> vec;
+
+    for (int i = 0; i < 10; i++) {
+        vec.push_back(i);
+    }
+
+    for (int i = 1; i <= 5; i++) {
+        vec.push_front(-i);
+    }
+
+    TVector<int, TGrowth2x>::Iterator first = vec.begin();
+    --first;
+    int first_value = *first;
+    int last_value = *(vec.end() - 1);
+    int distance = vec.end() - vec.begin();
+
+    vec.insert(vec.begin() + 5, 100);
+    vec.erase(vec.begin() + 1);
+
+    TVector<int, TGrowth2x> copy(vec);
+    TVector<int, TGrowth2x> assigned;
+    assigned = copy;
+    tv_sort(assigned);
+
+    return TestSystem::check_exp(15, distance) &&
+        TestSystem::check_exp(-5, first_value) &&
+        TestSystem::check_exp(9, last_value) &&
+        TestSystem::check_exp(static_cast<size_t>(15), vec.size()) &&
+        TestSystem::check_exp(-3, vec[1]) &&
+        TestSystem::check_exp(100, vec[4]) &&
+        TestSystem::check_exp(0, vec[5]) &&
+        TestSystem::check_exp(true, copy == vec) &&
+        TestSystem::check_exp(-5, assigned[0]) &&
+        TestSystem::check_exp(100, assigned[14]);
+}
+
+#pragma endregion
+
+#pragma region RingBufferTests
+
+bool tvector_ring_buffer_keeps_last_events() {
+    TRingBuffer<int> ring(5);
+
+    for (int i = 0; i < 13; i++) {
+        ring.push_back(i);
+    }
+
+    int busy = 0;
+
+    for (size_t i = 0; i < ring.capacity(); i++) {
+        busy += ring.states()[i] == Busy;
+    }
+
+    TDenseView<int> first = ring.first_run();
+    TDenseView<int> second = ring.second_run();
+    int expected = 8;
+    bool ordered = first.size() + second.size() == 5;
+
+    for (int value : first) {
+        ordered = ordered && value == expected++;
+    }
+
+    for (int value : second) {
+        ordered = ordered && value == expected++;
+    }
+
+    ring.push_back(ring.front());
+
+    return TestSystem::check_exp(static_cast<size_t>(5), ring.size()) &&
+        TestSystem::check_exp(static_cast<size_t>(5), ring.capacity()) &&
+        TestSystem::check_exp(5, busy) &&
+        TestSystem::check_exp(true, ordered) &&
+        TestSystem::check_exp(9, ring.front()) &&
+        TestSystem::check_exp(8, ring.back()) &&
+        TestSystem::check_exp(12, ring[3]);
+}
+
+bool tvector_ring_buffer_rejects_when_full() {
+    TRingBuffer<int> ring(3, TOverflow::Reject);
+    bool accepted = ring.push_back(1) && ring.push_back(2) &&
+        ring.push_back(3);
+    bool rejected = !ring.push_back(4);
+
+    ring.pop_front();
+    ring.push_back(5);
+    ring.pop_front();
+    ring.pop_front();
+    ring.pop_front();
+
+    bool pop_threw = false;
+    bool index_threw = false;
+
+    try {
+        ring.pop_front();
+    } catch (const std::runtime_error&) {
+        pop_threw = true;
+    }
+
+    try {
+        ring[0];
+    } catch (const std::out_of_range&) {
+        index_threw = true;
+    }
+
+    return TestSystem::check_exp(true, accepted) &&
+        TestSystem::check_exp(true, rejected) &&
+        TestSystem::check_exp(true, ring.is_empty()) &&
+        TestSystem::check_exp(true, pop_threw) &&
+        TestSystem::check_exp(true, index_threw);
+}
+
+bool tvector_ring_buffer_grows_as_a_queue() {
+    LiveCounter::alive = 0;
+    bool result = true;
+
+    {
+        TRingBuffer<LiveCounter> ring;
+        int next_out = 0;
+
+        for (int i = 0; i < 1000; i++) {
+            ring.push_back(LiveCounter(i));
+
+            if (i % 3 == 0) {
+                result = result && ring.front().value == next_out++;
+                ring.pop_front();
+            }
+        }
+
+        TRingBuffer<LiveCounter> copy(ring);
+        TRingBuffer<LiveCounter> moved(std::move(copy));
+        int expected = next_out;
+
+        for (const LiveCounter& counter : moved) {
+            result = result && counter.value == expected++;
+        }
+
+        result = result && TestSystem::check_exp(1000, expected) &&
+            TestSystem::check_exp(static_cast<int>(2 * ring.size()),
+            LiveCounter::alive);
+
+        ring.clear();
+        result = result && TestSystem::check_exp(static_cast<int>(
+            moved.size()), LiveCounter::alive);
+    }
+
+    return result && TestSystem::check_exp(0, LiveCounter::alive);
+}
+
+bool tvector_ring_buffer_growth_keeps_elements_on_throw() {
+    ThrowingCopy::alive = 0;
+    bool threw = false;
+    bool kept = true;
+
+    {
+        TRingBuffer<ThrowingCopy> ring(4, TOverflow::Grow);
+
+        ring.push_back(ThrowingCopy(0));
+        ring.pop_front();
+
+        for (int i = 1; i <= 4; i++) {
+            ring.push_back(ThrowingCopy(i));
+        }
+
+        ring[2].value = -1;
+
+        try {
+            ring.push_back(ThrowingCopy(5));
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+
+        int expected[] = { 1, 2, -1, 4 };
+
+        for (size_t i = 0; i < 4; i++) {
+            kept = kept && ring[i].value == expected[i];
+        }
+
+        kept = kept && ring.size() == 4 && ring.capacity() == 4 &&
+            ThrowingCopy::alive == 4;
+    }
+
+    return TestSystem::check_exp(true, threw) &&
+        TestSystem::check_exp(true, kept) &&
+        TestSystem::check_exp(0, ThrowingCopy::alive);
+}
+
+#pragma endregion
+
+#pragma region IncrementalCompactionTests
+
+bool tvector_incremental_compaction_keeps_order() {
+    TVector<int, TGrowth2x> vec;
+    std::vector<int> model;
+    vec.set_incremental_compaction(4);
+    unsigned seed = 12345;
+    bool same = true;
+
+    for (int i = 0; i < 4000; i++) {
+        vec.push_back(i);
+        model.push_back(i);
+    }
+
+    for (int op = 0; op < 20000; op++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned pick = (seed >> 16) % 8;
+        int k = model.empty() ? 0 : static_cast<int>(seed % model.size());
+
+        if (pick < 3 && !model.empty()) {
+            vec.erase(vec.begin() + k);
+            model.erase(model.begin() + k);
+        } else if (pick == 3 && !model.empty()) {
+            vec.pop_front();
+            model.erase(model.begin());
+        } else if (pick == 4 && !model.empty()) {
+            vec.pop_back();
+            model.pop_back();
+        } else if (pick == 5) {
+            vec.push_front(-op);
+            model.insert(model.begin(), -op);
+        } else {
+            vec.push_back(op);
+            model.push_back(op);
+        }
+
+        if (op % 97 == 0) {
+            size_t index = 0;
+
+            for (int value : vec) {
+                same = same && index < model.size() && model[index] == value;
+                index++;
+            }
+
+            same = same && index == model.size();
+        }
+    }
+
+    bool indexed = true;
+
+    for (size_t i = 0; i < model.size(); i += 13) {
+        indexed = indexed && vec[i] == model[i];
+    }
+
+    return TestSystem::check_exp(true, same) &&
+        TestSystem::check_exp(true, indexed) &&
+        TestSystem::check_exp(model.size(), vec.size());
+}
+
+bool tvector_compact_step_runs_when_ticked() {
+    TVector<int, TGrowth2x> vec;
+    vec.set_incremental_compaction(1);
+
+    for (int i = 0; i < 10000; i++) {
+        vec.push_back(i);
+    }
+
+    int* data = vec.data();
+    size_t capacity = vec.capacity();
+
+    for (int i = 0; i < 3000; i++) {
+        vec.erase(vec.begin() + i);
+    }
+
+    bool lazy = !vec.is_dense() && vec.used() > vec.size();
+    int ticks = 0;
+
+    while (vec.compact_step(256)) {
+        ticks++;
+    }
+
+    bool ordered = true;
+
+    for (size_t i = 0; i < 3000; i++) {
+        ordered = ordered && vec[i] == static_cast<int>(2 * i + 1);
+    }
+
+    for (size_t i = 3000; i < vec.size(); i++) {
+        ordered = ordered && vec[i] == static_cast<int>(i + 3000);
+    }
+
+    return TestSystem::check_exp(true, lazy) &&
+        TestSystem::check_exp(true, ticks > 0) &&
+        TestSystem::check_exp(true, vec.is_dense()) &&
+        TestSystem::check_exp(vec.size(), vec.dense_view().size()) &&
+        TestSystem::check_exp(true, ordered) &&
+        TestSystem::check_exp(data, vec.data()) &&
+        TestSystem::check_exp(capacity, vec.capacity()) &&
+        TestSystem::check_exp(false, vec.compact_step(256));
+}
+
+bool tvector_incremental_compaction_destroys_once() {
+    LiveCounter::alive = 0;
+    bool balanced = true;
+
+    {
+        TVector<LiveCounter, TGrowth2x> vec;
+        vec.set_incremental_compaction(2);
+
+        for (int i = 0; i < 2000; i++) {
+            vec.push_back(LiveCounter(i));
+        }
+
+        for (int i = 0; i < 1500; i++) {
+            if (i % 3 == 0)
+                vec.pop_front();
+            else
+                vec.erase(vec.begin() + (i % static_cast<int>(vec.size())));
+
+            balanced = balanced &&
+                LiveCounter::alive == static_cast<int>(vec.size());
+        }
+
+        while (vec.compact_step(64)) {}
+
+        balanced = balanced &&
+            LiveCounter::alive == static_cast<int>(vec.size()) &&
+            vec.is_dense() && vec.dense_view().size() == vec.size();
+    }
+
+    return TestSystem::check_exp(true, balanced) &&
+        TestSystem::check_exp(0, LiveCounter::alive);
+}
+
+#pragma endregion
+
+#pragma region InPlaceCompactionTests
+
+bool tvector_compaction_keeps_geometric_buffer() {
+    TVector<int, TGrowth2x> vec;
+
+    for (int i = 0; i < 1000; i++) {
+        vec.push_back(i);
+    }
+
+    int* data = vec.data();
+    size_t capacity = vec.capacity();
+
+    for (int i = 0; i < 300; i++) {
+        vec.erase(vec.begin() + i);
+    }
+
+    bool ordered = true;
+
+    for (size_t i = 0; i < vec.size(); i++) {
+        ordered = ordered &&
+            vec[i] == static_cast<int>(i < 300 ? 2 * i + 1 : i + 300);
+    }
+
+    return TestSystem::check_exp(static_cast<size_t>(700), vec.size()) &&
+        TestSystem::check_exp(true, ordered) &&
+        TestSystem::check_exp(data, vec.data()) &&
+        TestSystem::check_exp(capacity, vec.capacity());
+}
+
+bool tvector_compaction_shrinks_when_mostly_empty() {
+    TVector<int, TGrowth2x> vec;
+
+    for (int i = 0; i < 1024; i++) {
+        vec.push_back(i);
+    }
+
+    size_t capacity = vec.capacity();
+
+    while (vec.size() > 100) {
+        vec.pop_back();
+    }
+
+    return TestSystem::check_exp(true, vec.capacity() < capacity) &&
+        TestSystem::check_exp(true, vec.capacity() >= vec.size()) &&
+        TestSystem::check_exp(99, vec.back()) &&
+        TestSystem::check_exp(50, vec[50]);
+}
+
+struct TKeepCapacity : TGrowth2x {
+    static size_t shrink_capacity(size_t current, size_t, size_t) noexcept {
+        return current;
+    }
+};
+
+bool tvector_shrink_policy_keeps_capacity() {
+    LiveCounter::alive = 0;
+    bool values = true;
+    size_t capacity = 0;
+    size_t left_capacity = 0;
+
+    {
+        TVector<LiveCounter, TKeepCapacity> vec;
+
+        for (int i = 0; i < 500; i++) {
+            vec.push_back(LiveCounter(i));
+        }
+
+        capacity = vec.capacity();
+
+        for (int i = 0; i < 490; i++) {
+            if (i % 2 == 0)
+                vec.pop_front();
+            else
+                vec.pop_back();
+        }
+
+        for (size_t i = 0; i < vec.size(); i++) {
+            values = values && vec[i].value == static_cast<int>(245 + i);
+        }
+
+        values = values && LiveCounter::alive == 10;
+        left_capacity = vec.capacity();
+    }
+
+    return TestSystem::check_exp(true, values) &&
+        TestSystem::check_exp(capacity, left_capacity) &&
+        TestSystem::check_exp(0, LiveCounter::alive);
+}
+
+#pragma endregion
+
+#pragma region CompactionPolicyTests
+
+bool tvector_never_policy_waits_for_compact() {
+    TVector<int, TGrowth2x> vec;
+    std::vector<TCompactionEvent> events;
+    vec.set_compaction_policy(TCompactionPolicy::never());
+    vec.set_compaction_hook([&events](const TCompactionEvent& event) {
+        events.push_back(event);
+    });
+
+    for (int i = 0; i < 1000; i++) {
+        vec.push_back(i);
+    }
+
+    for (int i = 0; i < 500; i++) {
+        vec.erase(vec.begin() + i);
+    }
+
+    size_t used = vec.used();
+    vec.compact();
+    vec.compact();
+
+    return TestSystem::check_exp(static_cast<size_t>(1000), used) &&
+        TestSystem::check_exp(static_cast<size_t>(1), events.size()) &&
+        TestSystem::check_exp(static_cast<size_t>(500), events[0].tombstones) &&
+        TestSystem::check_exp(static_cast<size_t>(500), events[0].size) &&
+        TestSystem::check_exp(true, events[0].manual) &&
+        TestSystem::check_exp(true, vec.is_dense()) &&
+        TestSystem::check_exp(999, vec.back());
+}
+
+bool tvector_byte_budget_policy() {
+    TVector<int64_t, TGrowth2x> vec;
+    std::vector<size_t> removed;
+    vec.set_compaction_policy(TCompactionPolicy::byte_budget(800));
+    vec.set_compaction_hook([&removed](const TCompactionEvent& event) {
+        removed.push_back(event.manual ? 0 : event.tombstones);
+    });
+
+    for (int64_t i = 0; i < 10000; i++) {
+        vec.push_back(i);
+    }
+
+    for (int i = 0; i < 350; i++) {
+        vec.erase(vec.begin() + 7 * i);
+    }
+
+    bool all_budgeted = true;
+
+    for (size_t count : removed) {
+        all_budgeted = all_budgeted && count == 100;
+    }
+
+    return TestSystem::check_exp(static_cast<size_t>(3), removed.size()) &&
+        TestSystem::check_exp(true, all_budgeted) &&
+        TestSystem::check_exp(static_cast<size_t>(9650), vec.size()) &&
+        TestSystem::check_exp(static_cast<int64_t>(1), vec[0]);
+}
+
+bool tvector_threshold_and_interval_policies() {
+    size_t eager_tombstones = 0;
+    size_t interval_tombstones = 0;
+    TVector<int, TGrowth2x> eager;
+    TVector<int, TGrowth2x> timed;
+    eager.set_compaction_policy(TCompactionPolicy::threshold(10));
+    timed.set_compaction_policy(
+        TCompactionPolicy::interval(std::chrono::milliseconds(0)));
+    eager.set_compaction_hook([&eager_tombstones](const TCompactionEvent& e) {
+        eager_tombstones = e.tombstones;
+    });
+    timed.set_compaction_hook(
+        [&interval_tombstones](const TCompactionEvent& e) {
+        interval_tombstones = e.tombstones;
+    });
+
+    for (int i = 0; i < 1000; i++) {
+        eager.push_back(i);
+        timed.push_back(i);
+    }
+
+    for (int i = 0; i < 100; i++) {
+        eager.erase(eager.begin() + 2 * i);
+        timed.erase(timed.begin() + 2 * i);
+    }
+
+    bool timed_kind =
+        timed.compaction_policy().kind() == TCompactionPolicy::Kind::Interval;
+
+    return TestSystem::check_exp(true, timed_kind) &&
+        TestSystem::check_exp(static_cast<size_t>(10), eager_tombstones) &&
+        TestSystem::check_exp(static_cast<size_t>(64), interval_tombstones) &&
+        TestSystem::check_exp(true, eager.is_dense()) &&
+        TestSystem::check_exp(false, timed.is_dense()) &&
+        TestSystem::check_exp(static_cast<size_t>(900), timed.size());
+}
+
+bool tvector_interval_policy_counts_bulk_erases() {
+    std::vector<size_t> compacted;
+    TVector<int, TGrowth2x> vec;
+    vec.set_compaction_policy(
+        TCompactionPolicy::interval(std::chrono::milliseconds(0)));
+    vec.set_compaction_hook([&compacted](const TCompactionEvent& e) {
+        compacted.push_back(e.tombstones);
+    });
+
+    for (int i = 0; i < 1000; i++) {
+        vec.push_back(i);
+    }
+
+    // 50 tombstones a call never lands on a multiple of 64 before 1600.
+    for (int i = 0; i < 6; i++) {
+        vec.erase(vec.begin() + 1, vec.begin() + 51);
+    }
+
+    return TestSystem::check_exp(static_cast<size_t>(3), compacted.size()) &&
+        TestSystem::check_exp(static_cast<size_t>(100), compacted[0]) &&
+        TestSystem::check_exp(static_cast<size_t>(700), vec.size()) &&
+        TestSystem::check_exp(true, vec.is_dense()) &&
+        TestSystem::check_exp(301, vec[1]);
+}
+
+bool tvector_compaction_settings_move_with_vector() {
+    std::vector<TCompactionEvent> events;
+    TVector<int, TGrowth2x> source;
+    source.set_compaction_policy(TCompactionPolicy::never());
+    source.set_compaction_hook([&events](const TCompactionEvent& event) {
+        events.push_back(event);
+    });
+
+    for (int i = 0; i < 1000; i++) {
+        source.push_back(i);
+    }
+
+    TVector<int, TGrowth2x> moved(std::move(source));
+    TVector<int, TGrowth2x> vec;
+    vec = std::move(moved);
+
+    for (int i = 0; i < 500; i++) {
+        vec.erase(vec.begin() + i);
+    }
+
+    size_t used = vec.used();
+    vec.compact();
+
+    // The moved-from vector is back on the default policy, without a hook.
+    for (int i = 0; i < 1000; i++) {
+        source.push_back(i);
+    }
+
+    for (int i = 0; i < 200; i++) {
+        source.erase(source.begin() + i);
+    }
+
+    bool source_threshold = source.compaction_policy().kind() ==
+        TCompactionPolicy::Kind::Threshold;
+
+    return TestSystem::check_exp(static_cast<size_t>(1000), used) &&
+        TestSystem::check_exp(static_cast<size_t>(1), events.size()) &&
+        TestSystem::check_exp(static_cast<size_t>(500), events[0].tombstones) &&
+        TestSystem::check_exp(true, source_threshold) &&
+        TestSystem::check_exp(true, source.used() < 1000) &&
+        TestSystem::check_exp(static_cast<size_t>(800), source.size());
+}
+
+#pragma endregion
+
+#pragma region BackgroundCompactionTests
+
+bool tvector_background_compaction_matches_model() {
+    TThreadPool pool(1);
+    TVector<int, TGrowth2x> vec;
+    const TVector<int, TGrowth2x>& view = vec;
+    std::vector<int> model;
+    size_t published = 0;
+    unsigned seed = 99;
+    bool same = true;
+    vec.set_background_compaction(&pool);
+    vec.set_compaction_hook([&published](const TCompactionEvent&) {
+        published++;
+    });
+
+    for (int i = 0; i < 20000; i++) {
+        vec.push_back(i);
+        model.push_back(i);
+    }
+
+    for (int op = 0; op < 100000; op++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned pick = (seed >> 16) % 6;
+        size_t k = model.empty() ? 0 : seed % model.size();
+
+        if (pick < 2 && !model.empty()) {
+            vec.erase(vec.begin() + static_cast<int>(k));
+            model.erase(model.begin() + k);
+        } else if (pick == 2 && !model.empty()) {
+            vec.pop_front();
+            model.erase(model.begin());
+        } else if (pick == 3 && !model.empty()) {
+            vec.pop_back();
+            model.pop_back();
+        } else {
+            vec.push_back(op);
+            model.push_back(op);
+        }
+
+        if (op % 997 == 0) {
+            size_t index = 0;
+
+            for (auto it = view.begin(); it != view.end(); ++it) {
+                same = same && index < model.size() && model[index] == *it;
+                index++;
+            }
+
+            same = same && index == model.size() && view.size() == index;
+        }
+    }
+
+    vec.set_background_compaction(nullptr);
+    vec.compact();
+
+    bool indexed = true;
+
+    for (size_t i = 0; i < model.size(); i += 7) {
+        indexed = indexed && vec[i] == model[i];
+    }
+
+    return TestSystem::check_exp(true, same) &&
+        TestSystem::check_exp(true, indexed) &&
+        TestSystem::check_exp(true, published > 0) &&
+        TestSystem::check_exp(model.size(), vec.size());
+}
+
+// LiveCounter for elements destroyed on the pool.
+struct SharedCounter {
+    static std::atomic<int> alive;
+    int value;
+
+    explicit SharedCounter(int v) : value(v) { alive++; }
+    SharedCounter(const SharedCounter& other) : value(other.value) {
+        alive++;
+    }
+    SharedCounter& operator=(const SharedCounter&) = default;
+    ~SharedCounter() { alive--; }
+};
+
+std::atomic<int> SharedCounter::alive(0);
+
+bool tvector_background_compaction_cancel_keeps_objects() {
+    bool values = true;
+
+    {
+        TThreadPool pool(1);
+        TVector<SharedCounter, TGrowth2x> vec;
+        vec.set_background_compaction(&pool);
+
+        for (int i = 0; i < 6000; i++) {
+            vec.push_back(SharedCounter(i));
+        }
+
+        for (int round = 0; round < 3000; round++) {
+            vec.erase(vec.begin() + round % static_cast<int>(vec.size()));
+
+            if (round % 50 == 0) {
+                TVector<SharedCounter, TGrowth2x>::Iterator it = vec.begin();
+                values = values && (*it).value >= 0;
+                vec[vec.size() - 1].value = -1;
+                vec.pop_back();
+            }
+
+            if (round % 3 == 0)
+                vec.push_back(SharedCounter(round));
+        }
+
+        for (size_t i = 0; i < vec.size(); i++) {
+            values = values && vec[i].value >= 0;
+        }
+    }
+
+    return TestSystem::check_exp(true, values) &&
+        TestSystem::check_exp(0, SharedCounter::alive.load());
+}
+
+bool tvector_background_appended_writes_keep_copy() {
+    TThreadPool pool(1);
+    TVector<int, TGrowth2x> vec;
+    size_t published = 0;
+    vec.set_background_compaction(&pool);
+    vec.set_compaction_hook([&published](const TCompactionEvent&) {
+        published++;
+    });
+
+    for (int i = 0; i < 1000; i++) {
+        vec.push_back(i);
+    }
+
+    // The 150th tombstone (15% of the slots) hands the copy to the pool.
+    for (int i = 0; i < 150; i++) {
+        vec.erase(vec.begin() + 100);
+    }
+
+    size_t before = published;
+    vec.push_back(-1);
+
+    while (pool.run_one()) {}
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Writes to the appended slot leave the copy running, so the next
+    // pop publishes it.
+    vec.back() = 5;
+    vec[vec.size() - 1] += 1;
+    vec.pop_front();
+
+    return TestSystem::check_exp(static_cast<size_t>(0), before) &&
+        TestSystem::check_exp(static_cast<size_t>(1), published) &&
+        TestSystem::check_exp(6, vec.back()) &&
+        TestSystem::check_exp(250, vec[99]) &&
+        TestSystem::check_exp(static_cast<size_t>(850), vec.size());
+}
+
+bool tvector_background_compaction_moves_with_vector() {
+    TThreadPool pool(1);
+    TVector<int, TGrowth2x> source;
+    source.set_background_compaction(&pool);
+
+    for (int i = 0; i < 1000; i++) {
+        source.push_back(i);
+    }
+
+    TVector<int, TGrowth2x> moved(std::move(source));
+    TVector<int, TGrowth2x> vec;
+    vec = std::move(moved);
+    size_t published = 0;
+    vec.set_compaction_hook([&published](const TCompactionEvent&) {
+        published++;
+    });
+
+    // Inline compaction would report at the 150th erase already.
+    for (int i = 0; i < 150; i++) {
+        vec.erase(vec.begin() + 100);
+    }
+
+    size_t before = published;
+
+    while (pool.run_one()) {}
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    vec.pop_front();
+
+    return TestSystem::check_exp(static_cast<size_t>(0), before) &&
+        TestSystem::check_exp(static_cast<size_t>(1), published) &&
+        TestSystem::check_exp(250, vec[99]) &&
+        TestSystem::check_exp(static_cast<size_t>(849), vec.size());
+}
+
+bool tvector_background_compaction_stress() {
+    TThreadPool pool(1);
+    TVector<int64_t, TGrowth2x> vec;
+    const TVector<int64_t, TGrowth2x>& view = vec;
+    std::shared_timed_mutex mutex;
+    std::atomic<bool> stop(false);
+    std::atomic<int> progress(0);
+    std::atomic<int> bad_reads(0);
+    std::atomic<int> reads(0);
+    vec.set_background_compaction(&pool);
+
+    for (int64_t i = 0; i < 20000; i++) {
+        vec.push_back(2 * i);
+    }
+
+    // The vector is not synchronized, so readers hold the shared lock and
+    // the writer the unique one. Readers take a snapshot every 500
+    // writes, so they cannot starve the writer out of the lock.
+    auto reader = [&]() {
+        int seen = -500;
+
+        while (!stop.load()) {
+            if (progress.load() - seen < 500) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            seen = progress.load();
+            std::shared_lock<std::shared_timed_mutex> lock(mutex);
+            size_t count = 0;
+            bool even = true;
+
+            for (int64_t value : view) {
+                even = even && value % 2 == 0;
+                count++;
+            }
+
+            if (!even || count != view.size())
+                bad_reads++;
+
+            reads++;
+        }
+    };
+
+    std::thread first(reader);
+    std::thread second(reader);
+    unsigned seed = 5;
+
+    for (int op = 0; op < 20000; op++) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        seed = seed * 1103515245u + 12345u;
+        vec.erase(vec.begin() + static_cast<int>(seed % vec.size()));
+        vec.push_back(2 * static_cast<int64_t>(op));
+
+        if (op % 4 == 0)
+            vec.pop_front();
+
+        lock.unlock();
+        progress = op;
+    }
+
+    while (reads.load() < 4) {
+        std::this_thread::yield();
+    }
+
+    stop = true;
+    first.join();
+    second.join();
+
+    return TestSystem::check_exp(0, bad_reads.load()) &&
+        TestSystem::check_exp(static_cast<size_t>(15000), view.size());
+}
+
+#pragma endregion
+
+#pragma region FreeSlotTests
+
+bool tvector_insert_any_fills_tombstones() {
+    TVector<int, TGrowth2x> vec;
+    vec.set_compaction_policy(TCompactionPolicy::never());
+
+    for (int i = 0; i < 1000; i++) {
+        vec.push_back(i);
+    }
+
+    for (size_t slot = 19; slot >= 10; slot--) {
+        vec.erase_slot(slot);
+    }
+
+    size_t capacity = vec.capacity();
+    bool lowest_first = true;
+
+    for (int i = 0; i < 10; i++) {
+        size_t slot = vec.insert_any(5000 + i);
+        lowest_first = lowest_first && slot == static_cast<size_t>(10 + i);
+    }
+
+    size_t appended = vec.insert_any(7);
+    bool thrown = false;
+
+    try {
+        vec.erase_slot(500);
+        vec.at_slot(500);
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+
+    return TestSystem::check_exp(true, lowest_first) &&
+        TestSystem::check_exp(capacity, vec.capacity()) &&
+        TestSystem::check_exp(static_cast<size_t>(1000), appended) &&
+        TestSystem::check_exp(5000, vec.at_slot(10)) &&
+        TestSystem::check_exp(5009, vec.at_slot(19)) &&
+        TestSystem::check_exp(7, vec.at_slot(1000)) &&
+        TestSystem::check_exp(true, thrown) &&
+        TestSystem::check_exp(static_cast<size_t>(1000), vec.size());
+}
+
+bool tvector_insert_any_slots_stay_stable() {
+    TVector<int, TGrowth2x> vec;
+    std::vector<int> model;
+    std::vector<size_t> live;
+    unsigned seed = 7;
+    vec.set_compaction_policy(TCompactionPolicy::never());
+
+    for (int op = 0; op < 50000; op++) {
+        seed = seed * 1103515245u + 12345u;
+
+        if ((seed >> 16) % 5 < 2 && !live.empty()) {
+            size_t pick = (seed >> 8) % live.size();
+            vec.erase_slot(live[pick]);
+            model[live[pick]] = -1;
+            live[pick] = live.back();
+            live.pop_back();
+        } else {
+            size_t slot = vec.insert_any(op);
+
+            if (slot >= model.size())
+                model.resize(slot + 1, -1);
+
+            live.push_back(slot);
+            model[slot] = op;
+        }
+    }
+
+    bool same = true;
+
+    for (size_t slot : live) {
+        same = same && vec.at_slot(slot) == model[slot];
+    }
+
+    return TestSystem::check_exp(true, same) &&
+        TestSystem::check_exp(live.size(), vec.size()) &&
+        TestSystem::check_exp(model.size(), vec.used());
+}
+
+bool tvector_insert_any_cuts_compactions() {
+    size_t appending = 0;
+    size_t filling = 0;
+    TVector<int, TGrowth2x> pushed;
+    TVector<int, TGrowth2x> reused;
+    pushed.set_compaction_hook([&appending](const TCompactionEvent&) {
+        appending++;
+    });
+    reused.set_compaction_hook([&filling](const TCompactionEvent&) {
+        filling++;
+    });
+
+    for (int i = 0; i < 4096; i++) {
+        pushed.push_back(i);
+        reused.push_back(i);
+    }
+
+    size_t capacity = reused.capacity();
+    unsigned seed = 3;
+
+    for (int op = 0; op < 20000; op++) {
+        seed = seed * 1103515245u + 12345u;
+        size_t slot = (seed >> 8) % 4096;
+
+        pushed.erase(pushed.begin() + static_cast<int>(slot));
+        pushed.push_back(op);
+        reused.erase_slot(slot);
+        reused.insert_any(op);
+    }
+
+    return TestSystem::check_exp(true, appending > 0) &&
+        TestSystem::check_exp(static_cast<size_t>(0), filling) &&
+        TestSystem::check_exp(capacity, reused.capacity()) &&
+        TestSystem::check_exp(true, reused.is_dense()) &&
+        TestSystem::check_exp(pushed.size(), reused.size());
+}
+
+#pragma endregion
+
+#pragma region SlotMapTests
+
+bool tvector_slot_map_handles_go_stale() {
+    TSlotMap<int> map;
+    TSlotMap<int>::handle_type first = map.insert(10);
+    TSlotMap<int>::handle_type second = map.insert(20);
+    bool erased = map.erase(first);
+    bool erased_twice = map.erase(first);
+    TSlotMap<int>::handle_type reused = map.insert(30);
+    bool thrown = false;
+
+    try {
+        map.at(first);
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+
+    return TestSystem::check_exp(true, erased) &&
+        TestSystem::check_exp(false, erased_twice) &&
+        TestSystem::check_exp(true, (reused & 0xffffffffu) ==
+            (first & 0xffffffffu)) &&
+        TestSystem::check_exp(true, reused != first) &&
+        TestSystem::check_exp(false, map.contains(first)) &&
+        TestSystem::check_exp(false,
+            map.contains(TSlotMap<int>::null_handle)) &&
+        TestSystem::check_exp(true, map.find(first) == nullptr) &&
+        TestSystem::check_exp(30, map.at(reused)) &&
+        TestSystem::check_exp(20, *map.find(second)) &&
+        TestSystem::check_exp(true, thrown) &&
+        TestSystem::check_exp(static_cast<size_t>(2), map.size());
+}
+
+bool tvector_slot_map_never_moves_elements() {
+    LiveCounter::alive = 0;
+    bool same = true;
+
+    {
+        TSlotMap<LiveCounter> map;
+        std::vector<TSlotMap<LiveCounter>::handle_type> handles;
+        std::vector<const LiveCounter*> addresses;
+        unsigned seed = 17;
+
+        for (int op = 0; op < 30000; op++) {
+            seed = seed * 1103515245u + 12345u;
+
+            if ((seed >> 16) % 3 == 0 && !handles.empty()) {
+                size_t pick = (seed >> 4) % handles.size();
+                map.erase(handles[pick]);
+                handles[pick] = handles.back();
+                addresses[pick] = addresses.back();
+                handles.pop_back();
+                addresses.pop_back();
+            } else {
+                TSlotMap<LiveCounter>::handle_type handle =
+                    map.emplace(op);
+                handles.push_back(handle);
+                addresses.push_back(map.find(handle));
+            }
+        }
+
+        for (size_t i = 0; i < handles.size(); i++) {
+            same = same && map.find(handles[i]) == addresses[i];
+        }
+
+        same = same && LiveCounter::alive == static_cast<int>(map.size());
+    }
+
+    return TestSystem::check_exp(true, same) &&
+        TestSystem::check_exp(0, LiveCounter::alive);
+}
+
+bool tvector_slot_map_iterates_live_elements() {
+    TSlotMap<int> map;
+    std::vector<TSlotMap<int>::handle_type> handles;
+
+    for (int i = 0; i < 3000; i++) {
+        handles.push_back(map.insert(i));
+    }
+
+    for (int i = 0; i < 3000; i += 3) {
+        map.erase(handles[i]);
+    }
+
+    TSlotMap<int> copy(map);
+    long long sum = 0;
+    size_t visited = 0;
+    bool handles_match = true;
+
+    for (auto it = copy.begin(); it != copy.end(); ++it) {
+        sum += *it;
+        visited++;
+        handles_match = handles_match && *it % 3 != 0 &&
+            handles[*it] == it.handle();
+    }
+
+    map.clear();
+
+    return TestSystem::check_exp(static_cast<size_t>(2000), visited) &&
+        TestSystem::check_exp(3000LL * 2999 / 2 - 3 * 999LL * 1000 / 2, sum) &&
+        TestSystem::check_exp(true, handles_match) &&
+        TestSystem::check_exp(1, copy.at(handles[1])) &&
+        TestSystem::check_exp(false, map.contains(handles[1])) &&
+        TestSystem::check_exp(true, map.begin() == map.end()) &&
+        TestSystem::check_exp(static_cast<size_t>(0), map.size());
+}
+
+// Allocator that stays with its container on move assignment and
+// equals only allocators with the same tag.
+template<typename T>
+struct TaggedAllocator {
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::false_type;
+
+    int tag;
+
+    explicit TaggedAllocator(int t = 0) noexcept : tag(t) {}
+    template<typename U>
+    TaggedAllocator(const TaggedAllocator<U>& other) noexcept
+        : tag(other.tag) {}
+
+    T* allocate(size_t count) {
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* memory, size_t count) noexcept {
+        std::allocator<T>().deallocate(memory, count);
+    }
+
+    template<typename U>
+    bool operator==(const TaggedAllocator<U>& other) const noexcept {
+        return tag == other.tag;
+    }
+
+    template<typename U>
+    bool operator!=(const TaggedAllocator<U>& other) const noexcept {
+        return tag != other.tag;
+    }
+};
+
+bool tvector_slot_map_move_keeps_own_allocator() {
+    using Map = TSlotMap<std::string, TaggedAllocator<std::string>>;
+    Map source{TaggedAllocator<std::string>(1)};
+    Map target{TaggedAllocator<std::string>(2)};
+    Map same{TaggedAllocator<std::string>(2)};
+    std::vector<Map::handle_type> handles;
+
+    for (int i = 0; i < 1500; i++) {
+        handles.push_back(source.insert(std::to_string(i)));
+    }
+
+    source.erase(handles[7]);
+    target.insert("old");
+    target = std::move(source);
+
+    // Unequal tags: copied. Equal tags: the pages are handed over.
+    bool copied = target.get_allocator().tag == 2 &&
+        target.size() == 1499 && !source.is_empty();
+    Map::handle_type kept = target.insert("kept");
+    const std::string* address = target.find(kept);
+    same = std::move(target);
+
+    return TestSystem::check_exp(true, copied) &&
+        TestSystem::check_exp(static_cast<size_t>(1500), same.size()) &&
+        TestSystem::check_exp(std::string("1499"), same.at(handles[1499])) &&
+        TestSystem::check_exp(false, same.contains(handles[7])) &&
+        TestSystem::check_exp(true, same.find(kept) == address) &&
+        TestSystem::check_exp(2, same.get_allocator().tag);
+}
+
+bool tvector_slot_map_failed_page_keeps_map() {
+    using Map = TSlotMap<LiveCounter, BudgetAllocator<LiveCounter>>;
+    LiveCounter::alive = 0;
+    int throws = 0;
+    bool kept = true;
+
+    // The second page takes four allocations: the page and the three
+    // arrays of the larger state map. Budgets 0 to 3 fail each in turn.
+    for (int budget = 0; budget <= 4; budget++) {
+        AllocationBudget::budget = -1;
+        AllocationBudget::live = 0;
+
+        {
+            Map map;
+            std::vector<Map::handle_type> handles;
+
+            for (int i = 0; i < 1024; i++) {
+                handles.push_back(map.insert(LiveCounter(i)));
+            }
+
+            AllocationBudget::budget = budget;
+
+            try {
+                map.insert(LiveCounter(1024));
+            } catch (const std::bad_alloc&) {
+                throws++;
+                kept = kept && map.size() == 1024 &&
+                    map.capacity() == 1024 && LiveCounter::alive == 1024;
+            }
+
+            AllocationBudget::budget = -1;
+
+            for (int i = 0; i < 1024; i++) {
+                kept = kept && map.at(handles[i]).value == i;
+            }
+
+            map.insert(LiveCounter(1025));
+            kept = kept && map.capacity() == 2048;
+        }
+
+        kept = kept && AllocationBudget::live == 0 &&
+            LiveCounter::alive == 0;
+    }
+
+    return TestSystem::check_exp(4, throws) &&
+        TestSystem::check_exp(true, kept);
+}
+
+#pragma endregion
+
+#pragma region BulkRangeTests
+
+bool tvector_range_insert_grows_once() {
+    TVector<int> vec{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    std::vector<int> model{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    std::vector<int> source(1000);
+
+    for (int i = 0; i < 1000; i++) {
+        source[i] = 100 + i;
+    }
+
+    vec.erase(vec.begin() + 2);
+    model.erase(model.begin() + 2);
+    auto first = vec.insert(vec.begin() + 4, source.begin(), source.end());
+    model.insert(model.begin() + 4, source.begin(), source.end());
+    int first_value = *first;
+    size_t capacity = vec.capacity();
+
+    const int tail[] = {-1, -2, -3};
+    vec.append(tail, tail + 3);
+    model.insert(model.end(), tail, tail + 3);
+    vec.insert(vec.begin(), {-10, -20});
+    model.insert(model.begin(), {-10, -20});
+
+    TVector<int> copy;
+    copy.append(vec.begin(), vec.end());
+    bool same = vec.size() == model.size() && copy.size() == model.size();
+
+    for (size_t i = 0; same && i < model.size(); i++) {
+        same = vec[i] == model[i] && copy[i] == model[i];
+    }
+
+    return TestSystem::check_exp(100, first_value) &&
+        TestSystem::check_exp(static_cast<size_t>(1020), capacity) &&
+        TestSystem::check_exp(true, same) &&
+        TestSystem::check_exp(true, vec.is_dense());
+}
+
+bool tvector_range_insert_moves_and_reads_once() {
+    std::vector<std::string> words{"alpha", "beta", "gamma", "delta"};
+    TVector<std::string, TGrowth2x> vec;
+    vec.push_back("first");
+    vec.push_back("last");
+
+    vec.insert(vec.begin() + 1, std::make_move_iterator(words.begin()),
+        std::make_move_iterator(words.end()));
+
+    std::istringstream input("7 8 9");
+    TVector<int, TGrowth2x> numbers{1, 2};
+    numbers.insert(numbers.begin() + 1, std::istream_iterator<int>(input),
+        std::istream_iterator<int>());
+
+    return TestSystem::check_exp(static_cast<size_t>(6), vec.size()) &&
+        TestSystem::check_exp(std::string("alpha"), vec[1]) &&
+        TestSystem::check_exp(std::string("delta"), vec[4]) &&
+        TestSystem::check_exp(std::string("last"), vec[5]) &&
+        TestSystem::check_exp(true, words[0].empty()) &&
+        TestSystem::check_exp(static_cast<size_t>(5), numbers.size()) &&
+        TestSystem::check_exp(8, numbers[2]) &&
+        TestSystem::check_exp(2, numbers[4]);
+}
+
+bool tvector_range_assign_reuses_buffer() {
+    TVector<int, TGrowth2x> vec;
+
+    for (int i = 0; i < 100; i++) {
+        vec.push_back(i);
+    }
+
+    vec.erase(vec.begin() + 5);
+    const int* buffer = vec.data();
+    const int small[] = {4, 5, 6};
+    vec.assign(small, small + 3);
+    bool kept = vec.data() == buffer && vec.capacity() == 128;
+
+    std::vector<int> large(1000, 3);
+    vec.assign(large.begin(), large.end());
+
+    bool thrown = false;
+    size_t partial = 0;
+
+    {
+        std::vector<ThrowingCopy> source;
+        source.reserve(4);
+        source.emplace_back(1);
+        source.emplace_back(2);
+        source.emplace_back(-1);
+        source.emplace_back(4);
+        TVector<ThrowingCopy, TGrowth2x> objects;
+
+        try {
+            objects.assign(source.begin(), source.end());
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+
+        partial = objects.size();
+    }
+
+    return TestSystem::check_exp(true, kept) &&
+        TestSystem::check_exp(static_cast<size_t>(1000), vec.size()) &&
+        TestSystem::check_exp(static_cast<size_t>(1000), vec.capacity()) &&
+        TestSystem::check_exp(3, vec[999]) &&
+        TestSystem::check_exp(true, thrown) &&
+        TestSystem::check_exp(static_cast<size_t>(2), partial) &&
+        TestSystem::check_exp(0, ThrowingCopy::alive);
+}
+
+#pragma endregion
+
+#pragma region BulkEraseTests
+
+bool tvector_range_erase_compacts_once() {
+    TVector<int, TGrowth2x> vec;
+    std::vector<size_t> events;
+    vec.set_compaction_hook([&events](const TCompactionEvent& event) {
+        events.push_back(event.tombstones);
+    });
+
+    for (int i = 0; i < 100; i++) {
+        vec.push_back(i);
+    }
+
+    auto next = vec.erase(vec.begin() + 10, vec.begin() + 60);
+    int after = *next;
+    auto none = vec.erase(vec.begin() + 5, vec.begin() + 5);
+    auto tail = vec.erase(vec.begin() + 40, vec.end());
+
+    return TestSystem::check_exp(60, after) &&
+        TestSystem::check_exp(5, *none) &&
+        TestSystem::check_exp(true, tail == vec.end()) &&
+        TestSystem::check_exp(static_cast<size_t>(40), vec.size()) &&
+        TestSystem::check_exp(static_cast<size_t>(2), events.size()) &&
+        TestSystem::check_exp(static_cast<size_t>(50), events[0]) &&
+        TestSystem::check_exp(9, vec[9]) &&
+        TestSystem::check_exp(89, vec[39]);
+}
+
+bool tvector_erase_if_counts_removed() {
+    LiveCounter::alive = 0;
+    size_t removed = 0;
+    size_t compactions = 0;
+    bool odd = true;
+
+    {
+        TVector<LiveCounter, TGrowth2x> vec;
+        vec.set_compaction_hook([&compactions](const TCompactionEvent&) {
+            compactions++;
+        });
+
+        for (int i = 0; i < 10000; i++) {
+            vec.push_back(LiveCounter(i));
+        }
+
+        removed = vec.erase_if([](const LiveCounter& item) {
+            return item.value % 2 == 0;
+        });
+
+        for (size_t i = 0; i < vec.size(); i++) {
+            odd = odd && vec[i].value == static_cast<int>(2 * i + 1);
+        }
+
+        odd = odd && LiveCounter::alive == 5000 &&
+            vec.erase_if([](const LiveCounter&) { return false; }) == 0;
+    }
+
+    return TestSystem::check_exp(static_cast<size_t>(5000), removed) &&
+        TestSystem::check_exp(static_cast<size_t>(1), compactions) &&
+        TestSystem::check_exp(true, odd) &&
+        TestSystem::check_exp(0, LiveCounter::alive);
+}
+
+bool tvector_remove_if_slides_in_one_pass() {
+    TVector<int, TGrowth2x> vec;
+    vec.set_compaction_policy(TCompactionPolicy::never());
+
+    for (int i = 0; i < 1024; i++) {
+        vec.push_back(i);
+    }
+
+    vec.erase(vec.begin() + 1);
+    size_t removed = vec.remove_if([](int value) { return value >= 100; });
+    bool ordered = vec.is_dense() && vec[0] == 0 && vec[1] == 2 &&
+        vec[98] == 99;
+    size_t capacity = vec.capacity();
+
+    bool thrown = false;
+
+    try {
+        vec.remove_if([](int value) {
+            if (value == 50)
+                throw std::runtime_error("predicate");
+
+            return value % 2 == 0;
+        });
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+
+    bool kept = vec.size() == 74 && vec[0] == 3 && vec[23] == 49 &&
+        vec[24] == 50 && vec[73] == 99;
+
+    return TestSystem::check_exp(static_cast<size_t>(924), removed) &&
+        TestSystem::check_exp(true, ordered) &&
+        TestSystem::check_exp(static_cast<size_t>(198), capacity) &&
+        TestSystem::check_exp(true, thrown) &&
+        TestSystem::check_exp(true, kept);
+}
+
+#pragma endregion
+
+int main() {
+    TestSystem::print_init_info();
+    TestSystem::start_test(tvector_default_init, "default_init");
+    TestSystem::start_test(tvector_size_init, "size_init");
+    TestSystem::start_test(tvector_copy_init, "copy_init");
+    TestSystem::start_test(tvector_move_init, "move_init");
+    TestSystem::start_test(tvector_array_init, "array_init");
+    TestSystem::start_test(tvector_initialize_list_init,
+        "initialize_list_init");
+
+    TestSystem::start_test(tvector_operator_copy_assign,
+        "operator_copy_assign");
+    TestSystem::start_test(tvector_operator_move_assign,
+        "operator_move_assign");
+    TestSystem::start_test(tvector_operator_equality, "operator_equality");
+    TestSystem::start_test(tvector_operator_inequality, "operator_inequality");
+    TestSystem::start_test(tvector_operator_index_access,
+        "operator_index_access");
+    TestSystem::start_test(tvector_operator_index_access_exception,
+        "operator_index_access_exception");
+    TestSystem::start_test(tvector_const_operator_index_access,
+        "const_operator_index_access");
+    TestSystem::start_test(tvector_const_operator_index_access_exception,
+        "const_operator_index_access_exception");
+
+    TestSystem::start_test(tvector_data, "get_data");
+    TestSystem::start_test(tvector_const_data, "get_const_data");
+    TestSystem::start_test(tvector_size, "get_size");
+    TestSystem::start_test(tvector_capacity, "get_capacity");
+    TestSystem::start_test(tvector_front, "get_front");
+    TestSystem::start_test(tvector_back, "get_back");
+    TestSystem::start_test(tvector_begin, "begin");
+    TestSystem::start_test(tvector_end, "end");
+
+    TestSystem::start_test(tvector_iterator_init, "iterator_init");
+    TestSystem::start_test(tvector_iterator_dereference_operator,
+        "iterator_dereference_operator");
+    TestSystem::start_test(tvector_iterator_dereference_operator_empty,
+        "iterator_dereference_operator_empty");
+    TestSystem::start_test(tvector_iterator_dereference_operator_out_of_range,
+        "iterator_dereference_operator_out_of_range");
+    TestSystem::start_test(tvector_iterator_arrow_operator, "iterator_arrow");
+    TestSystem::start_test(tvector_iterator_assign, "iterator_assign");
+    TestSystem::start_test(tvector_iterator_assign_across_vectors,
+     "iterator_assign_across_vectors");
+    TestSystem::start_test(tvector_iterator_right_increment,
+        "iterator_right_increment");
+    TestSystem::start_test(tvector_iterator_left_increment,
+        "iterator_left_increment");
+    TestSystem::start_test(tvector_iterator_right_decrement,
+        "iterator_right_decrement");
+    TestSystem::start_test(tvector_iterator_left_decrement,
+        "iterator_left_decrement");
+    TestSystem::start_test(tvector_iterator_add, "iterator_add");
+    TestSystem::start_test(tvector_iterator_add_out_off_range_exception,
+        "insert_add_out_off_range_exception");
+    TestSystem::start_test(tvector_iterator_sub, "iterator_sub");
+    TestSystem::start_test(tvector_iterator_sub_out_off_range_exception,
+        "insert_sub_out_off_range_exception");
+    TestSystem::start_test(tvector_iterator_add_assign, "iterator_add_assign");
+    TestSystem::start_test(tvector_iterator_add_assign_out_off_range_exception,
+        "iterator_add_assign_out_off_range_exception");
+    TestSystem::start_test(tvector_iterator_sub_assign, "iterator_sub_assign");
+    TestSystem::start_test(tvector_iterator_sub_assign_out_off_range_exception,
+        "iterator_sub_assign_out_off_range_exception");
+    TestSystem::start_test(tvector_iterator_operator_equality,
+        "iterator_operator_equality");
+    TestSystem::start_test(tvector_iterator_operator_inequality,
+        "iterator_operator_inequality");
+    TestSystem::start_test(tvector_iterator_operator_iterator_difference,
+        "iterator_operator_iterator_difference");
+
+    TestSystem::start_test(tvector_push_back_copy, "push_back_copy");
+    TestSystem::start_test(tvector_push_back_move, "push_back_move");
+    TestSystem::start_test(tvector_push_front_copy, "push_back_copy");
+    TestSystem::start_test(tvector_push_front_move, "push_back_move");
+    TestSystem::start_test(tvector_insert_elems_copy, "insert_elems_copy");
+    TestSystem::start_test(tvector_insert_copy, "insert_copy");
+    TestSystem::start_test(tvector_insert_move, "insert_move");
+    TestSystem::start_test(tvector_emplace, "emplace");
+    TestSystem::start_test(tvector_pop_back, "pop_back");
+    TestSystem::start_test(tvector_pop_front, "pop_front");
+    TestSystem::start_test(tvector_erase, "erase");
+
+    TestSystem::start_test(tvector_clear, "clear");
+    TestSystem::start_test(tvector_shrink_to_fit, "shrink_to_fit");
+    TestSystem::start_test(tvector_resize_1, "resize_1");
+    TestSystem::start_test(tvector_resize_2, "resize_2");
+    TestSystem::start_test(tvector_resize_3, "resize_3");
+    TestSystem::start_test(tvector_shuffle, "shuffle");
+    TestSystem::start_test(tvector_search_begin, "search_begin");
+    TestSystem::start_test(tvector_search_end, "search_end");
+    TestSystem::start_test(tvector_search_all, "search_all");
+
+    TestSystem::start_test(tvector_test, "test");
+
+    TestSystem::start_test(tvector_push_back_copy, "push_back_copy");
+    TestSystem::start_test(tvector_pop_back, "pop_back");
+    TestSystem::start_test(tvector_erase_empty, "erase_empty");
+    // TestSystem::start_test(tvector_pop_back_large_vector,
+    // "pop_back_large_vector");
+    TestSystem::print_final_info();
+
+    std::cout << "Block of AI generated Tests" << std::endl;
+    TestSystem::start_test(tvector_size_value_init_zero,
+        "size_value_init_zero");
+    TestSystem::start_test(tvector_size_value_init_large,
+        "size_value_init_large");
+    TestSystem::start_test(tvector_self_assignment,
+        "self_assignment");
+    TestSystem::start_test(tvector_assignment_different_sizes,
+        "assignment_different_sizes");
+    TestSystem::start_test(tvector_front_exception, "front_exception");
+    TestSystem::start_test(tvector_back_exception, "back_exception");
+    TestSystem::start_test(tvector_front_back_after_operations,
+        "front_back_after_operations");
+    TestSystem::start_test(tvector_is_empty_true, "is_empty_true");
+    TestSystem::start_test(tvector_is_empty_false, "is_empty_false");
+    TestSystem::start_test(tvector_is_empty_after_clear,
+        "is_empty_after_clear");
+    TestSystem::start_test(tvector_is_empty_after_all_erased,
+        "is_empty_after_all_erased");
+    TestSystem::start_test(tvector_iterator_begin_end_empty,
+        "iterator_begin_end_empty");
+    TestSystem::start_test(tvector_iterator_arithmetic_edge_cases,
+     "iterator_arithmetic_edge_cases");
+    TestSystem::start_test(tvector_iterator_skip_deleted,
+     "iterator_skip_deleted");
+    TestSystem::start_test(tvector_memory_management_stress,
+     "memory_management_stress");
+    TestSystem::start_test(tvector_copy_with_deleted_elements,
+     "copy_with_deleted_elements");
+    TestSystem::start_test(tvector_move_from_empty, "move_from_empty");
+    TestSystem::start_test(tvector_initializer_list_duplicates,
+     "initializer_list_duplicates");
+    TestSystem::start_test(tvector_push_to_full_capacity,
+     "push_to_full_capacity");
+    TestSystem::start_test(tvector_multiple_insertions, "multiple_insertions");
+    TestSystem::start_test(tvector_emplace_construction,
+     "emplace_construction");
+    TestSystem::start_test(tvector_shrink_to_fit_empty, "shrink_to_fit_empty");
+    TestSystem::start_test(tvector_shrink_to_fit_after_deletions,
+     "shrink_to_fit_after_deletions");
+    TestSystem::start_test(tvector_resize_to_zero, "resize_to_zero");
+    TestSystem::start_test(tvector_resize_same_size, "resize_same_size");
+    TestSystem::start_test(tvector_index_access_with_deletions,
+     "index_access_with_deletions");
+    TestSystem::start_test(tvector_const_operations, "const_operations");
+    TestSystem::start_test(tvector_iterator_comparisons,
+     "iterator_comparisons");
+    TestSystem::start_test(tvector_iterator_index_operator,
+     "iterator_index_operator");
+    TestSystem::start_test(tvector_iterator_index_operator_exception,
+     "iterator_index_operator_exception");
+    TestSystem::start_test(tvector_large_operations, "large_operations");
+    TestSystem::start_test(tvector_exception_safety, "exception_safety");
+    TestSystem::start_test(tvector_capacity_management, "capacity_management");
+    TestSystem::start_test(tvector_equality_after_operations,
+     "equality_after_operations");
+    TestSystem::start_test(tvector_search_no_matches, "search_no_matches");
+    TestSystem::start_test(tvector_search_all_match, "search_all_match");
+    TestSystem::start_test(tvector_sort_already_sorted, "sort_already_sorted");
+    TestSystem::start_test(tvector_sort_reverse_order, "sort_reverse_order");
+    TestSystem::start_test(tvector_sort_with_deletions, "sort_with_deletions");
+    TestSystem::start_test(tvector_shuffle_preserves_elements,
+     "shuffle_preserves_elements");
+    TestSystem::start_test(tvector_performance_push_back,
+        "performance_push_back");
+
+    TestSystem::start_test(tvector_const_iterator_begin,
+     "const_iterator_begin");
+    TestSystem::start_test(tvector_const_iterator_end,
+     "const_iterator_end");
+    TestSystem::start_test(tvector_const_iterator_dereference,
+     "tvector_const_iterator_dereference");
+    TestSystem::start_test(tvector_const_iterator_increment,
+     "tvector_const_iterator_increment");
+    TestSystem::start_test(tvector_const_iterator_decrement,
+     "tvector_const_iterator_decrement");
+    TestSystem::start_test(tvector_const_iterator_comparison,
+     "tvector_const_iterator_comparison");
+    TestSystem::start_test(tvector_const_iterator_range_based_for,
+     "tvector_const_iterator_range_based_for");
+    TestSystem::start_test(tvector_const_iterator_after_modification,
+     "tvector_const_iterator_after_modification");
+
+    TestSystem::start_test(tvector_linear_growth_step, "linear_growth_step");
+    TestSystem::start_test(tvector_geometric_growth, "geometric_growth");
+    TestSystem::start_test(tvector_geometric_growth_1_5x,
+     "geometric_growth_1_5x");
+    TestSystem::start_test(tvector_page_growth, "page_growth");
+    TestSystem::start_test(tvector_index_access_after_many_erases,
+     "index_access_after_many_erases");
+    TestSystem::start_test(tvector_index_access_through_pops_and_compaction,
+     "index_access_through_pops_and_compaction");
+    TestSystem::start_test(tvector_states_view, "states_view");
+    TestSystem::start_test(tvector_scans_across_word_boundaries,
+     "scans_across_word_boundaries");
+    TestSystem::start_test(tvector_state_map_reset_fails_cleanly,
+     "state_map_reset_fails_cleanly");
+    TestSystem::start_test(tvector_relocates_strings, "relocates_strings");
+    TestSystem::start_test(tvector_relocates_trivially_copyable_records,
+     "relocates_trivially_copyable_records");
+    TestSystem::start_test(tvector_insert_into_full_vector_with_tombstones,
+     "insert_into_full_vector_with_tombstones");
+    TestSystem::start_test(tvector_spare_slots_hold_no_objects,
+     "spare_slots_hold_no_objects");
+    TestSystem::start_test(tvector_resize_constructs_and_destroys,
+     "resize_constructs_and_destroys");
+    TestSystem::start_test(tvector_sort_and_shuffle_skip_tombstones,
+     "sort_and_shuffle_skip_tombstones");
+    TestSystem::start_test(tvector_arena_allocator, "arena_allocator");
+    TestSystem::start_test(tvector_arena_allocator_filled_constructors,
+     "arena_allocator_filled_constructors");
+    TestSystem::start_test(tvector_pool_allocator_recycles_buffers,
+     "pool_allocator_recycles_buffers");
+    TestSystem::start_test(tvector_huge_page_allocator,
+     "huge_page_allocator");
+    TestSystem::start_test(tvector_allocators_reject_overflowing_counts,
+     "allocators_reject_overflowing_counts");
+    TestSystem::start_test(tvector_iterators_of_equal_vectors_differ,
+     "iterators_of_equal_vectors_differ");
+    TestSystem::start_test(tvector_dense_iterator_arithmetic,
+     "dense_iterator_arithmetic");
+    TestSystem::start_test(tvector_dense_view_compacts_on_demand,
+     "dense_view_compacts_on_demand");
+    TestSystem::start_test(tvector_const_dense_view_needs_dense_vector,
+     "const_dense_view_needs_dense_vector");
+    TestSystem::start_test(tvector_sort_adversarial_patterns,
+     "sort_adversarial_patterns");
+    TestSystem::start_test(tvector_sort_with_callable_comparator,
+     "sort_with_callable_comparator");
+    TestSystem::start_test(tvector_sort_matches_std_sort,
+     "sort_matches_std_sort");
+    TestSystem::start_test(tvector_radix_sort_signed_and_floating,
+     "radix_sort_signed_and_floating");
+    TestSystem::start_test(tvector_radix_sort_by_key_is_stable,
+     "radix_sort_by_key_is_stable");
+    TestSystem::start_test(tvector_radix_sort_with_tombstones,
+     "radix_sort_with_tombstones");
+    TestSystem::start_test(tvector_radix_sort_throwing_key,
+     "radix_sort_throwing_key");
+    TestSystem::start_test(tvector_parallel_sort_matches_serial,
+     "parallel_sort_matches_serial");
+    TestSystem::start_test(tvector_parallel_sort_on_shared_pool,
+     "parallel_sort_on_shared_pool");
+    TestSystem::start_test(tvector_parallel_sort_on_default_pool,
+     "parallel_sort_on_default_pool");
+    TestSystem::start_test(tvector_parallel_sort_rethrows,
+     "parallel_sort_rethrows");
+    TestSystem::start_test(tvector_thread_pool_runs_queued_tasks_on_shutdown,
+     "thread_pool_runs_queued_tasks_on_shutdown");
+    TestSystem::start_test(tvector_stable_sort_keeps_equal_order,
+     "stable_sort_keeps_equal_order");
+    TestSystem::start_test(tvector_nth_element_and_partial_sort,
+     "nth_element_and_partial_sort");
+    TestSystem::start_test(tvector_top_k_leaves_vector_untouched,
+     "top_k_leaves_vector_untouched");
+    TestSystem::start_test(tvector_simd_kernels_match_scalar,
+     "simd_kernels_match_scalar");
+    TestSystem::start_test(tvector_search_with_predicate_skips_tombstones,
+     "search_with_predicate_skips_tombstones");
+    TestSystem::start_test(tvector_search_predicate_on_non_arithmetic,
+     "search_predicate_on_non_arithmetic");
+    TestSystem::start_test(tvector_search_all_is_compact,
+     "search_all_is_compact");
+    TestSystem::start_test(tvector_search_each_streams_matches_in_order,
+     "search_each_streams_matches_in_order");
+    TestSystem::start_test(tvector_search_count_matches_search_all,
+     "search_count_matches_search_all");
+    TestSystem::start_test(tvector_reductions_skip_tombstones,
+     "reductions_skip_tombstones");
+    TestSystem::start_test(tvector_float_sum_is_deterministic,
+     "float_sum_is_deterministic");
+    TestSystem::start_test(tvector_reduce_seeds_chunks_past_empty_words,
+     "reduce_seeds_chunks_past_empty_words");
+    TestSystem::start_test(tvector_reductions_on_empty_vector,
+     "reductions_on_empty_vector");
+    TestSystem::start_test(tvector_push_front_builds_reversed_vector,
+     "push_front_builds_reversed_vector");
+    TestSystem::start_test(tvector_front_gap_work_queue,
+     "front_gap_work_queue");
+    TestSystem::start_test(tvector_iterators_with_front_gap,
+     "iterators_with_front_gap");
+    TestSystem::start_test(tvector_ring_buffer_keeps_last_events,
+     "ring_buffer_keeps_last_events");
+    TestSystem::start_test(tvector_ring_buffer_rejects_when_full,
+     "ring_buffer_rejects_when_full");
+    TestSystem::start_test(tvector_ring_buffer_grows_as_a_queue,
+     "ring_buffer_grows_as_a_queue");
+    TestSystem::start_test(tvector_ring_buffer_growth_keeps_elements_on_throw,
+     "ring_buffer_growth_keeps_elements_on_throw");
+    TestSystem::start_test(tvector_incremental_compaction_keeps_order,
+     "incremental_compaction_keeps_order");
+    TestSystem::start_test(tvector_compact_step_runs_when_ticked,
+     "compact_step_runs_when_ticked");
+    TestSystem::start_test(tvector_incremental_compaction_destroys_once,
+     "incremental_compaction_destroys_once");
+    TestSystem::start_test(tvector_compaction_keeps_geometric_buffer,
+     "compaction_keeps_geometric_buffer");
+    TestSystem::start_test(tvector_compaction_shrinks_when_mostly_empty,
+     "compaction_shrinks_when_mostly_empty");
+    TestSystem::start_test(tvector_shrink_policy_keeps_capacity,
+     "shrink_policy_keeps_capacity");
+    TestSystem::start_test(tvector_never_policy_waits_for_compact,
+     "never_policy_waits_for_compact");
+    TestSystem::start_test(tvector_byte_budget_policy,
+     "byte_budget_policy");
+    TestSystem::start_test(tvector_threshold_and_interval_policies,
+     "threshold_and_interval_policies");
+    TestSystem::start_test(tvector_interval_policy_counts_bulk_erases,
+     "interval_policy_counts_bulk_erases");
+    TestSystem::start_test(tvector_compaction_settings_move_with_vector,
+     "compaction_settings_move_with_vector");
+    TestSystem::start_test(tvector_background_compaction_matches_model,
+     "background_compaction_matches_model");
+    TestSystem::start_test(tvector_background_compaction_cancel_keeps_objects,
+     "background_compaction_cancel_keeps_objects");
+    TestSystem::start_test(tvector_background_appended_writes_keep_copy,
+     "background_appended_writes_keep_copy");
+    TestSystem::start_test(tvector_background_compaction_moves_with_vector,
+     "background_compaction_moves_with_vector");
+    TestSystem::start_test(tvector_background_compaction_stress,
+     "background_compaction_stress");
+    TestSystem::start_test(tvector_insert_any_fills_tombstones,
+     "insert_any_fills_tombstones");
+    TestSystem::start_test(tvector_insert_any_slots_stay_stable,
+     "insert_any_slots_stay_stable");
+    TestSystem::start_test(tvector_insert_any_cuts_compactions,
+     "insert_any_cuts_compactions");
+    TestSystem::start_test(tvector_slot_map_handles_go_stale,
+     "slot_map_handles_go_stale");
+    TestSystem::start_test(tvector_slot_map_never_moves_elements,
+     "slot_map_never_moves_elements");
+    TestSystem::start_test(tvector_slot_map_iterates_live_elements,
+     "slot_map_iterates_live_elements");
+    TestSystem::start_test(tvector_slot_map_failed_page_keeps_map,
+     "slot_map_failed_page_keeps_map");
+    TestSystem::start_test(tvector_slot_map_move_keeps_own_allocator,
+     "slot_map_move_keeps_own_allocator");
+    TestSystem::start_test(tvector_range_insert_grows_once,
+     "range_insert_grows_once");
+    TestSystem::start_test(tvector_range_insert_moves_and_reads_once,
+     "range_insert_moves_and_reads_once");
+    TestSystem::start_test(tvector_range_assign_reuses_buffer,
+     "range_assign_reuses_buffer");
+    TestSystem::start_test(tvector_range_erase_compacts_once,
+     "range_erase_compacts_once");
+    TestSystem::start_test(tvector_erase_if_counts_removed,
+     "erase_if_counts_removed");
+    TestSystem::start_test(tvector_remove_if_slides_in_one_pass,
+     "remove_if_slides_in_one_pass");
 
     TestSystem::print_final_info();
 